@@ -0,0 +1,50 @@
+#include "../src/crc16.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+// Compares the CRC16 kernels on a multi-MB buffer.
+// Usage: crc16_bench [size_mb] [iterations]
+
+typedef uint16_t (*CrcKernel)(uint16_t crc, const uint8_t* data, size_t length);
+
+static double runKernel(const char* name, CrcKernel kernel, const std::vector<uint8_t>& data,
+                        int iterations, uint16_t& result) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        result = kernel(0, data.data(), data.size());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double mbPerSecond = (static_cast<double>(data.size()) * iterations / (1024.0 * 1024.0)) / seconds;
+
+    std::cout << std::left << std::setw(10) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10) << mbPerSecond << " MB/s"
+              << "  crc=0x" << std::hex << std::setw(4) << std::setfill('0') << result
+              << std::dec << std::setfill(' ') << std::endl;
+    return mbPerSecond;
+}
+
+int main(int argc, char** argv) {
+    size_t sizeMb = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 8;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    std::vector<uint8_t> data(sizeMb * 1024 * 1024);
+    srand(1);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(rand());
+    }
+
+    std::cout << "CRC16 over " << sizeMb << " MB, " << iterations << " iterations" << std::endl;
+    uint16_t tableCrc, slicedCrc;
+    double tableSpeed = runKernel("table", Crc16::updateTable, data, iterations, tableCrc);
+    double slicedSpeed = runKernel("slice-8", Crc16::updateSliced, data, iterations, slicedCrc);
+
+    if (tableCrc != slicedCrc) {
+        std::cerr << "Kernel results differ" << std::endl;
+        return -1;
+    }
+    std::cout << "slice-8 speedup: " << std::setprecision(2) << slicedSpeed / tableSpeed << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,579 @@
+// Generated by od_gen from flow_all.eds flow_extra.eds, do not edit
+#pragma once
+
+#include "od_types.hpp"
+
+namespace od {
+constexpr Object<0x1000, 0x00, 0x0007, RO> DeviceType{};  // Device type
+constexpr Object<0x1001, 0x00, 0x0005, RO> ErrorRegister{};  // Error register
+
+namespace PreDefinedErrorField {  // 0x1003
+constexpr uint16_t INDEX = 0x1003;
+constexpr Object<0x1003, 0x00, 0x0005, RW> NumberOfErrors{};  // Number of errors
+constexpr Object<0x1003, 0x01, 0x0007, RO> StandardErrorField{};  // Standard error field
+constexpr Object<0x1003, 0x02, 0x0007, RO> StandardErrorField_2{};  // Standard error field
+constexpr Object<0x1003, 0x03, 0x0007, RO> StandardErrorField_3{};  // Standard error field
+constexpr Object<0x1003, 0x04, 0x0007, RO> StandardErrorField_4{};  // Standard error field
+constexpr Object<0x1003, 0x05, 0x0007, RO> StandardErrorField_5{};  // Standard error field
+constexpr Object<0x1003, 0x06, 0x0007, RO> StandardErrorField_6{};  // Standard error field
+constexpr Object<0x1003, 0x07, 0x0007, RO> StandardErrorField_7{};  // Standard error field
+constexpr Object<0x1003, 0x08, 0x0007, RO> StandardErrorField_8{};  // Standard error field
+constexpr Object<0x1003, 0x09, 0x0007, RO> StandardErrorField_9{};  // Standard error field
+constexpr Object<0x1003, 0x0A, 0x0007, RO> StandardErrorField_A{};  // Standard error field
+}
+constexpr Object<0x1005, 0x00, 0x0007, RW> COBIDSYNCMessage{};  // COB-ID SYNC message
+constexpr Object<0x1006, 0x00, 0x0007, RW> CommunicationCyclePeriod{};  // Communication cycle period
+constexpr Object<0x1007, 0x00, 0x0007, RW> SynchronousWindowLength{};  // Synchronous window length
+constexpr Object<0x1008, 0x00, 0x0009, RO> ManufacturerDeviceName{};  // Manufacturer device name
+constexpr Object<0x1009, 0x00, 0x0009, RO> ManufacturerHardwareVersion{};  // Manufacturer hardware version
+constexpr Object<0x1009, 0x01, 0x0005, RO> HardwareVersionByte1{};  // Hardware version byte 1
+constexpr Object<0x1009, 0x02, 0x0005, RO> HardwareVersionByte2{};  // Hardware version byte 2
+constexpr Object<0x1009, 0x03, 0x0005, RO> HardwareVersionByte3{};  // Hardware version byte 3
+constexpr Object<0x1009, 0x04, 0x0005, RO> HardwareVersionByte4{};  // Hardware version byte 4
+constexpr Object<0x100A, 0x00, 0x0009, RO> ManufacturerSoftwareVersion{};  // Manufacturer software version
+
+namespace StoreParameters {  // 0x1010
+constexpr uint16_t INDEX = 0x1010;
+constexpr Object<0x1010, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1010, 0x01, 0x0007, RW> SaveAllParameters{};  // Save all parameters
+constexpr Object<0x1010, 0x02, 0x0007, RW> SaveCommunicationParameters{};  // Save communication parameters
+constexpr Object<0x1010, 0x03, 0x0007, RW> SaveApplicationAndManufacturerParameters{};  // Save application and manufacturer parameters
+}
+
+namespace RestoreDefaultParameters {  // 0x1011
+constexpr uint16_t INDEX = 0x1011;
+constexpr Object<0x1011, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1011, 0x01, 0x0007, RW> RestoreAllDefaultParameters{};  // Restore all default parameters
+constexpr Object<0x1011, 0x02, 0x0007, RW> RestoreCommunicationDefaultParameters{};  // Restore communication default parameters
+constexpr Object<0x1011, 0x03, 0x0007, RW> RestoreApplicationAndManufacturerDefaultParameters{};  // Restore application and manufacturer default parameters
+}
+constexpr Object<0x1014, 0x00, 0x0007, RW> COBIDEMCY{};  // COB-ID EMCY
+constexpr Object<0x1015, 0x00, 0x0006, RW> InhibitTimeEMCY{};  // Inhibit time EMCY
+
+namespace ConsumerHeartbeatTime {  // 0x1016
+constexpr uint16_t INDEX = 0x1016;
+constexpr Object<0x1016, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1016, 0x01, 0x0007, RW> ConsumerHeartbeatTime{};  // Consumer heartbeat time
+constexpr Object<0x1016, 0x02, 0x0007, RW> ConsumerHeartbeatTime_2{};  // Consumer heartbeat time
+constexpr Object<0x1016, 0x03, 0x0007, RW> ConsumerHeartbeatTime_3{};  // Consumer heartbeat time
+constexpr Object<0x1016, 0x04, 0x0007, RW> ConsumerHeartbeatTime_4{};  // Consumer heartbeat time
+}
+constexpr Object<0x1017, 0x00, 0x0006, RW> ProducerHeartbeatTime{};  // Producer heartbeat time
+
+namespace Identity {  // 0x1018
+constexpr uint16_t INDEX = 0x1018;
+constexpr Object<0x1018, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1018, 0x01, 0x0007, RO> VendorID{};  // Vendor-ID
+constexpr Object<0x1018, 0x02, 0x0007, RO> ProductCode{};  // Product code
+constexpr Object<0x1018, 0x03, 0x0007, RO> RevisionNumber{};  // Revision number
+constexpr Object<0x1018, 0x04, 0x0007, RO> SerialNumber{};  // Serial number
+}
+constexpr Object<0x1019, 0x00, 0x0005, RW> SynchronousCounterOverflowValue{};  // Synchronous counter overflow value
+
+namespace ErrorBehaviorObject {  // 0x1029
+constexpr uint16_t INDEX = 0x1029;
+constexpr Object<0x1029, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1029, 0x01, 0x0005, RW> CommunicationError{};  // Communication error
+constexpr Object<0x1029, 0x02, 0x0005, RW> ProfileOrManufacturerSpecificError{};  // Profile- or manufacturer-specific error
+}
+
+namespace SDOServerParameter {  // 0x1200
+constexpr uint16_t INDEX = 0x1200;
+constexpr Object<0x1200, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1200, 0x01, 0x0007, RO> COBIDClientToServerRx{};  // COB-ID client to server (rx)
+constexpr Object<0x1200, 0x02, 0x0007, RO> COBIDServerToClientTx{};  // COB-ID server to client (tx)
+}
+
+namespace RPDOCommunicationParameter {  // 0x1400
+constexpr uint16_t INDEX = 0x1400;
+constexpr Object<0x1400, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1400, 0x01, 0x0007, RW> COBIDUsedByRPDO{};  // COB-ID used by RPDO
+constexpr Object<0x1400, 0x02, 0x0005, RW> TransmissionType{};  // Transmission type
+constexpr Object<0x1400, 0x05, 0x0006, RW> EventTimer{};  // Event timer
+}
+
+namespace RPDOCommunicationParameter_1401 {  // 0x1401
+constexpr uint16_t INDEX = 0x1401;
+constexpr Object<0x1401, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1401, 0x01, 0x0007, RW> COBIDUsedByRPDO{};  // COB-ID used by RPDO
+constexpr Object<0x1401, 0x02, 0x0005, RW> TransmissionType{};  // Transmission type
+constexpr Object<0x1401, 0x05, 0x0006, RW> EventTimer{};  // Event timer
+}
+
+namespace RPDOCommunicationParameter_1402 {  // 0x1402
+constexpr uint16_t INDEX = 0x1402;
+constexpr Object<0x1402, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1402, 0x01, 0x0007, RW> COBIDUsedByRPDO{};  // COB-ID used by RPDO
+constexpr Object<0x1402, 0x02, 0x0005, RW> TransmissionType{};  // Transmission type
+constexpr Object<0x1402, 0x05, 0x0006, RW> EventTimer{};  // Event timer
+}
+
+namespace RPDOCommunicationParameter_1403 {  // 0x1403
+constexpr uint16_t INDEX = 0x1403;
+constexpr Object<0x1403, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1403, 0x01, 0x0007, RW> COBIDUsedByRPDO{};  // COB-ID used by RPDO
+constexpr Object<0x1403, 0x02, 0x0005, RW> TransmissionType{};  // Transmission type
+constexpr Object<0x1403, 0x05, 0x0006, RW> EventTimer{};  // Event timer
+}
+
+namespace RPDOMappingParameter {  // 0x1600
+constexpr uint16_t INDEX = 0x1600;
+constexpr Object<0x1600, 0x00, 0x0005, RW> NumberOfMappedApplicationObjectsInPDO{};  // Number of mapped application objects in PDO
+constexpr Object<0x1600, 0x01, 0x0007, RW> ApplicationObject1{};  // Application object 1
+constexpr Object<0x1600, 0x02, 0x0007, RW> ApplicationObject2{};  // Application object 2
+constexpr Object<0x1600, 0x03, 0x0007, RW> ApplicationObject3{};  // Application object 3
+constexpr Object<0x1600, 0x04, 0x0007, RW> ApplicationObject4{};  // Application object 4
+constexpr Object<0x1600, 0x05, 0x0007, RW> ApplicationObject5{};  // Application object 5
+constexpr Object<0x1600, 0x06, 0x0007, RW> ApplicationObject6{};  // Application object 6
+constexpr Object<0x1600, 0x07, 0x0007, RW> ApplicationObject7{};  // Application object 7
+constexpr Object<0x1600, 0x08, 0x0007, RW> ApplicationObject8{};  // Application object 8
+}
+
+namespace RPDOMappingParameter_1601 {  // 0x1601
+constexpr uint16_t INDEX = 0x1601;
+constexpr Object<0x1601, 0x00, 0x0005, RW> NumberOfMappedApplicationObjectsInPDO{};  // Number of mapped application objects in PDO
+constexpr Object<0x1601, 0x01, 0x0007, RW> ApplicationObject1{};  // Application object 1
+constexpr Object<0x1601, 0x02, 0x0007, RW> ApplicationObject2{};  // Application object 2
+constexpr Object<0x1601, 0x03, 0x0007, RW> ApplicationObject3{};  // Application object 3
+constexpr Object<0x1601, 0x04, 0x0007, RW> ApplicationObject4{};  // Application object 4
+constexpr Object<0x1601, 0x05, 0x0007, RW> ApplicationObject5{};  // Application object 5
+constexpr Object<0x1601, 0x06, 0x0007, RW> ApplicationObject6{};  // Application object 6
+constexpr Object<0x1601, 0x07, 0x0007, RW> ApplicationObject7{};  // Application object 7
+constexpr Object<0x1601, 0x08, 0x0007, RW> ApplicationObject8{};  // Application object 8
+}
+
+namespace RPDOMappingParameter_1602 {  // 0x1602
+constexpr uint16_t INDEX = 0x1602;
+constexpr Object<0x1602, 0x00, 0x0005, RW> NumberOfMappedApplicationObjectsInPDO{};  // Number of mapped application objects in PDO
+constexpr Object<0x1602, 0x01, 0x0007, RW> ApplicationObject1{};  // Application object 1
+constexpr Object<0x1602, 0x02, 0x0007, RW> ApplicationObject2{};  // Application object 2
+constexpr Object<0x1602, 0x03, 0x0007, RW> ApplicationObject3{};  // Application object 3
+constexpr Object<0x1602, 0x04, 0x0007, RW> ApplicationObject4{};  // Application object 4
+constexpr Object<0x1602, 0x05, 0x0007, RW> ApplicationObject5{};  // Application object 5
+constexpr Object<0x1602, 0x06, 0x0007, RW> ApplicationObject6{};  // Application object 6
+constexpr Object<0x1602, 0x07, 0x0007, RW> ApplicationObject7{};  // Application object 7
+constexpr Object<0x1602, 0x08, 0x0007, RW> ApplicationObject8{};  // Application object 8
+}
+
+namespace RPDOMappingParameter_1603 {  // 0x1603
+constexpr uint16_t INDEX = 0x1603;
+constexpr Object<0x1603, 0x00, 0x0005, RW> NumberOfMappedApplicationObjectsInPDO{};  // Number of mapped application objects in PDO
+constexpr Object<0x1603, 0x01, 0x0007, RW> ApplicationObject1{};  // Application object 1
+constexpr Object<0x1603, 0x02, 0x0007, RW> ApplicationObject2{};  // Application object 2
+constexpr Object<0x1603, 0x03, 0x0007, RW> ApplicationObject3{};  // Application object 3
+constexpr Object<0x1603, 0x04, 0x0007, RW> ApplicationObject4{};  // Application object 4
+constexpr Object<0x1603, 0x05, 0x0007, RW> ApplicationObject5{};  // Application object 5
+constexpr Object<0x1603, 0x06, 0x0007, RW> ApplicationObject6{};  // Application object 6
+constexpr Object<0x1603, 0x07, 0x0007, RW> ApplicationObject7{};  // Application object 7
+constexpr Object<0x1603, 0x08, 0x0007, RW> ApplicationObject8{};  // Application object 8
+}
+
+namespace TPDOCommunicationParameter {  // 0x1800
+constexpr uint16_t INDEX = 0x1800;
+constexpr Object<0x1800, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1800, 0x01, 0x0007, RW> COBIDUsedByTPDO{};  // COB-ID used by TPDO
+constexpr Object<0x1800, 0x02, 0x0005, RW> TransmissionType{};  // Transmission type
+constexpr Object<0x1800, 0x03, 0x0006, RW> InhibitTime{};  // Inhibit time
+constexpr Object<0x1800, 0x05, 0x0006, RW> EventTimer{};  // Event timer
+constexpr Object<0x1800, 0x06, 0x0005, RW> SYNCStartValue{};  // SYNC start value
+}
+
+namespace TPDOCommunicationParameter_1801 {  // 0x1801
+constexpr uint16_t INDEX = 0x1801;
+constexpr Object<0x1801, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1801, 0x01, 0x0007, RW> COBIDUsedByTPDO{};  // COB-ID used by TPDO
+constexpr Object<0x1801, 0x02, 0x0005, RW> TransmissionType{};  // Transmission type
+constexpr Object<0x1801, 0x03, 0x0006, RW> InhibitTime{};  // Inhibit time
+constexpr Object<0x1801, 0x05, 0x0006, RW> EventTimer{};  // Event timer
+constexpr Object<0x1801, 0x06, 0x0005, RW> SYNCStartValue{};  // SYNC start value
+}
+
+namespace TPDOCommunicationParameter_1802 {  // 0x1802
+constexpr uint16_t INDEX = 0x1802;
+constexpr Object<0x1802, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1802, 0x01, 0x0007, RW> COBIDUsedByTPDO{};  // COB-ID used by TPDO
+constexpr Object<0x1802, 0x02, 0x0005, RW> TransmissionType{};  // Transmission type
+constexpr Object<0x1802, 0x03, 0x0006, RW> InhibitTime{};  // Inhibit time
+constexpr Object<0x1802, 0x05, 0x0006, RW> EventTimer{};  // Event timer
+constexpr Object<0x1802, 0x06, 0x0005, RW> SYNCStartValue{};  // SYNC start value
+}
+
+namespace TPDOCommunicationParameter_1803 {  // 0x1803
+constexpr uint16_t INDEX = 0x1803;
+constexpr Object<0x1803, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x1803, 0x01, 0x0007, RW> COBIDUsedByTPDO{};  // COB-ID used by TPDO
+constexpr Object<0x1803, 0x02, 0x0005, RW> TransmissionType{};  // Transmission type
+constexpr Object<0x1803, 0x03, 0x0006, RW> InhibitTime{};  // Inhibit time
+constexpr Object<0x1803, 0x05, 0x0006, RW> EventTimer{};  // Event timer
+constexpr Object<0x1803, 0x06, 0x0005, RW> SYNCStartValue{};  // SYNC start value
+}
+
+namespace TPDOMappingParameter {  // 0x1A00
+constexpr uint16_t INDEX = 0x1A00;
+constexpr Object<0x1A00, 0x00, 0x0005, RW> NumberOfMappedApplicationObjectsInPDO{};  // Number of mapped application objects in PDO
+constexpr Object<0x1A00, 0x01, 0x0007, RW> ApplicationObject1{};  // Application object 1
+constexpr Object<0x1A00, 0x02, 0x0007, RW> ApplicationObject2{};  // Application object 2
+constexpr Object<0x1A00, 0x03, 0x0007, RW> ApplicationObject3{};  // Application object 3
+constexpr Object<0x1A00, 0x04, 0x0007, RW> ApplicationObject4{};  // Application object 4
+constexpr Object<0x1A00, 0x05, 0x0007, RW> ApplicationObject5{};  // Application object 5
+constexpr Object<0x1A00, 0x06, 0x0007, RW> ApplicationObject6{};  // Application object 6
+constexpr Object<0x1A00, 0x07, 0x0007, RW> ApplicationObject7{};  // Application object 7
+constexpr Object<0x1A00, 0x08, 0x0007, RW> ApplicationObject8{};  // Application object 8
+}
+
+namespace TPDOMappingParameter_1A01 {  // 0x1A01
+constexpr uint16_t INDEX = 0x1A01;
+constexpr Object<0x1A01, 0x00, 0x0005, RW> NumberOfMappedApplicationObjectsInPDO{};  // Number of mapped application objects in PDO
+constexpr Object<0x1A01, 0x01, 0x0007, RW> ApplicationObject1{};  // Application object 1
+constexpr Object<0x1A01, 0x02, 0x0007, RW> ApplicationObject2{};  // Application object 2
+constexpr Object<0x1A01, 0x03, 0x0007, RW> ApplicationObject3{};  // Application object 3
+constexpr Object<0x1A01, 0x04, 0x0007, RW> ApplicationObject4{};  // Application object 4
+constexpr Object<0x1A01, 0x05, 0x0007, RW> ApplicationObject5{};  // Application object 5
+constexpr Object<0x1A01, 0x06, 0x0007, RW> ApplicationObject6{};  // Application object 6
+constexpr Object<0x1A01, 0x07, 0x0007, RW> ApplicationObject7{};  // Application object 7
+constexpr Object<0x1A01, 0x08, 0x0007, RW> ApplicationObject8{};  // Application object 8
+}
+
+namespace TPDOMappingParameter_1A02 {  // 0x1A02
+constexpr uint16_t INDEX = 0x1A02;
+constexpr Object<0x1A02, 0x00, 0x0005, RW> NumberOfMappedApplicationObjectsInPDO{};  // Number of mapped application objects in PDO
+constexpr Object<0x1A02, 0x01, 0x0007, RW> ApplicationObject1{};  // Application object 1
+constexpr Object<0x1A02, 0x02, 0x0007, RW> ApplicationObject2{};  // Application object 2
+constexpr Object<0x1A02, 0x03, 0x0007, RW> ApplicationObject3{};  // Application object 3
+constexpr Object<0x1A02, 0x04, 0x0007, RW> ApplicationObject4{};  // Application object 4
+constexpr Object<0x1A02, 0x05, 0x0007, RW> ApplicationObject5{};  // Application object 5
+constexpr Object<0x1A02, 0x06, 0x0007, RW> ApplicationObject6{};  // Application object 6
+constexpr Object<0x1A02, 0x07, 0x0007, RW> ApplicationObject7{};  // Application object 7
+constexpr Object<0x1A02, 0x08, 0x0007, RW> ApplicationObject8{};  // Application object 8
+}
+
+namespace TPDOMappingParameter_1A03 {  // 0x1A03
+constexpr uint16_t INDEX = 0x1A03;
+constexpr Object<0x1A03, 0x00, 0x0005, RW> NumberOfMappedApplicationObjectsInPDO{};  // Number of mapped application objects in PDO
+constexpr Object<0x1A03, 0x01, 0x0007, RW> ApplicationObject1{};  // Application object 1
+constexpr Object<0x1A03, 0x02, 0x0007, RW> ApplicationObject2{};  // Application object 2
+constexpr Object<0x1A03, 0x03, 0x0007, RW> ApplicationObject3{};  // Application object 3
+constexpr Object<0x1A03, 0x04, 0x0007, RW> ApplicationObject4{};  // Application object 4
+constexpr Object<0x1A03, 0x05, 0x0007, RW> ApplicationObject5{};  // Application object 5
+constexpr Object<0x1A03, 0x06, 0x0007, RW> ApplicationObject6{};  // Application object 6
+constexpr Object<0x1A03, 0x07, 0x0007, RW> ApplicationObject7{};  // Application object 7
+constexpr Object<0x1A03, 0x08, 0x0007, RW> ApplicationObject8{};  // Application object 8
+}
+constexpr Object<0x1F50, 0x00, 0x000F, WO> ProgramData{};  // Program data
+constexpr Object<0x1F50, 0x01, 0x000F, RO> ProgramNumber1{};  // Program number 1
+constexpr Object<0x1F80, 0x00, 0x0007, RW> NMTStartup{};  // NMTStartup
+
+namespace CanopenConfig {  // 0x2001
+constexpr uint16_t INDEX = 0x2001;
+constexpr Object<0x2001, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2001, 0x01, 0x0005, RW> CANNodeid{};  // CAN nodeid
+constexpr Object<0x2001, 0x02, 0x0006, RW> CANBitRate{};  // CAN bit rate
+constexpr Object<0x2001, 0x03, 0x0001, RW> EN120Resistor{};  // EN 120 resistor
+constexpr Object<0x2001, 0x04, 0x0001, RW> ShowCanid{};  // Show canid
+}
+
+namespace MotorParameteres {  // 0x2002
+constexpr uint16_t INDEX = 0x2002;
+constexpr Object<0x2002, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2002, 0x01, 0x0007, RO> PhaseResistance{};  // Phase resistance
+constexpr Object<0x2002, 0x02, 0x0007, RO> PhaseInductance{};  // Phase inductance
+constexpr Object<0x2002, 0x03, 0x0007, RO> BackEMFConstantKE{};  // Back EMF constant KE
+constexpr Object<0x2002, 0x04, 0x0007, RO> VelocityConstantKV{};  // Velocity constant KV
+constexpr Object<0x2002, 0x05, 0x0007, RO> TorqueConstantKT{};  // Torque constant KT
+constexpr Object<0x2002, 0x06, 0x0007, RO> RotorInertiaKJ{};  // Rotor inertia KJ
+constexpr Object<0x2002, 0x07, 0x0007, RO> FrictionConstant{};  // Friction constant
+constexpr Object<0x2002, 0x08, 0x0007, RO> RatedVoltage{};  // Rated voltage
+constexpr Object<0x2002, 0x09, 0x0007, RO> RatedCurrent{};  // Rated current
+constexpr Object<0x2002, 0x0A, 0x0007, RO> TotalInertia{};  // Total inertia
+constexpr Object<0x2002, 0x0B, 0x0007, RO> TotalFriction{};  // Total friction
+}
+
+namespace CPR {  // 0x2003
+constexpr uint16_t INDEX = 0x2003;
+constexpr Object<0x2003, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2003, 0x01, 0x0007, RW> CountPerResolution{};  // Count per resolution
+}
+
+namespace CurrentPID {  // 0x2010
+constexpr uint16_t INDEX = 0x2010;
+constexpr Object<0x2010, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2010, 0x01, 0x0007, RO> KpDefault{};  // Kp default
+constexpr Object<0x2010, 0x02, 0x0007, RO> KiDefault{};  // Ki default
+constexpr Object<0x2010, 0x03, 0x0007, RW> Kp{};  // Kp
+constexpr Object<0x2010, 0x04, 0x0007, RW> Ki{};  // Ki
+constexpr Object<0x2010, 0x05, 0x0007, RW> Bandwidth{};  // Bandwidth
+constexpr Object<0x2010, 0x06, 0x0001, RO> Aututune{};  // Aututune
+}
+
+namespace VelocityPID {  // 0x2012
+constexpr uint16_t INDEX = 0x2012;
+constexpr Object<0x2012, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2012, 0x01, 0x0007, RO> KpDefault{};  // Kp default
+constexpr Object<0x2012, 0x02, 0x0007, RO> KiDefault{};  // Ki default
+constexpr Object<0x2012, 0x03, 0x0007, RW> Kp{};  // Kp
+constexpr Object<0x2012, 0x04, 0x0007, RW> Ki{};  // Ki
+constexpr Object<0x2012, 0x05, 0x0007, RW> Stiffness{};  // Stiffness
+constexpr Object<0x2012, 0x06, 0x0001, RW> Autotune{};  // Autotune
+}
+
+namespace PositionPID {  // 0x2013
+constexpr uint16_t INDEX = 0x2013;
+constexpr Object<0x2013, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2013, 0x01, 0x0007, RO> KpDefault{};  // Kp default
+constexpr Object<0x2013, 0x02, 0x0007, RW> Kp{};  // Kp
+constexpr Object<0x2013, 0x03, 0x0001, RW> Autotune{};  // Autotune
+}
+
+namespace BrakeControl {  // 0x2014
+constexpr uint16_t INDEX = 0x2014;
+constexpr Object<0x2014, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2014, 0x01, 0x0001, RO> IsThereABrake{};  // Is there a brake
+constexpr Object<0x2014, 0x02, 0x0001, RO> IsInsideControlOfBrake{};  // Is inside control of brake
+constexpr Object<0x2014, 0x03, 0x0006, RW> BrakeCurrent{};  // Brake current
+constexpr Object<0x2014, 0x04, 0x0001, RW> AutoBrake{};  // Auto brake
+constexpr Object<0x2014, 0x05, 0x0001, RW> BrakeNow{};  // Brake now
+constexpr Object<0x2014, 0x06, 0x0005, RO> BrakeStatus{};  // Brake status
+constexpr Object<0x2014, 0x07, 0x0001, RW> UnbrakeNow{};  // Unbrake now
+constexpr Object<0x2014, 0x08, 0x0006, RO> UnbrakeTriggCurrent{};  // Unbrake trigg current
+}
+
+namespace ServoStrategy {  // 0x2015
+constexpr uint16_t INDEX = 0x2015;
+constexpr Object<0x2015, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2015, 0x01, 0x0001, RW> CSPDoTrajectoryPlanning{};  // CSP do trajectory planning
+constexpr Object<0x2015, 0x02, 0x0001, RW> CSVDoTrajectoryPlanning{};  // CSV do trajectory planning
+constexpr Object<0x2015, 0x03, 0x0001, RW> CSTDoTrajectoryPlanning{};  // CST do trajectory planning
+constexpr Object<0x2015, 0x04, 0x0001, RW> TorqueWithPosition{};  // Torque with position
+constexpr Object<0x2015, 0x05, 0x0001, RW> StepdirPositionWithoutCanopen{};  // Stepdir position without canopen
+constexpr Object<0x2015, 0x06, 0x0001, RW> StepdirVelocityWithoutCanopen{};  // Stepdir velocity without canopen
+constexpr Object<0x2015, 0x07, 0x0001, RW> HomingStopAtZeroPosition{};  // Homing stop at zero position
+}
+
+namespace FilterBandwidth {  // 0x2016
+constexpr uint16_t INDEX = 0x2016;
+constexpr Object<0x2016, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2016, 0x01, 0x0007, RW> VelocityFilterBandwidth{};  // Velocity filter bandwidth
+constexpr Object<0x2016, 0x02, 0x0007, RW> AccelerationFilterBandwidth{};  // Acceleration filter bandwidth
+constexpr Object<0x2016, 0x03, 0x0007, RW> IITFilterBandwidth{};  // IIT filter bandwidth
+constexpr Object<0x2016, 0x04, 0x0007, RW> PowerFilterBandwidth{};  // Power filter bandwidth
+constexpr Object<0x2016, 0x05, 0x0007, RW> TemperatureFilterBandwidth{};  // Temperature filter bandwidth
+constexpr Object<0x2016, 0x06, 0x0007, RW> BusVoltageFilterBandwidth{};  // Bus voltage filter bandwidth
+constexpr Object<0x2016, 0x07, 0x0007, RW> BrakeCurrentFilterBandwidth{};  // Brake current filter bandwidth
+constexpr Object<0x2016, 0x08, 0x0007, RW> InputPositionFilterBandwidth{};  // Input position filter bandwidth
+}
+
+namespace IIT {  // 0x2017
+constexpr uint16_t INDEX = 0x2017;
+constexpr Object<0x2017, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2017, 0x01, 0x0007, RW> IITLimit{};  // IIT limit
+constexpr Object<0x2017, 0x02, 0x0007, RO> IITValue{};  // IIT value
+constexpr Object<0x2017, 0x03, 0x0007, RW> IITOnThreshold{};  // IIT on threshold
+}
+
+namespace BusVoltage {  // 0x2018
+constexpr uint16_t INDEX = 0x2018;
+constexpr Object<0x2018, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2018, 0x01, 0x0007, RW> OverThreshold{};  // Over threshold
+constexpr Object<0x2018, 0x02, 0x0007, RW> UnderThreshold{};  // Under threshold
+constexpr Object<0x2018, 0x03, 0x0007, RO> MaxVoltage{};  // Max voltage
+constexpr Object<0x2018, 0x04, 0x0007, RO> MinVoltage{};  // Min voltage
+}
+
+namespace EmergencyEnable {  // 0x2019
+constexpr uint16_t INDEX = 0x2019;
+constexpr Object<0x2019, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2019, 0x01, 0x0001, RW> EnableVelocityLost{};  // Enable velocity lost
+constexpr Object<0x2019, 0x02, 0x0001, RW> EnableIit{};  // Enable iit
+constexpr Object<0x2019, 0x03, 0x0001, RW> EnableHeartbeatLost{};  // Enable heartbeat lost
+constexpr Object<0x2019, 0x04, 0x0001, RW> EnableSyncTimeout{};  // Enable sync timeout
+constexpr Object<0x2019, 0x05, 0x0001, RW> EnableRxOverrun{};  // Enable rx overrun
+constexpr Object<0x2019, 0x06, 0x0001, RW> EnableTxOverun{};  // Enable tx overun
+constexpr Object<0x2019, 0x07, 0x0001, RW> EnableRemoteReset{};  // Enable remote reset
+constexpr Object<0x2019, 0x08, 0x0001, RW> EnableTpdoOutOfWindow{};  // Enable tpdo out of window
+constexpr Object<0x2019, 0x09, 0x0001, RW> EnableRpdoLength{};  // Enable rpdo length
+constexpr Object<0x2019, 0x0A, 0x0001, RW> EnableRpdoTimeout{};  // Enable rpdo timeout
+constexpr Object<0x2019, 0x0B, 0x0001, RW> EnableSyncDataLength{};  // Enable sync data length
+}
+
+namespace Feedforward {  // 0x201A
+constexpr uint16_t INDEX = 0x201A;
+constexpr Object<0x201A, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x201A, 0x01, 0x0006, RW> VelocityFeedforward{};  // Velocity feedforward
+constexpr Object<0x201A, 0x02, 0x0006, RW> AccelerationFeedforward{};  // Acceleration feedforward
+}
+
+namespace Temperature {  // 0x201B
+constexpr uint16_t INDEX = 0x201B;
+constexpr Object<0x201B, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x201B, 0x01, 0x0004, RO> BoardTemperature{};  // Board temperature
+constexpr Object<0x201B, 0x02, 0x0004, RO> MotorTemperature{};  // Motor temperature
+constexpr Object<0x201B, 0x03, 0x0004, RW> BoardMaxTemperature{};  // Board max temperature
+constexpr Object<0x201B, 0x04, 0x0004, RW> BoardMinTemperature{};  // Board min temperature
+constexpr Object<0x201B, 0x05, 0x0004, RW> MotorMaxTemperature{};  // Motor max temperature
+constexpr Object<0x201B, 0x06, 0x0004, RW> MotorMinTemperature{};  // Motor min temperature
+}
+
+namespace Resistor {  // 0x201C
+constexpr uint16_t INDEX = 0x201C;
+constexpr Object<0x201C, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x201C, 0x01, 0x0007, RW> ResistorValue{};  // Resistor value
+constexpr Object<0x201C, 0x02, 0x0007, RW> RampStartValtage{};  // Ramp start valtage
+constexpr Object<0x201C, 0x03, 0x0007, RW> RampEndVoltage{};  // Ramp end voltage
+constexpr Object<0x201C, 0x04, 0x0007, RW> RegenCurrent{};  // Regen current
+}
+constexpr Object<0x2030, 0x00, 0x0006, RW> TorqueWindow{};  // Torque window
+constexpr Object<0x2031, 0x00, 0x0006, RW> TorqueWindowTimeout{};  // Torque window timeout
+constexpr Object<0x2033, 0x00, 0x0006, RW> SyncInTime{};  // Sync in time
+
+namespace HomingBlock {  // 0x203A
+constexpr uint16_t INDEX = 0x203A;
+constexpr Object<0x203A, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x203A, 0x01, 0x0004, RW> BlockTriggerCurrent{};  // Block trigger current
+constexpr Object<0x203A, 0x02, 0x0006, RW> BlockDuration{};  // Block duration
+}
+
+namespace LimitSwitch {  // 0x203B
+constexpr uint16_t INDEX = 0x203B;
+constexpr Object<0x203B, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x203B, 0x01, 0x0007, RW> LimitSwitchType{};  // Limit switch type
+}
+constexpr Object<0x203C, 0x00, 0x0006, RW> ModeSwitchAmplifier{};  // Mode switch amplifier
+
+namespace DigitalInputControl {  // 0x2240
+constexpr uint16_t INDEX = 0x2240;
+constexpr Object<0x2240, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2240, 0x01, 0x0007, RW> SpecialFunctionEnable{};  // Special function enable
+constexpr Object<0x2240, 0x02, 0x0007, RW> InputInverted{};  // Input inverted
+constexpr Object<0x2240, 0x03, 0x0007, RO> InputRawValue{};  // Input raw value
+constexpr Object<0x2240, 0x04, 0x0007, RW> EstopEnable{};  // Estop enable
+}
+
+namespace DigitalOutputControl {  // 0x2250
+constexpr uint16_t INDEX = 0x2250;
+constexpr Object<0x2250, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x2250, 0x01, 0x0007, RW> SpecialFunctionEnable{};  // Special function enable
+constexpr Object<0x2250, 0x02, 0x0007, RW> OutputInverted{};  // Output inverted
+constexpr Object<0x2250, 0x03, 0x0007, RO> OutputRawValue{};  // Output raw value
+}
+constexpr Object<0x3000, 0x00, 0x0004, RO> AbsoluteTargetPosiion{};  // Absolute target posiion
+constexpr Object<0x3100, 0x00, 0x0004, RO> NLSPosition{};  // NLS position
+constexpr Object<0x3101, 0x00, 0x0004, RO> PLSPosition{};  // PLS position
+
+namespace CANErrorCount {  // 0x4008
+constexpr uint16_t INDEX = 0x4008;
+constexpr Object<0x4008, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x4008, 0x01, 0x0007, RO> StuffErrorCount{};  // Stuff error count
+constexpr Object<0x4008, 0x02, 0x0007, RO> FormErrorCount{};  // Form error count
+constexpr Object<0x4008, 0x03, 0x0007, RO> ACKErrorCount{};  // ACK error count
+constexpr Object<0x4008, 0x04, 0x0007, RO> RecessiveErrorCount{};  // Recessive error count
+constexpr Object<0x4008, 0x05, 0x0007, RO> DominantErrorCount{};  // Dominant error count
+constexpr Object<0x4008, 0x06, 0x0007, RO> CRCErrorCount{};  // CRC error count
+}
+constexpr Object<0x4040, 0x00, 0x0007, WO> EnterBootloader{};  // Enter bootloader
+constexpr Object<0x603F, 0x00, 0x0006, RO> ErrorCode{};  // Error code
+constexpr Object<0x6040, 0x00, 0x0006, RW> ControlWord{};  // Control word
+constexpr Object<0x6041, 0x00, 0x0006, RO> StatusWord{};  // Status word
+constexpr Object<0x605A, 0x00, 0x0003, RW> QuickStopOptionCode{};  // Quick stop option code
+constexpr Object<0x605B, 0x00, 0x0003, RW> ShutdownOptionCode{};  // Shutdown option code
+constexpr Object<0x605C, 0x00, 0x0003, RW> DisableOperationOptionCode{};  // Disable operation option code
+constexpr Object<0x605D, 0x00, 0x0003, RW> HaltOptionCode{};  // Halt option code
+constexpr Object<0x605E, 0x00, 0x0003, RW> FaultReactionOptionCode{};  // Fault reaction option code
+constexpr Object<0x6060, 0x00, 0x0002, RW> ModesOfOperation{};  // Modes of operation
+constexpr Object<0x6061, 0x00, 0x0002, RO> ModesOfOperationDisplay{};  // Modes of operation display
+constexpr Object<0x6062, 0x00, 0x0004, RO> PositionDemandValue{};  // Position demand value
+constexpr Object<0x6064, 0x00, 0x0004, RO> PositionActualValue{};  // Position actual value
+constexpr Object<0x6065, 0x00, 0x0007, RW> FollowingErrorWindow{};  // Following error window
+constexpr Object<0x6066, 0x00, 0x0006, RW> FollowingErrorTimeout{};  // Following error timeout
+constexpr Object<0x6067, 0x00, 0x0007, RW> PositionWindow{};  // Position window
+constexpr Object<0x6068, 0x00, 0x0006, RW> PositionWindowTime{};  // Position window time
+constexpr Object<0x606B, 0x00, 0x0004, RO> VelocityDemandValue{};  // Velocity demand value
+constexpr Object<0x606C, 0x00, 0x0004, RO> VelocityActualValue{};  // Velocity actual value
+constexpr Object<0x606D, 0x00, 0x0006, RW> VelocityWindow{};  // Velocity window
+constexpr Object<0x606E, 0x00, 0x0006, RW> VelocityWindowTime{};  // Velocity window time
+constexpr Object<0x606F, 0x00, 0x0006, RW> VelocityThreshold{};  // Velocity threshold
+constexpr Object<0x6070, 0x00, 0x0006, RW> VelocityThresholdTime{};  // Velocity threshold time
+constexpr Object<0x6071, 0x00, 0x0003, RW> TargetTorque{};  // Target torque
+constexpr Object<0x6072, 0x00, 0x0006, RW> MaxTorque{};  // Max torque
+constexpr Object<0x6074, 0x00, 0x0003, RO> TorqueDemandValue{};  // Torque demand value
+constexpr Object<0x6075, 0x00, 0x0007, RO> MotorRatedCurrent{};  // Motor rated current
+constexpr Object<0x6077, 0x00, 0x0003, RO> TorqueActualValue{};  // Torque actual value
+constexpr Object<0x6079, 0x00, 0x0007, RO> DCLinkCircuitVoltage{};  // DC link circuit voltage
+constexpr Object<0x607A, 0x00, 0x0004, RW> TargetPosition{};  // Target position
+constexpr Object<0x607C, 0x00, 0x0004, RW> HomeOffset{};  // Home offset
+
+namespace SoftwarePositionLimit {  // 0x607D
+constexpr uint16_t INDEX = 0x607D;
+constexpr Object<0x607D, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x607D, 0x01, 0x0004, RW> MinPositionLimit{};  // Min position limit
+constexpr Object<0x607D, 0x02, 0x0004, RW> MaxPositionLimit{};  // Max position limit
+}
+constexpr Object<0x607E, 0x00, 0x0005, RW> Polarity{};  // Polarity
+constexpr Object<0x607F, 0x00, 0x0007, RW> MaxProfileVelocity{};  // Max profile velocity
+constexpr Object<0x6080, 0x00, 0x0007, RO> MaxMotorSpeed{};  // Max motor speed
+constexpr Object<0x6081, 0x00, 0x0007, RW> ProfileVelocity{};  // Profile velocity
+constexpr Object<0x6083, 0x00, 0x0007, RW> ProfileAcceleration{};  // Profile acceleration
+constexpr Object<0x6084, 0x00, 0x0007, RW> ProfileDeceleration{};  // Profile deceleration
+constexpr Object<0x6085, 0x00, 0x0007, RW> QuickStopDeceleration{};  // Quick stop deceleration
+constexpr Object<0x6087, 0x00, 0x0007, RW> TorqueSlope{};  // Torque slope
+
+namespace PositionFactor {  // 0x6093
+constexpr uint16_t INDEX = 0x6093;
+constexpr Object<0x6093, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x6093, 0x01, 0x0007, RW> Numerator{};  // Numerator
+constexpr Object<0x6093, 0x02, 0x0007, RW> Divisor{};  // Divisor
+}
+
+namespace VelocityFactor {  // 0x6095
+constexpr uint16_t INDEX = 0x6095;
+constexpr Object<0x6095, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x6095, 0x01, 0x0007, RW> Numerator{};  // Numerator
+constexpr Object<0x6095, 0x02, 0x0007, RW> Divisor{};  // Divisor
+}
+
+namespace AccelerationFactor {  // 0x6097
+constexpr uint16_t INDEX = 0x6097;
+constexpr Object<0x6097, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x6097, 0x01, 0x0007, RW> Numerator{};  // Numerator
+constexpr Object<0x6097, 0x02, 0x0007, RW> Divisor{};  // Divisor
+}
+constexpr Object<0x6098, 0x00, 0x0002, RW> HomingMethod{};  // Homing method
+
+namespace HomingSpeeds {  // 0x6099
+constexpr uint16_t INDEX = 0x6099;
+constexpr Object<0x6099, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x6099, 0x01, 0x0007, RW> SpeedDuringSearchForSwitch{};  // Speed during search for switch
+constexpr Object<0x6099, 0x02, 0x0007, RW> SpeedDuringSearchForZero{};  // Speed during search for zero
+}
+constexpr Object<0x609A, 0x00, 0x0007, RW> HomingAcceleration{};  // Homing acceleration
+constexpr Object<0x60B0, 0x00, 0x0004, RW> PositionOffset{};  // Position offset
+constexpr Object<0x60B1, 0x00, 0x0004, RW> VelocityOffset{};  // Velocity offset
+constexpr Object<0x60B2, 0x00, 0x0003, RW> TorqueOffset{};  // Torque offset
+constexpr Object<0x60C0, 0x00, 0x0003, RO> InterpolationSubmodeSelect{};  // Interpolation submode select
+
+namespace InterpolationDataRecord {  // 0x60C1
+constexpr uint16_t INDEX = 0x60C1;
+constexpr Object<0x60C1, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x60C1, 0x01, 0x0004, RW> Object1stSetpoint{};  // 1st setpoint
+}
+
+namespace InterpolationTimeRecord {  // 0x60C2
+constexpr uint16_t INDEX = 0x60C2;
+constexpr Object<0x60C2, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x60C2, 0x01, 0x0005, RW> InterpolationTimePeriodValue{};  // Interpolation time period value
+constexpr Object<0x60C2, 0x02, 0x0002, RO> InterpolationTimeIndex{};  // Interpolation time index
+}
+constexpr Object<0x60C5, 0x00, 0x0007, RW> MaxAcceleration{};  // Max acceleration
+constexpr Object<0x60C6, 0x00, 0x0007, RW> MaxDeceleration{};  // Max deceleration
+constexpr Object<0x60F2, 0x00, 0x0006, RW> PositioningOptionCode{};  // Positioning option code
+constexpr Object<0x60F4, 0x00, 0x0004, RW> FollowingErrorActualValue{};  // Following error actual value
+constexpr Object<0x60FD, 0x00, 0x0007, RO> DigitalInputs{};  // Digital inputs
+
+namespace DigitalOutput {  // 0x60FE
+constexpr uint16_t INDEX = 0x60FE;
+constexpr Object<0x60FE, 0x00, 0x0005, RO> HighestSubIndexSupported{};  // Highest sub-index supported
+constexpr Object<0x60FE, 0x01, 0x0007, RW> PhysicalOutputs{};  // Physical outputs
+}
+constexpr Object<0x60FF, 0x00, 0x0004, RW> TargetVelocity{};  // Target velocity
+constexpr Object<0x6502, 0x00, 0x0007, RO> SupportedDriveModes{};  // Supported drive modes
+
+}  // namespace od
@@ -0,0 +1,287 @@
+#include "frame_recorder.hpp"
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// How far ahead a request that does not match the next recorded one is looked for
+static const size_t RESYNC_WINDOW = 64;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+struct ReplayStats {
+    uint64_t sent;         // Recorded responses played back
+    uint64_t matched;      // Requests that matched the recording
+    uint64_t skipped;      // Recorded requests the tool did not send this time
+    uint64_t unexpected;   // Requests not found in the recording
+
+    ReplayStats() : sent(0), matched(0), skipped(0), unexpected(0) {}
+};
+
+static void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " <can_interface> <trace_log> [options]" << std::endl;
+    std::cout << "Plays the nodes' side of a log written with canopenCommand --record: every recorded" << std::endl;
+    std::cout << "response is sent once the tool has sent the request that preceded it" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --channel <name>  Interface in the log to replay (default the first one)" << std::endl;
+    std::cout << "  --speed <factor>  Scale the recorded response times, 0 answers at once (default 1)" << std::endl;
+    std::cout << "  --timeout <ms>    Give up when the tool sends nothing expected this long (default 10000)" << std::endl;
+    std::cout << "Example:" << std::endl;
+    std::cout << "  " << programName << " vcan0 upgrade.trace --speed 4 &" << std::endl;
+    std::cout << "  canopenCommand vcan0 1 firmware.bin" << std::endl;
+}
+
+static int openCanSocket(const std::string& canInterface, bool& fdEnabled) {
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        std::cerr << "Error while opening socket" << std::endl;
+        return -1;
+    }
+
+    struct ifreq ifr;
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, canInterface.c_str(), IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+        std::cerr << "Error getting interface index" << std::endl;
+        ::close(fd);
+        return -1;
+    }
+
+    // Recorded FD frames can only be played back on an FD interface (MTU 72)
+    int enable = 1;
+    fdEnabled = ioctl(fd, SIOCGIFMTU, &ifr) == 0 && ifr.ifr_mtu == static_cast<int>(CANFD_MTU) &&
+                setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) == 0;
+
+    struct sockaddr_can addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        std::cerr << "Error in socket bind" << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sameFrame(const TraceRecord& record, const struct canfd_frame& frame) {
+    return record.canId == frame.can_id && record.len == frame.len && std::memcmp(record.data, frame.data, frame.len) == 0;
+}
+
+static bool sendRecord(int socket, const TraceRecord& record, bool fdEnabled) {
+    struct canfd_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
+    frame.can_id = record.canId;
+    frame.len = record.len;
+    std::memcpy(frame.data, record.data, record.len);
+    bool fd = (record.flags & TraceRecord::FD) != 0;
+    if (fd && !fdEnabled) {
+        return false;
+    }
+    size_t mtu = fd ? CANFD_MTU : CAN_MTU;
+    for (;;) {
+        if (write(socket, &frame, mtu) == static_cast<ssize_t>(mtu)) {
+            return true;
+        }
+        if (errno != ENOBUFS && errno != EAGAIN) {
+            std::cerr << "Error in sending frame: " << strerror(errno) << std::endl;
+            return false;
+        }
+        usleep(100);  // TX queue full, the bus drains it
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || std::strcmp(argv[1], "--help") == 0 || std::strcmp(argv[1], "-h") == 0) {
+        printHelp(argv[0]);
+        return argc < 3 ? -1 : 0;
+    }
+
+    std::string canInterface = argv[1];
+    std::string logPath = argv[2];
+    std::string channelName;
+    double speed = 1.0;
+    int timeoutMs = 10000;
+
+    for (int i = 3; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << option << std::endl;
+            return -1;
+        }
+        std::string value = argv[++i];
+        if (option == "--channel") {
+            channelName = value;
+        } else if (option == "--speed") {
+            speed = std::stod(value);
+            if (speed < 0) {
+                std::cerr << "Invalid speed: " << value << std::endl;
+                return -1;
+            }
+        } else if (option == "--timeout") {
+            timeoutMs = std::stoi(value);
+        } else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+    }
+
+    std::vector<TraceRecord> all;
+    std::vector<std::string> channels;
+    if (!FrameRecorder::readLog(logPath, all, channels)) {
+        return -1;
+    }
+    size_t channel = 0;
+    if (!channelName.empty()) {
+        channel = std::find(channels.begin(), channels.end(), channelName) - channels.begin();
+        if (channel == channels.size()) {
+            std::cerr << "No channel " << channelName << " in " << logPath << std::endl;
+            return -1;
+        }
+    }
+    std::vector<TraceRecord> records;
+    records.reserve(all.size());
+    for (size_t i = 0; i < all.size(); i++) {
+        if (all[i].channel == channel) {
+            records.push_back(all[i]);
+        }
+    }
+    if (records.empty()) {
+        std::cerr << "No frames to replay in " << logPath << std::endl;
+        return -1;
+    }
+    double recordedSeconds = (records.back().timestampNs - records.front().timestampNs) / 1e9;
+    std::cout << "Replaying " << records.size() << " frames of "
+              << (channel < channels.size() ? channels[channel] : std::string("?")) << " ("
+              << std::fixed << std::setprecision(3) << recordedSeconds << " s recorded)" << std::endl;
+
+    bool fdEnabled = false;
+    int fd = openCanSocket(canInterface, fdEnabled);
+    if (fd < 0) {
+        return -1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    // Recorded responses are timed from the request that preceded them
+    ReplayStats stats;
+    size_t next = 0;
+    Clock::time_point anchor = Clock::now();
+    uint64_t anchorNs = records.front().timestampNs;
+    Clock::time_point start = anchor;
+    Clock::time_point lastMatch = anchor;
+    bool failed = false;
+
+    while (next < records.size() && !stopRequested) {
+        Clock::time_point now = Clock::now();
+
+        // Play back responses that are due
+        while (next < records.size() && !(records[next].flags & TraceRecord::TX)) {
+            Clock::time_point due = anchor;
+            if (speed > 0) {
+                due += std::chrono::nanoseconds(static_cast<int64_t>((records[next].timestampNs - anchorNs) / speed));
+            }
+            if (due > now) {
+                break;
+            }
+            if (sendRecord(fd, records[next], fdEnabled)) {
+                stats.sent++;
+            }
+            next++;
+        }
+        if (next >= records.size()) {
+            break;
+        }
+
+        int waitMs;
+        if (records[next].flags & TraceRecord::TX) {
+            int idleMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - lastMatch).count());
+            if (idleMs >= timeoutMs) {
+                std::cerr << "No expected frame from the tool within " << timeoutMs << " ms, stopping at frame "
+                          << next << std::endl;
+                failed = true;
+                break;
+            }
+            waitMs = timeoutMs - idleMs;
+        } else {
+            Clock::time_point due = anchor + std::chrono::nanoseconds(
+                static_cast<int64_t>((records[next].timestampNs - anchorNs) / speed));
+            waitMs = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(due - now).count() + 999) / 1000;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, std::max(waitMs, 0)) < 0 && errno != EINTR) {
+            std::cerr << "Error in poll: " << strerror(errno) << std::endl;
+            failed = true;
+            break;
+        }
+        if (!(pfd.revents & POLLIN)) {
+            continue;
+        }
+
+        struct canfd_frame frame;
+        ssize_t n;
+        while ((n = recv(fd, &frame, sizeof(frame), MSG_DONTWAIT)) == static_cast<ssize_t>(CAN_MTU) ||
+               n == static_cast<ssize_t>(CANFD_MTU)) {
+            // The next recorded request that looks like this one
+            size_t match = next;
+            size_t requests = 0;
+            while (match < records.size() && requests < RESYNC_WINDOW) {
+                if (records[match].flags & TraceRecord::TX) {
+                    if (sameFrame(records[match], frame)) {
+                        break;
+                    }
+                    requests++;
+                }
+                match++;
+            }
+            if (match >= records.size() || requests >= RESYNC_WINDOW) {
+                stats.unexpected++;
+                continue;
+            }
+
+            // Everything recorded before the request goes out first, in order
+            for (; next < match; next++) {
+                if (records[next].flags & TraceRecord::TX) {
+                    stats.skipped++;
+                } else if (sendRecord(fd, records[next], fdEnabled)) {
+                    stats.sent++;
+                }
+            }
+            stats.matched++;
+            anchor = lastMatch = Clock::now();
+            anchorNs = records[match].timestampNs;
+            next = match + 1;
+        }
+    }
+
+    ::close(fd);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "Replayed " << stats.sent << " frames for " << stats.matched << " requests in " << std::fixed
+              << std::setprecision(3) << seconds << " s (" << recordedSeconds << " s recorded), "
+              << stats.skipped << " recorded requests skipped, " << stats.unexpected << " unexpected" << std::endl;
+    return failed || stats.skipped != 0 || stats.unexpected != 0 ? 1 : 0;
+}
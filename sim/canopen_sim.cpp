@@ -0,0 +1,308 @@
+#include "sim_dictionary.hpp"
+#include "sim_node.hpp"
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+// Frame waiting for the simulated response latency
+struct PendingFrame {
+    Clock::time_point due;
+    struct can_frame frame;
+};
+
+struct SimStats {
+    uint64_t received;
+    uint64_t receivedDropped;
+    uint64_t sent;
+    uint64_t sentDropped;
+
+    SimStats() : received(0), receivedDropped(0), sent(0), sentDropped(0) {}
+};
+
+static void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " <can_interface> [options]" << std::endl;
+    std::cout << "Simulates CANopen drives described by an EDS file, including the ESDO bootloader" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --eds <file>           Object dictionary (default flow_all.eds)" << std::endl;
+    std::cout << "  --node <id>            Simulate a node with this ID, may be repeated (default 1)" << std::endl;
+    std::cout << "  --latency <us>         Delay of every frame the nodes send (default 0)" << std::endl;
+    std::cout << "  --jitter <us>          Random extra delay on top of the latency (default 0)" << std::endl;
+    std::cout << "  --loss <percent>       Drop this share of frames in each direction (default 0)" << std::endl;
+    std::cout << "  --seed <n>             Seed for jitter and loss, runs are reproducible (default 1)" << std::endl;
+    std::cout << "  --heartbeat <ms>       Producer heartbeat period (default from the EDS)" << std::endl;
+    std::cout << "  --boot-time <ms>       Time from a reset to the boot-up message (default 200)" << std::endl;
+    std::cout << "  --block-size <n>       Segments per block for block download (default 127)" << std::endl;
+    std::cout << "  --fd-length <n>        CAN FD block download frame length, 0 for classic only (default 64)" << std::endl;
+    std::cout << "                         FD needs an FD interface: ip link set vcan0 mtu 72" << std::endl;
+    std::cout << "  --hw-version <a.b.c.d> Hardware version bytes in hex (default 10.00.30.01)" << std::endl;
+    std::cout << "  --sw-version <text>    Software version string (default 25032601)" << std::endl;
+    std::cout << "Example:" << std::endl;
+    std::cout << "  " << programName << " vcan0 --node 1 --node 2 --latency 300 --loss 0.5" << std::endl;
+}
+
+static bool parseHardwareVersion(const std::string& text, uint8_t version[4]) {
+    unsigned int bytes[4];
+    if (std::sscanf(text.c_str(), "%x.%x.%x.%x", &bytes[0], &bytes[1], &bytes[2], &bytes[3]) != 4) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (bytes[i] > 0xFF) {
+            return false;
+        }
+        version[i] = static_cast<uint8_t>(bytes[i]);
+    }
+    return true;
+}
+
+static int openCanSocket(const std::string& canInterface, bool& fdEnabled) {
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        std::cerr << "Error while opening socket" << std::endl;
+        return -1;
+    }
+
+    struct ifreq ifr;
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, canInterface.c_str(), IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+        std::cerr << "Error getting interface index" << std::endl;
+        ::close(fd);
+        return -1;
+    }
+
+    // Take FD frames when the interface carries them (MTU 72)
+    int enable = 1;
+    fdEnabled = ioctl(fd, SIOCGIFMTU, &ifr) == 0 && ifr.ifr_mtu == static_cast<int>(CANFD_MTU) &&
+                setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) == 0;
+
+    struct sockaddr_can addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        std::cerr << "Error in socket bind" << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0 || std::strcmp(argv[1], "-h") == 0) {
+        printHelp(argv[0]);
+        return argc < 2 ? -1 : 0;
+    }
+
+    std::string canInterface = argv[1];
+    std::string edsPath = "flow_all.eds";
+    std::vector<int> nodeIds;
+    int latencyUs = 0;
+    int jitterUs = 0;
+    double lossPercent = 0;
+    unsigned int seed = 1;
+    SimNodeConfig config;
+
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << option << std::endl;
+            return -1;
+        }
+        std::string value = argv[++i];
+        if (option == "--eds") {
+            edsPath = value;
+        } else if (option == "--node") {
+            int id = std::stoi(value);
+            if (id < 1 || id > 127) {
+                std::cerr << "Invalid node ID: " << value << std::endl;
+                return -1;
+            }
+            nodeIds.push_back(id);
+        } else if (option == "--latency") {
+            latencyUs = std::stoi(value);
+        } else if (option == "--jitter") {
+            jitterUs = std::stoi(value);
+        } else if (option == "--loss") {
+            lossPercent = std::stod(value);
+        } else if (option == "--seed") {
+            seed = static_cast<unsigned int>(std::stoul(value));
+        } else if (option == "--heartbeat") {
+            config.heartbeatMs = std::stoi(value);
+        } else if (option == "--boot-time") {
+            config.bootMs = std::stoi(value);
+        } else if (option == "--block-size") {
+            int blockSize = std::stoi(value);
+            if (blockSize < 1 || blockSize > 127) {
+                std::cerr << "Invalid block size: " << value << std::endl;
+                return -1;
+            }
+            config.blockSize = static_cast<uint8_t>(blockSize);
+        } else if (option == "--fd-length") {
+            int fdLength = std::stoi(value);
+            if (fdLength != 0 && fdLength != 12 && fdLength != 16 && fdLength != 20 && fdLength != 24 &&
+                fdLength != 32 && fdLength != 48 && fdLength != 64) {
+                std::cerr << "Invalid FD frame length: " << value << std::endl;
+                return -1;
+            }
+            config.fdFrameLength = static_cast<uint8_t>(fdLength);
+        } else if (option == "--hw-version") {
+            if (!parseHardwareVersion(value, config.hardwareVersion)) {
+                std::cerr << "Invalid hardware version: " << value << std::endl;
+                return -1;
+            }
+        } else if (option == "--sw-version") {
+            config.softwareVersion = value;
+        } else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+    }
+    if (nodeIds.empty()) {
+        nodeIds.push_back(1);
+    }
+
+    SimDictionary dictionary;
+    if (!dictionary.load(edsPath)) {
+        return -1;
+    }
+    std::cout << "Loaded " << dictionary.size() << " objects from " << edsPath << std::endl;
+
+    bool fdEnabled = false;
+    int fd = openCanSocket(canInterface, fdEnabled);
+    if (fd < 0) {
+        return -1;
+    }
+    if (!fdEnabled) {
+        config.fdFrameLength = 0;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::mt19937 random(seed);
+    std::bernoulli_distribution loss(std::min(std::max(lossPercent, 0.0), 100.0) / 100.0);
+    std::uniform_int_distribution<int> jitter(0, std::max(jitterUs, 0));
+    std::deque<PendingFrame> pending;
+    Clock::time_point lastDue;
+    SimStats stats;
+    bool txBlocked = false;
+
+    // Frames keep their order as on a real bus, jitter only stretches the gaps
+    SimNode::SendFn send = [&](const struct can_frame& frame) {
+        if (loss(random)) {
+            stats.sentDropped++;
+            return;
+        }
+        PendingFrame item;
+        item.due = std::max(Clock::now() + std::chrono::microseconds(latencyUs + jitter(random)), lastDue);
+        item.frame = frame;
+        lastDue = item.due;
+        pending.push_back(item);
+    };
+
+    std::vector<std::unique_ptr<SimNode> > nodes;
+    Clock::time_point now = Clock::now();
+    for (size_t i = 0; i < nodeIds.size(); i++) {
+        SimNodeConfig nodeConfig = config;
+        nodeConfig.nodeId = nodeIds[i];
+        nodeConfig.serialNumber = config.serialNumber + nodeIds[i];
+        nodes.push_back(std::unique_ptr<SimNode>(new SimNode(dictionary, nodeConfig, send)));
+        nodes.back()->powerOn(now);
+    }
+    std::cout << "Simulating " << nodes.size() << " node(s) on " << canInterface
+              << (config.fdFrameLength != 0 ? " with CAN FD block download" : "") << std::endl;
+
+    while (!stopRequested) {
+        now = Clock::now();
+        Clock::time_point next = now + std::chrono::seconds(1);
+        for (size_t i = 0; i < nodes.size(); i++) {
+            next = std::min(next, nodes[i]->nextEvent());
+        }
+        if (!pending.empty()) {
+            next = std::min(next, pending.front().due);
+        }
+        int timeoutMs = 0;
+        if (next > now) {
+            // Round up, a 0 ms poll would spin until a sub-millisecond deadline passes
+            timeoutMs = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(next - now).count() + 999) / 1000;
+        }
+        if (txBlocked) {
+            timeoutMs = std::max(timeoutMs, 1);
+        }
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, timeoutMs) < 0 && errno != EINTR) {
+            std::cerr << "Error in poll: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        if (pfd.revents & POLLIN) {
+            struct canfd_frame frame;
+            ssize_t n;
+            while ((n = recv(fd, &frame, sizeof(frame), MSG_DONTWAIT)) == static_cast<ssize_t>(CAN_MTU) ||
+                   n == static_cast<ssize_t>(CANFD_MTU)) {
+                stats.received++;
+                if (loss(random)) {
+                    stats.receivedDropped++;
+                    continue;
+                }
+                now = Clock::now();
+                for (size_t i = 0; i < nodes.size(); i++) {
+                    nodes[i]->handleFrame(frame, n == static_cast<ssize_t>(CANFD_MTU), now);
+                }
+            }
+        }
+
+        now = Clock::now();
+        for (size_t i = 0; i < nodes.size(); i++) {
+            nodes[i]->poll(now);
+        }
+
+        txBlocked = false;
+        while (!pending.empty() && pending.front().due <= now) {
+            if (write(fd, &pending.front().frame, sizeof(struct can_frame)) != sizeof(struct can_frame)) {
+                if (errno == ENOBUFS || errno == EAGAIN) {
+                    txBlocked = true;  // TX queue full, retry on the next round
+                    break;
+                }
+                std::cerr << "Error in sending frame: " << strerror(errno) << std::endl;
+            } else {
+                stats.sent++;
+            }
+            pending.pop_front();
+        }
+    }
+
+    ::close(fd);
+    std::cout << "Received " << stats.received << " frames (" << stats.receivedDropped << " dropped), sent "
+              << stats.sent << " frames (" << stats.sentDropped << " dropped)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "sim_dictionary.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+size_t SimDictionary::typeSize(uint16_t dataType) {
+    switch (dataType) {
+        case 0x0001: return 1;  // BOOLEAN
+        case 0x0002: return 1;  // INTEGER8
+        case 0x0003: return 2;  // INTEGER16
+        case 0x0004: return 4;  // INTEGER32
+        case 0x0005: return 1;  // UNSIGNED8
+        case 0x0006: return 2;  // UNSIGNED16
+        case 0x0007: return 4;  // UNSIGNED32
+        case 0x0008: return 4;  // REAL32
+        case 0x0011: return 8;  // REAL64
+        case 0x0015: return 8;  // INTEGER64
+        case 0x001B: return 8;  // UNSIGNED64
+        default: return 0;      // Strings and domains
+    }
+}
+
+bool SimDictionary::isSigned(uint16_t dataType) {
+    return dataType == 0x0002 || dataType == 0x0003 || dataType == 0x0004 || dataType == 0x0015;
+}
+
+int64_t SimDictionary::parseNumber(const std::string& text, int nodeId) {
+    std::string value = trim(text);
+    int64_t base = 0;
+    if (value.compare(0, 7, "$NODEID") == 0) {
+        base = nodeId;
+        value = trim(value.substr(7));
+        if (!value.empty() && value[0] == '+') {
+            value = trim(value.substr(1));
+        }
+    }
+    if (value.empty()) {
+        return base;
+    }
+    return base + std::strtoll(value.c_str(), NULL, 0);
+}
+
+bool SimDictionary::load(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file) {
+        std::cerr << "Error opening EDS file: " << path << std::endl;
+        return false;
+    }
+
+    objects_.clear();
+    indices_.clear();
+
+    // Only VAR sections carry a DataType: "[1000]" or "[1018sub1]"
+    std::string line;
+    bool inObject = false;
+    uint32_t current = 0;
+    SimObject object;
+    std::string lowLimit, highLimit;
+    bool hasDataType = false;
+
+    while (true) {
+        bool more = static_cast<bool>(std::getline(file, line));
+        line = trim(line);
+        if (!more || (!line.empty() && line[0] == '[')) {
+            if (inObject && hasDataType) {
+                object.size = typeSize(object.dataType);
+                if (!lowLimit.empty() && !highLimit.empty()) {
+                    object.hasLimits = true;
+                    object.lowLimit = parseNumber(lowLimit, 0);
+                    object.highLimit = parseNumber(highLimit, 0);
+                }
+                objects_[current] = object;
+                indices_.insert(static_cast<uint16_t>(current >> 8));
+            }
+            if (!more) {
+                break;
+            }
+
+            std::string name = line.substr(1, line.find(']') - 1);
+            char* end = NULL;
+            unsigned long index = std::strtoul(name.c_str(), &end, 16);
+            inObject = end == name.c_str() + 4 && (*end == '\0' || std::strncmp(end, "sub", 3) == 0);
+            unsigned long subindex = (inObject && *end != '\0') ? std::strtoul(end + 3, NULL, 16) : 0;
+            current = key(static_cast<uint16_t>(index), static_cast<uint8_t>(subindex));
+            object = SimObject();
+            lowLimit.clear();
+            highLimit.clear();
+            hasDataType = false;
+            continue;
+        }
+        if (!inObject || line.empty() || line[0] == ';') {
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        std::string keyName = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        if (keyName == "DataType") {
+            object.dataType = static_cast<uint16_t>(std::strtoul(value.c_str(), NULL, 0));
+            hasDataType = true;
+        } else if (keyName == "AccessType") {
+            object.readable = value != "wo";
+            object.writable = value == "rw" || value == "rww" || value == "rwr" || value == "wo";
+        } else if (keyName == "DefaultValue") {
+            object.defaultValue = value;
+        } else if (keyName == "LowLimit") {
+            lowLimit = value;
+        } else if (keyName == "HighLimit") {
+            highLimit = value;
+        }
+    }
+
+    if (objects_.empty()) {
+        std::cerr << "No objects found in EDS file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const SimObject* SimDictionary::find(uint16_t index, uint8_t subindex) const {
+    std::map<uint32_t, SimObject>::const_iterator it = objects_.find(key(index, subindex));
+    return it != objects_.end() ? &it->second : NULL;
+}
+
+void SimDictionary::defaults(int nodeId, Values& values) const {
+    values.clear();
+    for (std::map<uint32_t, SimObject>::const_iterator it = objects_.begin(); it != objects_.end(); ++it) {
+        const SimObject& object = it->second;
+        std::vector<uint8_t>& value = values[it->first];
+        if (object.size == 0) {
+            value.assign(object.defaultValue.begin(), object.defaultValue.end());
+            continue;
+        }
+        // Little endian, as on the bus
+        uint64_t number = static_cast<uint64_t>(parseNumber(object.defaultValue, nodeId));
+        value.resize(object.size);
+        for (size_t i = 0; i < object.size; i++) {
+            value[i] = static_cast<uint8_t>(number >> (8 * i));
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// One VAR of the object dictionary as described by the EDS
+struct SimObject {
+    uint16_t dataType;
+    bool readable;
+    bool writable;
+    size_t size;                 // Fixed size in bytes, 0 for strings and domains
+    std::string defaultValue;    // As written in the EDS, may use $NODEID
+    bool hasLimits;
+    int64_t lowLimit;
+    int64_t highLimit;
+
+    SimObject() : dataType(0), readable(true), writable(false), size(0), hasLimits(false), lowLimit(0), highLimit(0) {}
+};
+
+// Object dictionary of a simulated node, loaded from an EDS file
+class SimDictionary {
+public:
+    typedef std::map<uint32_t, std::vector<uint8_t> > Values;  // Key is index << 8 | subindex
+
+    bool load(const std::string& path);
+
+    const SimObject* find(uint16_t index, uint8_t subindex) const;
+    bool hasObject(uint16_t index) const { return indices_.count(index) != 0; }
+    size_t size() const { return objects_.size(); }
+
+    // Default values after a reset to factory settings
+    void defaults(int nodeId, Values& values) const;
+
+    static uint32_t key(uint16_t index, uint8_t subindex) { return (static_cast<uint32_t>(index) << 8) | subindex; }
+    static size_t typeSize(uint16_t dataType);
+    static bool isSigned(uint16_t dataType);
+
+private:
+    std::map<uint32_t, SimObject> objects_;
+    std::set<uint16_t> indices_;
+
+    static int64_t parseNumber(const std::string& text, int nodeId);
+};
@@ -0,0 +1,644 @@
+#include "sim_node.hpp"
+#include "../src/crc16.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const int FACTORY_NODE_ID = 126;
+
+static uint32_t readLe32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static void writeLe32(uint8_t* data, uint32_t value) {
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = (value >> 24) & 0xFF;
+}
+
+static std::vector<uint8_t> le32(uint32_t value) {
+    std::vector<uint8_t> bytes(4);
+    writeLe32(&bytes[0], value);
+    return bytes;
+}
+
+static bool isSignature(const std::vector<uint8_t>& value, const char* signature) {
+    return value.size() == 4 && std::memcmp(&value[0], signature, 4) == 0;
+}
+
+SimNode::SimNode(const SimDictionary& dictionary, const SimNodeConfig& config, const SendFn& send)
+    : dictionary_(dictionary), config_(config), send_(send), mode_(BOOTING), bootInto_(APPLICATION),
+      nodeId_(config.nodeId), storedNodeId_(config.nodeId), nmtState_(0x7F),
+      bootAt_(Clock::time_point::max()), nextHeartbeat_(Clock::time_point::max()),
+      bootIdleAt_(Clock::time_point::max()), blockGapAt_(Clock::time_point::max()), imagePending_(false),
+      sdoState_(SDO_IDLE), sdoIndex_(0), sdoSubindex_(0), toggle_(0), transferSize_(0), transferOffset_(0),
+      blockSize_(config.blockSize), lastSeq_(0), lastSegmentSeen_(false), fdTransfer_(false),
+      blockSegments_(0) {}
+
+void SimNode::powerOn(Clock::time_point now) {
+    mode_ = APPLICATION;
+    reset(APPLICATION, now);
+}
+
+void SimNode::reset(Mode mode, Clock::time_point now) {
+    // Leaving the bootloader after a download starts the new application with factory settings
+    if (mode_ == BOOTLOADER && mode == APPLICATION && imagePending_) {
+        stored_.clear();
+        storedNodeId_ = FACTORY_NODE_ID;
+        imagePending_ = false;
+    }
+    mode_ = BOOTING;
+    bootInto_ = mode;
+    bootAt_ = now + std::chrono::milliseconds(config_.bootMs);
+    nextHeartbeat_ = Clock::time_point::max();
+    bootIdleAt_ = Clock::time_point::max();
+    blockGapAt_ = Clock::time_point::max();
+    sdoState_ = SDO_IDLE;
+}
+
+void SimNode::boot(Clock::time_point now) {
+    mode_ = bootInto_;
+    bootAt_ = Clock::time_point::max();
+    nodeId_ = storedNodeId_;
+    nmtState_ = 0x7F;  // Pre-operational
+
+    if (mode_ == APPLICATION) {
+        dictionary_.defaults(nodeId_, values_);
+        if (config_.heartbeatMs > 0) {
+            std::vector<uint8_t>& period = values_[SimDictionary::key(0x1017, 0)];
+            period.resize(2);
+            period[0] = config_.heartbeatMs & 0xFF;
+            period[1] = (config_.heartbeatMs >> 8) & 0xFF;
+        }
+        for (SimDictionary::Values::const_iterator it = stored_.begin(); it != stored_.end(); ++it) {
+            values_[it->first] = it->second;
+        }
+        values_[SimDictionary::key(0x2001, 1)] = std::vector<uint8_t>(1, static_cast<uint8_t>(nodeId_));
+    }
+
+    std::cout << "Node " << std::dec << nodeId_ << " booted into the "
+              << (mode_ == APPLICATION ? "application" : "bootloader") << std::endl;
+    sendHeartbeat(0x00);  // Boot-up
+    int period = heartbeatMs();
+    if (period > 0) {
+        nextHeartbeat_ = now + std::chrono::milliseconds(period);
+    }
+}
+
+int SimNode::heartbeatMs() const {
+    if (mode_ != APPLICATION) {
+        return config_.heartbeatMs;
+    }
+    SimDictionary::Values::const_iterator it = values_.find(SimDictionary::key(0x1017, 0));
+    if (it == values_.end() || it->second.size() < 2) {
+        return 0;
+    }
+    return it->second[0] | (it->second[1] << 8);
+}
+
+void SimNode::sendHeartbeat(uint8_t state) {
+    struct can_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
+    frame.can_id = 0x700 + nodeId_;
+    frame.can_dlc = 1;
+    frame.data[0] = state;
+    send_(frame);
+}
+
+void SimNode::poll(Clock::time_point now) {
+    if (mode_ == BOOTING) {
+        if (now >= bootAt_) {
+            boot(now);
+        }
+        return;
+    }
+
+    if (now >= nextHeartbeat_) {
+        sendHeartbeat(nmtState_);
+        int period = heartbeatMs();
+        nextHeartbeat_ = period > 0 ? std::max(nextHeartbeat_ + std::chrono::milliseconds(period), now)
+                                    : Clock::time_point::max();
+    }
+    if (now >= blockGapAt_) {
+        // The tail of the block was lost, report what arrived
+        acknowledgeBlock();
+    }
+    if (now >= bootIdleAt_ && sdoState_ == SDO_IDLE) {
+        std::cout << "Node " << std::dec << nodeId_ << " starting the flashed application ("
+                  << image_.size() << " bytes)" << std::endl;
+        reset(APPLICATION, now);
+    }
+}
+
+SimNode::Clock::time_point SimNode::nextEvent() const {
+    if (mode_ == BOOTING) {
+        return bootAt_;
+    }
+    return std::min(std::min(nextHeartbeat_, blockGapAt_), bootIdleAt_);
+}
+
+void SimNode::handleFrame(const struct canfd_frame& frame, bool fd, Clock::time_point now) {
+    if (mode_ == BOOTING || (frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG))) {
+        return;
+    }
+    canid_t cobId = frame.can_id & CAN_SFF_MASK;
+    if (cobId == 0x000 && frame.len >= 2) {
+        handleNmt(frame, now);
+    } else if (cobId == static_cast<canid_t>(0x600 + nodeId_)) {
+        handleSdo(frame, fd, now);
+    }
+}
+
+void SimNode::handleNmt(const struct canfd_frame& frame, Clock::time_point now) {
+    if (frame.data[1] != 0 && frame.data[1] != nodeId_) {
+        return;
+    }
+    switch (frame.data[0]) {
+        case 0x01: nmtState_ = 0x05; break;  // Start
+        case 0x02: nmtState_ = 0x04; break;  // Stop
+        case 0x80: nmtState_ = 0x7F; break;  // Enter pre-operational
+        case 0x81: reset(APPLICATION, now); break;
+        case 0x82: reset(mode_, now); break;
+        default: break;
+    }
+}
+
+void SimNode::handleSdo(const struct canfd_frame& frame, bool fd, Clock::time_point now) {
+    uint8_t data[8] = {0};
+    std::memcpy(data, frame.data, std::min<size_t>(frame.len, 8));
+    uint8_t cs = data[0];
+
+    // Traffic after a download keeps the bootloader waiting
+    if (bootIdleAt_ != Clock::time_point::max()) {
+        bootIdleAt_ = now + std::chrono::milliseconds(config_.bootIdleMs);
+    }
+
+    if (cs == 0x80) {  // Client abort, sequence number 0 is never a block segment
+        sdoState_ = SDO_IDLE;
+        blockGapAt_ = Clock::time_point::max();
+        return;
+    }
+    // During block download every frame is a segment, its first byte is the sequence number
+    if (sdoState_ == SDO_BLOCK_DOWNLOAD) {
+        if (fd != fdTransfer_) {
+            abort(sdoIndex_, sdoSubindex_, 0x05040001);  // Segment in the wrong frame format
+            return;
+        }
+        blockDownloadSegment(frame.data, fd ? frame.len : 8, now);
+        return;
+    }
+
+    switch (sdoState_) {
+        case SDO_DOWNLOAD_SEGMENT:
+            if ((cs & 0xE0) == 0x00) {
+                downloadSegment(data, now);
+                return;
+            }
+            break;
+        case SDO_UPLOAD_SEGMENT:
+            if ((cs & 0xE0) == 0x60) {
+                uploadSegment(data);
+                return;
+            }
+            break;
+        case SDO_BLOCK_DOWNLOAD_END:
+            if ((cs & 0xE3) == 0xC1) {
+                endBlockDownload(data, now);
+                return;
+            }
+            break;
+        case SDO_BLOCK_UPLOAD_START:
+            if (cs == 0xA3) {
+                sendUploadBlock();
+                return;
+            }
+            break;
+        case SDO_BLOCK_UPLOAD:
+            if ((cs & 0xE3) == 0xA2) {
+                blockUploadAck(data);
+                return;
+            }
+            break;
+        case SDO_BLOCK_UPLOAD_END:
+            if ((cs & 0xE3) == 0xA1) {
+                sdoState_ = SDO_IDLE;
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+
+    // Anything else starts a new transfer and drops the one in progress
+    sdoState_ = SDO_IDLE;
+    sdoIndex_ = data[1] | (data[2] << 8);
+    sdoSubindex_ = data[3];
+    if ((cs & 0xE0) == 0x20) {
+        initiateDownload(data, now);
+    } else if ((cs & 0xE0) == 0x40) {
+        initiateUpload(data);
+    } else if ((cs & 0xE0) == 0xC0 && (cs & 0x01) == 0) {
+        initiateBlockDownload(data, fd);
+    } else if ((cs & 0xE0) == 0xA0 && (cs & 0x03) == 0) {
+        initiateBlockUpload(data);
+    } else {
+        abort(sdoIndex_, sdoSubindex_, 0x05040001);  // Invalid command specifier
+    }
+}
+
+void SimNode::initiateDownload(const uint8_t* data, Clock::time_point now) {
+    uint8_t cs = data[0];
+    if (cs & 0x02) {  // Expedited
+        size_t size = (cs & 0x01) ? 4 - ((cs >> 2) & 0x03) : 4;
+        std::vector<uint8_t> value(&data[4], &data[4] + size);
+        uint32_t code = writeObject(sdoIndex_, sdoSubindex_, value, now);
+        if (code != 0) {
+            abort(sdoIndex_, sdoSubindex_, code);
+            return;
+        }
+        uint8_t response[8] = {0x60, data[1], data[2], data[3], 0, 0, 0, 0};
+        respond(response);
+        return;
+    }
+
+    transfer_.clear();
+    transferSize_ = (cs & 0x01) ? readLe32(&data[4]) : 0;
+    toggle_ = 0;
+    sdoState_ = SDO_DOWNLOAD_SEGMENT;
+    uint8_t response[8] = {0x60, data[1], data[2], data[3], 0, 0, 0, 0};
+    respond(response);
+}
+
+void SimNode::downloadSegment(const uint8_t* data, Clock::time_point now) {
+    uint8_t cs = data[0];
+    uint8_t toggle = (cs >> 4) & 0x01;
+    if (toggle != toggle_) {
+        abort(sdoIndex_, sdoSubindex_, 0x05030000);  // Toggle bit not alternated
+        return;
+    }
+    size_t unused = (cs >> 1) & 0x07;
+    transfer_.insert(transfer_.end(), &data[1], &data[8 - unused]);
+    toggle_ ^= 1;
+
+    if (cs & 0x01) {
+        sdoState_ = SDO_IDLE;
+        if (transferSize_ != 0 && transfer_.size() != transferSize_) {
+            abort(sdoIndex_, sdoSubindex_, 0x06070010);  // Length does not match
+            return;
+        }
+        uint32_t code = writeObject(sdoIndex_, sdoSubindex_, transfer_, now);
+        if (code != 0) {
+            abort(sdoIndex_, sdoSubindex_, code);
+            return;
+        }
+    }
+    uint8_t response[8] = {static_cast<uint8_t>(0x20 | (toggle << 4)), 0, 0, 0, 0, 0, 0, 0};
+    respond(response);
+}
+
+void SimNode::initiateUpload(const uint8_t* data) {
+    std::vector<uint8_t> value;
+    uint32_t code = readObject(sdoIndex_, sdoSubindex_, value);
+    if (code != 0) {
+        abort(sdoIndex_, sdoSubindex_, code);
+        return;
+    }
+
+    uint8_t response[8] = {0, data[1], data[2], data[3], 0, 0, 0, 0};
+    if (!value.empty() && value.size() <= 4) {
+        response[0] = static_cast<uint8_t>(0x43 | ((4 - value.size()) << 2));
+        std::memcpy(&response[4], &value[0], value.size());
+        respond(response);
+        return;
+    }
+
+    response[0] = 0x41;
+    writeLe32(&response[4], static_cast<uint32_t>(value.size()));
+    transfer_ = value;
+    transferOffset_ = 0;
+    toggle_ = 0;
+    sdoState_ = SDO_UPLOAD_SEGMENT;
+    respond(response);
+}
+
+void SimNode::uploadSegment(const uint8_t* data) {
+    uint8_t toggle = (data[0] >> 4) & 0x01;
+    if (toggle != toggle_) {
+        abort(sdoIndex_, sdoSubindex_, 0x05030000);
+        return;
+    }
+
+    size_t chunk = std::min(transfer_.size() - transferOffset_, size_t(7));
+    bool last = transferOffset_ + chunk >= transfer_.size();
+    uint8_t response[8] = {0};
+    response[0] = static_cast<uint8_t>((toggle << 4) | ((7 - chunk) << 1) | (last ? 0x01 : 0x00));
+    if (chunk > 0) {
+        std::memcpy(&response[1], &transfer_[transferOffset_], chunk);
+    }
+    transferOffset_ += chunk;
+    toggle_ ^= 1;
+    if (last) {
+        sdoState_ = SDO_IDLE;
+    }
+    respond(response);
+}
+
+void SimNode::initiateBlockDownload(const uint8_t* data, bool fd) {
+    // The image goes to 0x1F50 sub 0, sub 1 is accepted as well
+    if (mode_ != BOOTLOADER || sdoIndex_ != 0x1F50 || sdoSubindex_ > 0x01) {
+        abort(sdoIndex_, sdoSubindex_, dictionary_.hasObject(sdoIndex_) ? 0x08000022 : 0x06020000);
+        return;
+    }
+
+    transfer_.clear();
+    transferSize_ = (data[0] & 0x02) ? readLe32(&data[4]) : 0;
+    transfer_.reserve(transferSize_ + 7);
+    blockSize_ = config_.blockSize;
+    lastSeq_ = 0;
+    lastSegmentSeen_ = false;
+    // FD segments are padded to a valid FD length, the transfer is cut at the announced size
+    fdTransfer_ = fd && config_.fdFrameLength > 8 && transferSize_ != 0;
+    sdoState_ = SDO_BLOCK_DOWNLOAD;
+
+    // A4: server checks the CRC, blksize in byte 4, FD frame length in byte 5
+    uint8_t response[8] = {0xA4, data[1], data[2], data[3], blockSize_,
+                           static_cast<uint8_t>(fdTransfer_ ? config_.fdFrameLength : 0), 0, 0};
+    respond(response);
+}
+
+void SimNode::blockDownloadSegment(const uint8_t* data, size_t length, Clock::time_point now) {
+    uint8_t seq = data[0] & 0x7F;
+    bool last = (data[0] & 0x80) != 0;
+
+    // Segments after a gap are dropped, the client resends them after the ack
+    if (seq == lastSeq_ + 1) {
+        transfer_.insert(transfer_.end(), &data[1], &data[length]);
+        lastSeq_ = seq;
+        lastSegmentSeen_ = last;
+    }
+
+    if (last || seq >= blockSize_) {
+        acknowledgeBlock();
+    } else {
+        blockGapAt_ = now + std::chrono::milliseconds(config_.blockTimeoutMs);
+    }
+}
+
+void SimNode::acknowledgeBlock() {
+    blockGapAt_ = Clock::time_point::max();
+    uint8_t response[8] = {0xA2, lastSeq_, blockSize_, 0, 0, 0, 0, 0};
+    respond(response);
+    lastSeq_ = 0;
+    if (lastSegmentSeen_) {
+        sdoState_ = SDO_BLOCK_DOWNLOAD_END;
+    }
+}
+
+void SimNode::endBlockDownload(const uint8_t* data, Clock::time_point now) {
+    size_t unused = (data[0] >> 2) & 0x07;
+    transfer_.resize(transfer_.size() >= unused ? transfer_.size() - unused : 0);
+    if (fdTransfer_ && transfer_.size() > transferSize_) {
+        transfer_.resize(transferSize_);
+    }
+    sdoState_ = SDO_IDLE;
+
+    if (transferSize_ != 0 && transfer_.size() != transferSize_) {
+        abort(sdoIndex_, sdoSubindex_, 0x06070010);
+        return;
+    }
+    uint16_t crc = data[1] | (data[2] << 8);
+    if (crc != Crc16::compute(transfer_.data(), transfer_.size())) {
+        abort(sdoIndex_, sdoSubindex_, 0x05040004);  // CRC error
+        return;
+    }
+    uint32_t code = writeObject(sdoIndex_, sdoSubindex_, transfer_, now);
+    if (code != 0) {
+        abort(sdoIndex_, sdoSubindex_, code);
+        return;
+    }
+    uint8_t response[8] = {0xA1, 0, 0, 0, 0, 0, 0, 0};
+    respond(response);
+}
+
+void SimNode::initiateBlockUpload(const uint8_t* data) {
+    uint8_t blockSize = data[4];
+    if (blockSize < 1 || blockSize > 127) {
+        abort(sdoIndex_, sdoSubindex_, 0x05040002);  // Invalid block size
+        return;
+    }
+    std::vector<uint8_t> value;
+    uint32_t code = readObject(sdoIndex_, sdoSubindex_, value);
+    if (code != 0) {
+        abort(sdoIndex_, sdoSubindex_, code);
+        return;
+    }
+
+    transfer_ = value;
+    transferOffset_ = 0;  // Acknowledged segments
+    blockSize_ = blockSize;
+    sdoState_ = SDO_BLOCK_UPLOAD_START;
+
+    // C6: server sends a CRC, size indicated
+    uint8_t response[8] = {0xC6, data[1], data[2], data[3], 0, 0, 0, 0};
+    writeLe32(&response[4], static_cast<uint32_t>(transfer_.size()));
+    respond(response);
+}
+
+void SimNode::sendUploadBlock() {
+    size_t totalSegments = std::max<size_t>(1, (transfer_.size() + 6) / 7);
+    blockSegments_ = 0;
+    for (uint8_t seq = 1; seq <= blockSize_; seq++) {
+        size_t segment = transferOffset_ + seq - 1;
+        if (segment >= totalSegments) {
+            break;
+        }
+        size_t offset = segment * 7;
+        size_t chunk = std::min(transfer_.size() - std::min(offset, transfer_.size()), size_t(7));
+        bool last = segment == totalSegments - 1;
+
+        uint8_t frame[8] = {0};
+        frame[0] = static_cast<uint8_t>(seq | (last ? 0x80 : 0x00));
+        if (chunk > 0) {
+            std::memcpy(&frame[1], &transfer_[offset], chunk);
+        }
+        respond(frame);
+        blockSegments_ = seq;
+        if (last) {
+            break;
+        }
+    }
+    sdoState_ = SDO_BLOCK_UPLOAD;
+}
+
+void SimNode::blockUploadAck(const uint8_t* data) {
+    uint8_t ackSeq = data[1];
+    if (ackSeq > blockSegments_) {
+        abort(sdoIndex_, sdoSubindex_, 0x05040003);  // Invalid sequence number
+        return;
+    }
+    transferOffset_ += ackSeq;
+
+    size_t totalSegments = std::max<size_t>(1, (transfer_.size() + 6) / 7);
+    if (transferOffset_ >= totalSegments) {
+        size_t remainder = transfer_.size() % 7;
+        size_t unused = transfer_.empty() ? 7 : (remainder == 0 ? 0 : 7 - remainder);
+        uint16_t crc = Crc16::compute(transfer_.data(), transfer_.size());
+        uint8_t response[8] = {static_cast<uint8_t>(0xC1 | (unused << 2)),
+                               static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8), 0, 0, 0, 0, 0};
+        sdoState_ = SDO_BLOCK_UPLOAD_END;
+        respond(response);
+        return;
+    }
+
+    if (data[2] < 1 || data[2] > 127) {
+        abort(sdoIndex_, sdoSubindex_, 0x05040002);
+        return;
+    }
+    blockSize_ = data[2];
+    sendUploadBlock();
+}
+
+uint32_t SimNode::readObject(uint16_t index, uint8_t subindex, std::vector<uint8_t>& value) {
+    // Identity objects are answered by the application and the bootloader alike
+    switch (index) {
+        case 0x1009:
+            if (subindex == 0) {
+                value.assign(config_.hardwareVersion, config_.hardwareVersion + 4);
+            } else if (subindex <= 4) {
+                value.assign(1, config_.hardwareVersion[subindex - 1]);
+            } else {
+                return 0x06090011;  // Subindex does not exist
+            }
+            return 0;
+        case 0x100A:
+            if (subindex != 0) {
+                return 0x06090011;
+            }
+            value.assign(config_.softwareVersion.begin(), config_.softwareVersion.end());
+            return 0;
+        case 0x1018: {
+            const uint32_t identity[5] = {4, config_.vendorId, config_.productCode, config_.revision, config_.serialNumber};
+            if (subindex > 4) {
+                return 0x06090011;
+            }
+            value = subindex == 0 ? std::vector<uint8_t>(1, 4) : le32(identity[subindex]);
+            return 0;
+        }
+        default:
+            break;
+    }
+
+    if (mode_ == BOOTLOADER) {
+        if (index == 0x1000 && subindex == 0) {
+            value = le32(0);
+            return 0;
+        }
+        if (index == 0x1F50 && subindex == 1) {
+            if (image_.empty()) {
+                return 0x08000024;  // No data available
+            }
+            value = image_;
+            return 0;
+        }
+        return 0x06020000;  // Object does not exist
+    }
+
+    const SimObject* object = dictionary_.find(index, subindex);
+    if (object == NULL) {
+        return dictionary_.hasObject(index) ? 0x06090011 : 0x06020000;
+    }
+    if (!object->readable) {
+        return 0x06010001;  // Write only object
+    }
+    value = values_[SimDictionary::key(index, subindex)];
+    return 0;
+}
+
+uint32_t SimNode::writeObject(uint16_t index, uint8_t subindex, const std::vector<uint8_t>& value, Clock::time_point now) {
+    if (mode_ == BOOTLOADER) {
+        if (index != 0x1F50 || subindex > 1) {
+            return 0x06020000;
+        }
+        image_ = value;
+        imagePending_ = true;
+        bootIdleAt_ = now + std::chrono::milliseconds(config_.bootIdleMs);
+        std::cout << "Node " << std::dec << nodeId_ << " received image of " << image_.size() << " bytes" << std::endl;
+        return 0;
+    }
+
+    // ESDO: "updt" to 0x4040 restarts into the bootloader under the same node ID
+    if (index == 0x4040 && subindex == 0) {
+        if (!isSignature(value, "updt")) {
+            return 0x08000020;  // Data cannot be transferred
+        }
+        reset(BOOTLOADER, now);
+        return 0;
+    }
+    if (index == 0x1010 && subindex >= 1 && subindex <= 3) {
+        if (!isSignature(value, "save")) {
+            return 0x08000020;
+        }
+        stored_ = values_;
+        storedNodeId_ = values_[SimDictionary::key(0x2001, 1)][0];
+        return 0;
+    }
+    if (index == 0x1011 && subindex >= 1 && subindex <= 3) {
+        if (!isSignature(value, "load")) {
+            return 0x08000020;
+        }
+        stored_.clear();
+        return 0;
+    }
+
+    const SimObject* object = dictionary_.find(index, subindex);
+    if (object == NULL) {
+        return dictionary_.hasObject(index) ? 0x06090011 : 0x06020000;
+    }
+    if (!object->writable) {
+        return 0x06010002;  // Read only object
+    }
+    if (object->size != 0 && value.size() != object->size) {
+        return value.size() > object->size ? 0x06070012 : 0x06070013;  // Length too high / too low
+    }
+    if (object->hasLimits && object->size != 0 && object->size <= 8) {
+        uint64_t raw = 0;
+        for (size_t i = 0; i < value.size(); i++) {
+            raw |= static_cast<uint64_t>(value[i]) << (8 * i);
+        }
+        int64_t number = static_cast<int64_t>(raw);
+        if (SimDictionary::isSigned(object->dataType) && object->size < 8 && (raw >> (8 * object->size - 1)) & 1) {
+            number = static_cast<int64_t>(raw | (~0ULL << (8 * object->size)));  // Sign extend
+        }
+        if (number > object->highLimit) {
+            return 0x06090031;  // Value too high
+        }
+        if (number < object->lowLimit) {
+            return 0x06090032;  // Value too low
+        }
+    }
+
+    values_[SimDictionary::key(index, subindex)] = value;
+    if (index == 0x1017) {
+        int period = heartbeatMs();
+        nextHeartbeat_ = period > 0 ? now + std::chrono::milliseconds(period) : Clock::time_point::max();
+    }
+    return 0;
+}
+
+void SimNode::respond(const uint8_t* data) {
+    struct can_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
+    frame.can_id = 0x580 + nodeId_;
+    frame.can_dlc = 8;
+    std::memcpy(frame.data, data, 8);
+    send_(frame);
+}
+
+void SimNode::abort(uint16_t index, uint8_t subindex, uint32_t code) {
+    sdoState_ = SDO_IDLE;
+    blockGapAt_ = Clock::time_point::max();
+    uint8_t response[8] = {0x80, static_cast<uint8_t>(index & 0xFF), static_cast<uint8_t>(index >> 8), subindex, 0, 0, 0, 0};
+    writeLe32(&response[4], code);
+    respond(response);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "sim_dictionary.hpp"
+#include <linux/can.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct SimNodeConfig {
+    int nodeId;
+    uint8_t hardwareVersion[4];   // 0x1009, read as one byte per subindex
+    std::string softwareVersion;  // 0x100A
+    uint32_t vendorId;            // 0x1018
+    uint32_t productCode;
+    uint32_t revision;
+    uint32_t serialNumber;
+    int heartbeatMs;              // Producer heartbeat after boot, 0 keeps the EDS default
+    int bootMs;                   // Silence between a reset and the boot-up message
+    int bootIdleMs;               // Bootloader starts the application after this much SDO silence
+    int blockTimeoutMs;           // Acknowledge a block whose tail was lost after this gap
+    uint8_t blockSize;            // Segments per block offered to block download clients
+    uint8_t fdFrameLength;        // CAN FD block download segment length offered to FD clients, 0 for classic only
+
+    SimNodeConfig()
+        : nodeId(1), vendorId(0x00000001), productCode(0), revision(0), serialNumber(0x78AA654A),
+          heartbeatMs(0), bootMs(200), bootIdleMs(500), blockTimeoutMs(50), blockSize(127), fdFrameLength(64) {
+        hardwareVersion[0] = 0x10;
+        hardwareVersion[1] = 0x00;
+        hardwareVersion[2] = 0x30;
+        hardwareVersion[3] = 0x01;
+        softwareVersion = "25032601";
+    }
+};
+
+// One simulated drive: application with the EDS object dictionary, and the
+// ESDO bootloader entered by writing "updt" to 0x4040. The bootloader takes
+// the image by SDO block download into 0x1F50/1, serves it back by block
+// upload, then starts the freshly flashed application with factory settings
+// under node ID 126, where the tool renumbers it through 0x2001/1.
+// A block download initiated by a CAN FD frame may continue in FD segments
+// of up to 63 data bytes; the server offers its frame length in byte 5 of
+// the initiate response. Responses are always classic frames.
+class SimNode {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void(const struct can_frame& frame)> SendFn;
+
+    SimNode(const SimDictionary& dictionary, const SimNodeConfig& config, const SendFn& send);
+
+    void powerOn(Clock::time_point now);
+    // fd tells whether the frame arrived as a CAN FD frame, classic frames use the can_frame prefix
+    void handleFrame(const struct canfd_frame& frame, bool fd, Clock::time_point now);
+    void poll(Clock::time_point now);
+    Clock::time_point nextEvent() const;
+
+    int nodeId() const { return nodeId_; }
+    size_t imageSize() const { return image_.size(); }
+
+private:
+    enum Mode {
+        BOOTING,      // Reset in progress, deaf until the boot-up message
+        APPLICATION,
+        BOOTLOADER
+    };
+
+    enum SdoState {
+        SDO_IDLE,
+        SDO_DOWNLOAD_SEGMENT,
+        SDO_UPLOAD_SEGMENT,
+        SDO_BLOCK_DOWNLOAD,      // Receiving sub-blocks
+        SDO_BLOCK_DOWNLOAD_END,  // All segments in, waiting for the end request
+        SDO_BLOCK_UPLOAD_START,  // Initiate answered, waiting for the start request
+        SDO_BLOCK_UPLOAD,        // Block sent, waiting for its acknowledge
+        SDO_BLOCK_UPLOAD_END     // End sent, waiting for the client's confirmation
+    };
+
+    const SimDictionary& dictionary_;
+    SimNodeConfig config_;
+    SendFn send_;
+
+    Mode mode_;
+    Mode bootInto_;
+    int nodeId_;
+    int storedNodeId_;                 // Takes effect at the next reset
+    uint8_t nmtState_;                 // Heartbeat state byte
+    SimDictionary::Values values_;
+    SimDictionary::Values stored_;     // Saved by 0x1010, survives resets
+    std::vector<uint8_t> image_;       // Last image flashed into 0x1F50/1
+
+    Clock::time_point bootAt_;
+    Clock::time_point nextHeartbeat_;
+    Clock::time_point bootIdleAt_;
+    Clock::time_point blockGapAt_;
+    bool imagePending_;                // Downloaded, application not started yet
+
+    // SDO server transfer in progress
+    SdoState sdoState_;
+    uint16_t sdoIndex_;
+    uint8_t sdoSubindex_;
+    uint8_t toggle_;
+    std::vector<uint8_t> transfer_;
+    size_t transferSize_;
+    size_t transferOffset_;
+    uint8_t blockSize_;
+    uint8_t lastSeq_;                  // Last in-order segment of the current block
+    bool lastSegmentSeen_;
+    bool fdTransfer_;                  // Block download segments come as FD frames
+    uint8_t blockSegments_;            // Segments sent in the current upload block
+
+    void reset(Mode mode, Clock::time_point now);
+    void boot(Clock::time_point now);
+    int heartbeatMs() const;
+    void sendHeartbeat(uint8_t state);
+    void handleNmt(const struct canfd_frame& frame, Clock::time_point now);
+    void handleSdo(const struct canfd_frame& frame, bool fd, Clock::time_point now);
+
+    void initiateDownload(const uint8_t* data, Clock::time_point now);
+    void downloadSegment(const uint8_t* data, Clock::time_point now);
+    void initiateUpload(const uint8_t* data);
+    void uploadSegment(const uint8_t* data);
+    void initiateBlockDownload(const uint8_t* data, bool fd);
+    void blockDownloadSegment(const uint8_t* data, size_t length, Clock::time_point now);
+    void acknowledgeBlock();
+    void endBlockDownload(const uint8_t* data, Clock::time_point now);
+    void initiateBlockUpload(const uint8_t* data);
+    void sendUploadBlock();
+    void blockUploadAck(const uint8_t* data);
+
+    uint32_t readObject(uint16_t index, uint8_t subindex, std::vector<uint8_t>& value);
+    uint32_t writeObject(uint16_t index, uint8_t subindex, const std::vector<uint8_t>& value, Clock::time_point now);
+    void respond(const uint8_t* data);
+    void abort(uint16_t index, uint8_t subindex, uint32_t code);
+};
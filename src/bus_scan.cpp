@@ -0,0 +1,302 @@
+#include "bus_scan.hpp"
+#include "flow_od.hpp"
+#include "sdo_client.hpp"
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int NODE_COUNT = 127;
+// Give up when the TX queue takes no request for this long
+static const int SEND_STALL_MS = 1000;
+
+static int msUntil(Clock::time_point deadline) {
+    Clock::duration left = deadline - Clock::now();
+    return left <= Clock::duration::zero()
+               ? 0 : static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(left).count()) + 1;
+}
+
+static bool entryLess(const ScanEntry& a, const ScanEntry& b) {
+    return a.canInterface != b.canInterface ? a.canInterface < b.canInterface : a.nodeId < b.nodeId;
+}
+
+static const char* nmtStateName(int state) {
+    switch (state) {
+        case 0x00: return "boot-up";
+        case 0x04: return "stopped";
+        case 0x05: return "operational";
+        case 0x7F: return "pre-operational";
+        default: return "-";
+    }
+}
+
+static std::string hex32(bool valid, uint32_t value) {
+    if (!valid) {
+        return "-";
+    }
+    char text[11];
+    std::snprintf(text, sizeof(text), "0x%08x", value);
+    return text;
+}
+
+// Raw socket receiving SDO responses and heartbeats of all nodes
+static int openScanSocket(const std::string& canInterface) {
+    int sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (sock < 0) {
+        std::cerr << "Error while opening socket" << std::endl;
+        return -1;
+    }
+
+    struct ifreq ifr;
+    std::strncpy(ifr.ifr_name, canInterface.c_str(), IFNAMSIZ - 1);
+    ifr.ifr_name[IFNAMSIZ - 1] = '\0';
+    if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0) {
+        std::cerr << "Error getting interface index of " << canInterface << std::endl;
+        close(sock);
+        return -1;
+    }
+
+    struct sockaddr_can addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        std::cerr << "Error in socket bind" << std::endl;
+        close(sock);
+        return -1;
+    }
+
+    // 0x581..0x5FF and 0x701..0x77F, standard data frames only
+    struct can_filter rfilter[2];
+    rfilter[0].can_id = 0x580;
+    rfilter[0].can_mask = 0x780 | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    rfilter[1].can_id = 0x700;
+    rfilter[1].can_mask = 0x780 | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    if (setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, &rfilter, sizeof(rfilter)) < 0) {
+        std::cerr << "Error setting CAN filter" << std::endl;
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool BusScanner::scan(const std::vector<std::string>& canInterfaces, std::vector<ScanEntry>& entries) {
+    std::vector<std::vector<ScanEntry> > found(canInterfaces.size());
+    std::vector<char> ok(canInterfaces.size(), 0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < canInterfaces.size(); i++) {
+        workers.push_back(std::thread([this, &canInterfaces, &found, &ok, i]() {
+            ok[i] = scanBus(canInterfaces[i], found[i]);
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    entries.clear();
+    bool success = true;
+    for (size_t i = 0; i < found.size(); i++) {
+        entries.insert(entries.end(), found[i].begin(), found[i].end());
+        success = success && ok[i];
+    }
+    std::sort(entries.begin(), entries.end(), entryLess);
+    return success;
+}
+
+bool BusScanner::scanBus(const std::string& canInterface, std::vector<ScanEntry>& entries) {
+    Clock::time_point start = Clock::now();
+    if (!discover(canInterface, entries)) {
+        return false;
+    }
+    Clock::time_point discovered = Clock::now();
+    readIdentities(canInterface, entries);
+
+    std::ostringstream report;
+    report << canInterface << ": " << entries.size() << " nodes found in "
+           << std::chrono::duration_cast<std::chrono::milliseconds>(discovered - start).count()
+           << " ms, identities read in "
+           << std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - discovered).count() << " ms";
+    std::cout << report.str() << std::endl;
+    return true;
+}
+
+bool BusScanner::discover(const std::string& canInterface, std::vector<ScanEntry>& entries) {
+    int sock = openScanSocket(canInterface);
+    if (sock < 0) {
+        return false;
+    }
+
+    // Device type upload to every node ID, handed to the kernel in as few calls as the TX queue allows
+    static constexpr od::SdoFrame DEVICE_TYPE = od::sdoUpload(od::DeviceType);
+    struct can_frame requests[NODE_COUNT];
+    struct mmsghdr msgs[NODE_COUNT];
+    struct iovec iovs[NODE_COUNT];
+    std::memset(requests, 0, sizeof(requests));
+    std::memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < NODE_COUNT; i++) {
+        requests[i].can_id = 0x600 + i + 1;
+        requests[i].can_dlc = 8;
+        std::memcpy(requests[i].data, DEVICE_TYPE.data, 8);
+        iovs[i].iov_base = &requests[i];
+        iovs[i].iov_len = sizeof(struct can_frame);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    ScanEntry nodes[NODE_COUNT + 1];
+    int sent = 0;
+    Clock::time_point lastProgress = Clock::now();
+    Clock::time_point deadline = lastProgress;
+    bool success = true;
+
+    for (;;) {
+        if (sent < NODE_COUNT) {
+            int ret = sendmmsg(sock, &msgs[sent], NODE_COUNT - sent, MSG_DONTWAIT);
+            if (ret > 0) {
+                sent += ret;
+                lastProgress = Clock::now();
+                // The window starts once the last request is out
+                if (sent == NODE_COUNT) {
+                    deadline = lastProgress + std::chrono::milliseconds(windowMs_);
+                }
+            } else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS && errno != EINTR) {
+                std::cerr << "Error in sending scan requests on " << canInterface << ": " << strerror(errno)
+                          << std::endl;
+                success = false;
+                break;
+            } else if (Clock::now() - lastProgress > std::chrono::milliseconds(SEND_STALL_MS)) {
+                std::cerr << "Timeout waiting for room in the TX queue of " << canInterface << std::endl;
+                success = false;
+                break;
+            }
+        }
+
+        // While requests are left, come back soon to refill the TX queue; ENOBUFS is not signalled by POLLOUT
+        int waitMs = sent < NODE_COUNT ? 1 : msUntil(deadline);
+        if (sent == NODE_COUNT && waitMs == 0) {
+            break;
+        }
+        struct pollfd pfd;
+        pfd.fd = sock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, waitMs) <= 0) {
+            continue;
+        }
+
+        struct can_frame frame;
+        while (recv(sock, &frame, sizeof(frame), MSG_DONTWAIT) == static_cast<ssize_t>(sizeof(frame))) {
+            canid_t cobId = frame.can_id & CAN_SFF_MASK;
+            int nodeId = cobId & 0x7F;
+            if (nodeId == 0) {
+                continue;
+            }
+            ScanEntry& node = nodes[nodeId];
+            if ((cobId & 0x780) == 0x580) {
+                // Only the reply to our upload of 0x1000/0
+                if (frame.can_dlc != 8 || frame.data[1] != (od::DeviceType.index & 0xFF) ||
+                    frame.data[2] != (od::DeviceType.index >> 8) || frame.data[3] != od::DeviceType.subindex) {
+                    continue;
+                }
+                node.answered = true;
+                if ((frame.data[0] & 0xE2) == 0x42) {
+                    size_t size = (frame.data[0] & 0x01) ? 4 - ((frame.data[0] >> 2) & 0x03) : 4;
+                    node.deviceType = 0;
+                    for (size_t i = 0; i < size; i++) {
+                        node.deviceType |= static_cast<uint32_t>(frame.data[4 + i]) << (i * 8);
+                    }
+                    node.hasDeviceType = true;
+                }
+            } else if (frame.can_dlc >= 1) {
+                node.nmtState = frame.data[0] & 0x7F;
+            }
+        }
+    }
+    close(sock);
+
+    for (int id = 1; id <= NODE_COUNT; id++) {
+        if (nodes[id].answered || nodes[id].nmtState >= 0) {
+            nodes[id].canInterface = canInterface;
+            nodes[id].nodeId = id;
+            entries.push_back(nodes[id]);
+        }
+    }
+    return success;
+}
+
+void BusScanner::readIdentities(const std::string& canInterface, std::vector<ScanEntry>& entries) {
+    AsyncSdoClient client;
+    if (!client.open(canInterface)) {
+        std::cerr << "Not reading identities on " << canInterface << std::endl;
+        return;
+    }
+
+    // One worker per node; the client overlaps their transactions on the bus
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!entries[i].hasDeviceType) {
+            continue;  // Silent or aborting nodes would only run into timeouts
+        }
+        workers.push_back(std::thread([&client, &entries, i]() {
+            ScanEntry& entry = entries[i];
+            DeviceIdentity part;
+            // Bootloaders often lack some objects, keep whatever parts can be read
+            if (readDeviceIdentity(client, entry.nodeId, part, IDENTITY_HARDWARE)) {
+                entry.identity.hardwareVersion = part.hardwareVersion;
+                entry.identity.fields |= IDENTITY_HARDWARE;
+            }
+            if (readDeviceIdentity(client, entry.nodeId, part, IDENTITY_OBJECT)) {
+                entry.identity.vendorId = part.vendorId;
+                entry.identity.productCode = part.productCode;
+                entry.identity.revision = part.revision;
+                entry.identity.serialNumber = part.serialNumber;
+                entry.identity.fields |= IDENTITY_OBJECT;
+            }
+            if (readDeviceIdentity(client, entry.nodeId, part, IDENTITY_SOFTWARE)) {
+                entry.identity.softwareVersion = part.softwareVersion;
+                entry.identity.fields |= IDENTITY_SOFTWARE;
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    client.close();
+}
+
+void BusScanner::printInventory(const std::vector<ScanEntry>& entries, std::ostream& out) {
+    out << std::left << std::setw(10) << "Bus" << std::setw(6) << "Node" << std::setw(12) << "DeviceType"
+        << std::setw(12) << "Vendor" << std::setw(12) << "Product" << std::setw(12) << "Revision"
+        << std::setw(12) << "Serial" << std::setw(13) << "Hardware" << std::setw(16) << "State"
+        << "Software" << std::endl;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const ScanEntry& entry = entries[i];
+        const DeviceIdentity& identity = entry.identity;
+        bool object = (identity.fields & IDENTITY_OBJECT) != 0;
+        out << std::left << std::setw(10) << entry.canInterface << std::setw(6) << entry.nodeId
+            << std::setw(12) << hex32(entry.hasDeviceType, entry.deviceType)
+            << std::setw(12) << hex32(object, identity.vendorId)
+            << std::setw(12) << hex32(object, identity.productCode)
+            << std::setw(12) << hex32(object, identity.revision)
+            << std::setw(12) << hex32(object, identity.serialNumber)
+            << std::setw(13) << ((identity.fields & IDENTITY_HARDWARE) ? identity.hardwareVersion : "-")
+            << std::setw(16) << nmtStateName(entry.nmtState)
+            << ((identity.fields & IDENTITY_SOFTWARE) ? identity.softwareVersion : "-") << std::endl;
+    }
+    out << std::right;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "device_identity.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One node found on a bus
+struct ScanEntry {
+    std::string canInterface;
+    int nodeId;
+    bool answered;            // Replied to the device type upload, abort or not
+    uint32_t deviceType;      // 0x1000, valid if answered without abort
+    bool hasDeviceType;
+    int nmtState;             // From the last boot-up or heartbeat, -1 if none was seen
+    DeviceIdentity identity;  // identity.fields tells what could be read
+
+    ScanEntry() : nodeId(0), answered(false), deviceType(0), hasDeviceType(false), nmtState(-1) {}
+};
+
+// Finds the nodes on CAN buses without knowing their IDs. Device type
+// (0x1000) uploads go out to all 127 IDs in one batch and every reply,
+// boot-up and heartbeat within a short window is collected, so a bus costs
+// the window plus the identity reads of the nodes found rather than 127
+// SDO timeouts. Identities are read through an AsyncSdoClient, all nodes
+// of a bus at the same time.
+class BusScanner {
+public:
+    BusScanner() : windowMs_(200) {}
+
+    // How long to collect replies after the requests went out
+    void setWindow(int windowMs) { windowMs_ = windowMs; }
+
+    // Buses are scanned in parallel, one thread each; entries come sorted by bus and node
+    bool scan(const std::vector<std::string>& canInterfaces, std::vector<ScanEntry>& entries);
+
+    static void printInventory(const std::vector<ScanEntry>& entries, std::ostream& out);
+
+private:
+    int windowMs_;
+
+    bool scanBus(const std::string& canInterface, std::vector<ScanEntry>& entries);
+    bool discover(const std::string& canInterface, std::vector<ScanEntry>& entries);
+    void readIdentities(const std::string& canInterface, std::vector<ScanEntry>& entries);
+};
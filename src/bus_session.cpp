@@ -0,0 +1,260 @@
+#include "bus_session.hpp"
+#include <linux/can/raw.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <iostream>
+#include <map>
+#include <cstring>
+
+// More nodes than this on one function code share a single masked filter entry
+static const int COLLAPSE_NODES = 8;
+static const canid_t FUNCTION_CODE_MASK = 0x780;
+
+// Function codes (COB-ID of node 0) of each class, in CobClass bit order
+static const canid_t NMT_CODES[] = {0x000};
+static const canid_t EMCY_CODES[] = {0x080};
+static const canid_t PDO_CODES[] = {0x180, 0x200, 0x280, 0x300, 0x380, 0x400, 0x480, 0x500};
+static const canid_t SDO_RESPONSE_CODES[] = {0x580};
+static const canid_t SDO_REQUEST_CODES[] = {0x600};
+static const canid_t HEARTBEAT_CODES[] = {0x700};
+
+struct ClassCodes {
+    const canid_t* codes;
+    size_t count;
+};
+
+static const ClassCodes CLASS_CODES[] = {
+    {NMT_CODES, 1},
+    {EMCY_CODES, 1},
+    {PDO_CODES, 8},
+    {SDO_RESPONSE_CODES, 1},
+    {SDO_REQUEST_CODES, 1},
+    {HEARTBEAT_CODES, 1},
+};
+
+// Sessions stay registered while anybody holds them
+static std::mutex registryMutex;
+static std::map<std::string, std::weak_ptr<BusSession> > registry;
+
+std::shared_ptr<BusSession> BusSession::open(const std::string& canInterface) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::shared_ptr<BusSession> session = registry[canInterface].lock();
+    if (session) {
+        return session;
+    }
+    session.reset(new BusSession());
+    if (!session->create(canInterface)) {
+        return std::shared_ptr<BusSession>();
+    }
+    registry[canInterface] = session;
+    return session;
+}
+
+BusSession::BusSession()
+    : socket_(-1), fdEnabled_(false), timestamping_(false), recorder_(NULL), rxTap_(NULL) {
+    std::memset(subscribers_, 0, sizeof(subscribers_));
+}
+
+BusSession::~BusSession() {
+    close();
+}
+
+bool BusSession::create(const std::string& canInterface) {
+    struct sockaddr_can addr;
+    struct ifreq ifr;
+
+    name_ = canInterface;
+    socket_ = ::socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (socket_ < 0) {
+        std::cerr << "Error while opening socket" << std::endl;
+        return false;
+    }
+
+    // Nothing is received until the first subscription
+    if (setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FILTER, NULL, 0) < 0) {
+        std::cerr << "Error setting CAN filter" << std::endl;
+        close();
+        return false;
+    }
+
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, canInterface.c_str(), IFNAMSIZ - 1);
+    if (ioctl(socket_, SIOCGIFINDEX, &ifr) < 0) {
+        std::cerr << "Error getting interface index" << std::endl;
+        close();
+        return false;
+    }
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(socket_, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        std::cerr << "Error in socket bind" << std::endl;
+        close();
+        return false;
+    }
+
+    // From here on all frames are read by the demux thread
+    if (!demux_.start(socket_)) {
+        close();
+        return false;
+    }
+
+    // NMT resets sent by other masters retire cached identities, whoever else listens
+    if (!addFilter(0, COB_NMT)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BusSession::close() {
+    demux_.stop();
+    if (recorder_ != NULL) {
+        recorder_->releaseTap(rxTap_);
+        recorder_ = NULL;
+        rxTap_ = NULL;
+    }
+    if (socket_ >= 0) {
+        ::close(socket_);
+        socket_ = -1;
+    }
+}
+
+void BusSession::setRecorder(FrameRecorder* recorder) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recorder == recorder_) {
+        return;
+    }
+    FrameRecorder::Tap* tap = recorder != NULL ? recorder->acquireTap(name_) : NULL;
+    demux_.setTap(tap);
+    if (recorder_ != NULL) {
+        recorder_->releaseTap(rxTap_);
+    }
+    recorder_ = recorder;
+    rxTap_ = tap;
+}
+
+bool BusSession::enableFd() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fdEnabled_) {
+        return true;
+    }
+    // Only an interface configured for FD (MTU 72) can carry FD frames
+    struct ifreq ifr;
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, name_.c_str(), IFNAMSIZ - 1);
+    if (ioctl(socket_, SIOCGIFMTU, &ifr) < 0 || ifr.ifr_mtu != static_cast<int>(CANFD_MTU)) {
+        return false;
+    }
+    int enable = 1;
+    fdEnabled_ = setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) == 0;
+    return fdEnabled_;
+}
+
+bool BusSession::enableTimestamping() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timestamping_) {
+        return true;
+    }
+    // Software stamps: RX when the frame enters the stack, TX when the driver
+    // takes it (reported on the error queue together with a copy of the frame)
+    int flags = SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE;
+    timestamping_ = setsockopt(socket_, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+    return timestamping_;
+}
+
+bool BusSession::addFilter(int nodeId, unsigned int classes) {
+    return update(std::vector<int>(1, nodeId), classes, true);
+}
+
+bool BusSession::addFilter(const std::vector<int>& nodeIds, unsigned int classes) {
+    return update(nodeIds, classes, true);
+}
+
+bool BusSession::removeFilter(int nodeId, unsigned int classes) {
+    return update(std::vector<int>(1, nodeId), classes, false);
+}
+
+bool BusSession::removeFilter(const std::vector<int>& nodeIds, unsigned int classes) {
+    return update(nodeIds, classes, false);
+}
+
+size_t BusSession::filterCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return applied_.size();
+}
+
+bool BusSession::update(const std::vector<int>& nodeIds, unsigned int classes, bool add) {
+    bool nodeSpecific = (classes & ~static_cast<unsigned int>(COB_NMT)) != 0;
+    for (size_t i = 0; i < nodeIds.size() && nodeSpecific; i++) {
+        if (nodeIds[i] < 1 || nodeIds[i] > 127) {
+            std::cerr << "Invalid node ID for CAN filter: " << nodeIds[i] << std::endl;
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        if (!(classes & (1u << c))) {
+            continue;
+        }
+        for (size_t i = 0; i < nodeIds.size(); i++) {
+            // NMT is a broadcast, count it under node 0
+            uint16_t& count = subscribers_[c][(1u << c) == COB_NMT ? 0 : nodeIds[i]];
+            if (add) {
+                count++;
+            } else if (count > 0) {
+                count--;
+            }
+        }
+    }
+    return applyFilters();
+}
+
+bool BusSession::applyFilters() {
+    std::vector<struct can_filter> filters;
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        const ClassCodes& codes = CLASS_CODES[c];
+        int nodes = 0;
+        for (int node = 0; node < 128; node++) {
+            nodes += subscribers_[c][node] > 0;
+        }
+        if (nodes == 0) {
+            continue;
+        }
+        for (size_t k = 0; k < codes.count; k++) {
+            struct can_filter filter;
+            if (nodes > COLLAPSE_NODES) {
+                // The demux drops what nobody routed, so a wider filter only costs a few unrouted frames
+                filter.can_id = codes.codes[k];
+                filter.can_mask = FUNCTION_CODE_MASK;
+                filters.push_back(filter);
+                continue;
+            }
+            for (int node = 0; node < 128; node++) {
+                if (subscribers_[c][node] > 0) {
+                    filter.can_id = codes.codes[k] + node;
+                    filter.can_mask = CAN_SFF_MASK;  // Standard frame mask
+                    filters.push_back(filter);
+                }
+            }
+        }
+    }
+
+    // Replacing the kernel filter is cheap but not free, skip it when nothing changed
+    if (filters.size() == applied_.size() &&
+        (filters.empty() || std::memcmp(filters.data(), applied_.data(), filters.size() * sizeof(struct can_filter)) == 0)) {
+        return true;
+    }
+    if (setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FILTER, filters.empty() ? NULL : filters.data(),
+                   filters.size() * sizeof(struct can_filter)) < 0) {
+        std::cerr << "Error setting CAN filter" << std::endl;
+        return false;
+    }
+    applied_.swap(filters);
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "device_identity.hpp"
+#include "frame_demux.hpp"
+#include "frame_recorder.hpp"
+#include <linux/can.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// COB-ID classes a session can receive, combined as a bit mask
+enum CobClass {
+    COB_NMT          = 0x01,  // 0x000, not node specific
+    COB_EMCY         = 0x02,  // 0x080 + node
+    COB_PDO          = 0x04,  // TPDO1-4 and RPDO1-4, 0x180-0x57F
+    COB_SDO_RESPONSE = 0x08,  // 0x580 + node
+    COB_SDO_REQUEST  = 0x10,  // 0x600 + node
+    COB_HEARTBEAT    = 0x20   // 0x700 + node, boot-up and heartbeat
+};
+
+// One long-lived raw socket per CAN interface, read by a single demux
+// thread and shared by every CanInterface on that bus. Users subscribe to
+// COB-ID classes of node sets; subscriptions are reference counted and the
+// kernel filter is only replaced when the resulting list changes. Function
+// codes wanted for many nodes collapse into one masked filter entry.
+class BusSession {
+public:
+    ~BusSession();
+
+    // The session already open on this interface, or a new one
+    static std::shared_ptr<BusSession> open(const std::string& canInterface);
+
+    const std::string& name() const { return name_; }
+    int socket() const { return socket_; }
+    FrameDemux& demux() { return demux_; }
+    // Node identities read on this bus, retired by boot-up messages the demux counts
+    IdentityCache& identities() { return identities_; }
+
+    // CAN_RAW_FD_FRAMES if the interface has the FD MTU, stays on once enabled
+    bool enableFd();
+    bool isFdEnabled() const { return fdEnabled_; }
+    // Software SO_TIMESTAMPING for RX and TX
+    bool enableTimestamping();
+    // Records every received frame; the recorder must outlive the session
+    void setRecorder(FrameRecorder* recorder);
+
+    bool addFilter(int nodeId, unsigned int classes);
+    bool addFilter(const std::vector<int>& nodeIds, unsigned int classes);
+    bool removeFilter(int nodeId, unsigned int classes);
+    bool removeFilter(const std::vector<int>& nodeIds, unsigned int classes);
+    size_t filterCount() const;
+
+private:
+    static const int CLASS_COUNT = 6;
+
+    std::string name_;
+    int socket_;
+    bool fdEnabled_;
+    bool timestamping_;
+    FrameDemux demux_;
+    IdentityCache identities_;
+    FrameRecorder* recorder_;
+    FrameRecorder::Tap* rxTap_;  // Written by the demux thread only
+    mutable std::mutex mutex_;
+    uint16_t subscribers_[CLASS_COUNT][128];  // Per class and node, NMT uses node 0
+    std::vector<struct can_filter> applied_;
+
+    BusSession();
+    bool create(const std::string& canInterface);
+    void close();
+    bool update(const std::vector<int>& nodeIds, unsigned int classes, bool add);
+    bool applyFilters();
+};
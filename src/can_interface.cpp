@@ -1,131 +1,455 @@
 #include "can_interface.hpp"
+#include "flow_od.hpp"
+#include "latency_trace.hpp"
 #include <iostream>
 #include <cstring>
+#include <chrono>
+#include <cerrno>
+#include <ctime>
+#include <poll.h>
 
-CanInterface::CanInterface() : socket_(-1), nodeId_(0) {}
+// Milliseconds elapsed since the given start point
+static int elapsedMs(const std::chrono::steady_clock::time_point& start) {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+// Same clock the kernel uses for SO_TIMESTAMPING software timestamps
+static uint64_t realtimeNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+// COB-ID classes every CanInterface receives for its node
+static const unsigned int NODE_CLASSES = COB_SDO_RESPONSE | COB_SDO_REQUEST | COB_HEARTBEAT;
+
+CanInterface::CanInterface()
+    : socket_(-1), nodeId_(0), subscribed_(false), tracer_(NULL), recorder_(NULL), txTap_(NULL), fdRequested_(false), fdEnabled_(false), sentNs_(0),
+      sdoIndex_(0), sdoSubindex_(0) {}
 
 CanInterface::~CanInterface() {
     close();
 }
 
 bool CanInterface::initialize(const std::string& canInterface, int id) {
+    // The socket lives as long as the bus session, switching nodes only changes the filter
+    if (!session_ || session_->name() != canInterface) {
+        close();
+        session_ = BusSession::open(canInterface);
+        if (!session_) {
+            return false;
+        }
+        socket_ = session_->socket();
+    }
     canInterface_ = canInterface;
-    nodeId_ = id;
-    return createCanSocket(canInterface, id);
-}
 
-void CanInterface::close() {
-    if (socket_ >= 0) {
-        ::close(socket_);
-        socket_ = -1;
+    fdEnabled_ = fdRequested_ && session_->enableFd();
+    if (fdRequested_ && !fdEnabled_) {
+        std::cerr << "CAN FD not available on " << canInterface << ", using classic frames" << std::endl;
     }
-}
-
-bool CanInterface::createCanSocket(const std::string& canInterface, int id) {
-    struct sockaddr_can addr;
-    struct ifreq ifr;
 
-    // Create socket
-    socket_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-    if (socket_ < 0) {
-        std::cerr << "Error while opening socket" << std::endl;
-        return false;
+    if (tracer_ != NULL && !session_->enableTimestamping()) {
+        std::cerr << "Kernel timestamps unavailable, tracing with host timestamps" << std::endl;
     }
 
-    // Specify CAN interface
-    strcpy(ifr.ifr_name, canInterface.c_str());
-    if (ioctl(socket_, SIOCGIFINDEX, &ifr) < 0) {
-        std::cerr << "Error getting interface index" << std::endl;
-        close();
-        return false;
+    if (recorder_ != NULL) {
+        session_->setRecorder(recorder_);
+        if (txTap_ == NULL) {
+            txTap_ = recorder_->acquireTap(canInterface);
+        }
     }
 
-    // Bind socket to CAN interface
-    addr.can_family = AF_CAN;
-    addr.can_ifindex = ifr.ifr_ifindex;
-    if (bind(socket_, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        std::cerr << "Error in socket bind" << std::endl;
-        close();
-        return false;
+    return setNodeFilter(id);
+}
+
+void CanInterface::close() {
+    if (!session_) {
+        return;
+    }
+    // The demux outlives us when others share the session, make sure it lets go of the inbox
+    session_->demux().detach(&inbox_);
+    if (subscribed_) {
+        session_->removeFilter(nodeId_, NODE_CLASSES);
+        subscribed_ = false;
     }
+    if (txTap_ != NULL) {
+        recorder_->releaseTap(txTap_);
+        txTap_ = NULL;
+    }
+    session_.reset();
+    socket_ = -1;
+}
 
-    // Set up CAN filter to only receive messages with specific IDs
-    struct can_filter rfilter[2];
-    rfilter[0].can_id = (id + 0x500) + 0x80;  // Response ID
-    rfilter[0].can_mask = CAN_SFF_MASK;        // Standard frame mask
-    rfilter[1].can_id = id + 0x600;            // Request ID
-    rfilter[1].can_mask = CAN_SFF_MASK;        // Standard frame mask
+FrameDemux::Stats CanInterface::getRxStats() const {
+    return session_ ? session_->demux().getStats() : FrameDemux::Stats();
+}
 
-    if (setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FILTER, &rfilter, sizeof(rfilter)) < 0) {
-        std::cerr << "Error setting CAN filter" << std::endl;
-        close();
+bool CanInterface::setNodeFilter(int id) {
+    // Subscribe the new node before dropping the old one, so shared entries are not rebuilt twice
+    if (!session_->addFilter(id, NODE_CLASSES)) {
         return false;
     }
+    FrameDemux& demux = session_->demux();
+    if (subscribed_) {
+        session_->removeFilter(nodeId_, NODE_CLASSES);
+        demux.route(nodeId_ + 0x580, NULL);
+        demux.route(nodeId_ + 0x700, NULL);
+    }
+    subscribed_ = true;
+
+    // Hand this node's responses and heartbeats to the inbox
+    nodeId_ = id;
+    demux.route(id + 0x580, &inbox_);
+    demux.route(id + 0x700, &inbox_);
+    demux.expectAnySdoResponse(id);
 
     return true;
 }
 
-bool CanInterface::sendNMTRestart(int id) {
+bool CanInterface::sendNMTCommand(uint8_t command, int id) {
     struct can_frame frame;
     frame.can_id = 0x000;  // NMT command ID
     frame.can_dlc = 2;
-    frame.data[0] = 0x81;  // Restart command
+    frame.data[0] = command;
     frame.data[1] = id;    // Node ID
 
+    uint64_t sentNs = realtimeNs();
     if (write(socket_, &frame, sizeof(struct can_frame)) != sizeof(struct can_frame)) {
+        std::cerr << "Error in sending NMT command" << std::endl;
+        return false;
+    }
+    recordTx(&frame, CAN_MTU, sentNs);
+    // Our own frames are not received back, count resets for the identity cache here
+    if (command == 0x81 || command == 0x82) {
+        session_->demux().noteReset(id);
+    }
+    return true;
+}
+
+bool CanInterface::sendNMTRestart(int id) {
+    if (!sendNMTCommand(0x81, id)) {  // Restart command
         std::cerr << "Error in sending NMT restart command" << std::endl;
         return false;
     }
 
     std::cout << "NMT restart command sent successfully" << std::endl;
-    usleep(2000000);  // Wait for 2 seconds
+    if (!waitForNode(id, bootWait_.settleMs)) {
+        std::cerr << "Node " << id << " did not come back within " << bootWait_.timeoutMs << " ms" << std::endl;
+    }
     return true;
 }
 
-bool CanInterface::sendSDOWithTimeout(const uint8_t* data, size_t dataSize, int id, struct can_frame& response) {
-    struct can_frame frame;
+void CanInterface::traceResponse(const char* kind, int id, uint16_t index, uint8_t subindex, uint64_t rxNs) {
+    if (tracer_ == NULL) {
+        return;
+    }
+    // A kernel TX stamp older than our own send time belongs to an earlier frame
+    uint64_t txNs = session_->demux().lastTxTimestamp(0x600 + id);
+    if (txNs < sentNs_) {
+        txNs = sentNs_;
+    }
+    tracer_->record(kind, id, index, subindex, txNs, rxNs);
+}
+
+bool CanInterface::sendSDOWithTimeout(const uint8_t* data, size_t dataSize, int id, struct can_frame& response, bool fd) {
+    struct canfd_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
 
     frame.can_id = id + 0x600; // Convert id to can_id
-    frame.can_dlc = 8;
+    frame.len = 8;
+    // An FD request tells an FD capable server to continue the transfer in FD frames
+    fd = fd && fdEnabled_;
+    size_t mtu = fd ? CANFD_MTU : CAN_MTU;
+    if (fd) {
+        frame.flags = CANFD_BRS;
+    }
 
     // Copy data into the CAN frame
     std::memcpy(frame.data, data, std::min(dataSize, size_t(8)));
 
-    if (write(socket_, &frame, sizeof(struct can_frame)) != sizeof(struct can_frame)) {
-        std::cerr << "Error in sending SDO" << std::endl;
-        return false;
+    // Late answers to earlier requests must not be taken for this response
+    inbox_.clear();
+
+    // Initiate requests are answered with the same index/subindex, let the demux check it
+    uint8_t cs = frame.data[0];
+    bool initiate = (cs & 0xE0) == 0x20 || (cs & 0xE0) == 0x40 ||
+                    ((cs & 0xE0) == 0xC0 && (cs & 0x01) == 0) || ((cs & 0xE0) == 0xA0 && (cs & 0x03) == 0);
+    if (initiate) {
+        sdoIndex_ = frame.data[1] | (frame.data[2] << 8);
+        sdoSubindex_ = frame.data[3];
+    }
+
+    // Reads and parameter writes are repeated on timeout, everything else gets one longer wait
+    const SdoTimeoutPolicy& policy = sdoTimeouts_.policy();
+    bool slow = SdoTimeouts::isSlow(frame.data);
+    int attempts = SdoTimeouts::isIdempotent(frame.data) ? policy.maxRetries + 1 : 1;
+
+    for (int attempt = 0; attempt < attempts; attempt++) {
+        int timeoutMs = slow ? policy.slowTimeoutMs
+                      : attempts > 1 ? sdoTimeouts_.timeoutMs(id, SdoTimeouts::REQUEST, attempt)
+                      : sdoTimeouts_.patienceMs(id, SdoTimeouts::REQUEST);
+        if (initiate) {
+            session_->demux().expectSdoResponse(id, sdoIndex_, sdoSubindex_);
+        } else {
+            session_->demux().expectAnySdoResponse(id);
+        }
+
+        sentNs_ = realtimeNs();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (write(socket_, &frame, mtu) != static_cast<ssize_t>(mtu)) {
+            std::cerr << "Error in sending SDO" << std::endl;
+            return false;
+        }
+        recordTx(&frame, mtu, sentNs_);
+
+        // Wait for the response, skipping heartbeats and other traffic. An answer
+        // to an earlier attempt is as good as one to this attempt.
+        int remaining = timeoutMs;
+        while (remaining > 0) {
+            uint64_t rxNs;
+            if (!receiveFrame(response, remaining, &rxNs)) {
+                break;
+            }
+            uint8_t responseCs = response.data[0];
+            bool staleInitiate = !initiate && ((responseCs & 0xE0) == 0x40 || responseCs == 0x60);
+            if ((response.can_id & CAN_SFF_MASK) == static_cast<canid_t>(0x580 + id) && !staleInitiate) {
+                // Karn: the answer to a repeated request cannot be matched to one send time
+                if (attempt == 0 && !slow) {
+                    double rttMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    sdoTimeouts_.sample(id, SdoTimeouts::REQUEST, rttMs);
+                }
+                traceResponse("sdo", id, sdoIndex_, sdoSubindex_, rxNs);
+                return true;
+            }
+            remaining = timeoutMs - elapsedMs(start);
+        }
+
+        if (attempt + 1 < attempts) {
+            std::cerr << "No SDO response from node " << id << " within " << timeoutMs << " ms, retrying" << std::endl;
+        }
     }
 
-    // Set up the timeout
-    struct timeval timeout;
-    timeout.tv_sec = 2; // 2 seconds timeout
-    timeout.tv_usec = 0;
+    // Do not leave the demux filtering later answers for a request nobody waits for anymore
+    session_->demux().expectAnySdoResponse(id);
+    std::cerr << "Timeout waiting for response" << std::endl;
+    return false;
+}
 
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(socket_, &readfds);
+bool CanInterface::readSDO(int id, uint16_t index, uint8_t subindex, std::vector<uint8_t>& value) {
+    struct can_frame response;
+    uint8_t data[8] = {
+        0x40, static_cast<uint8_t>(index & 0xFF), static_cast<uint8_t>((index >> 8) & 0xFF), subindex,
+        0x00, 0x00, 0x00, 0x00
+    };
 
-    // Wait for response with timeout
-    int ret = select(socket_ + 1, &readfds, NULL, NULL, &timeout);
-    if (ret == -1) {
-        std::cerr << "Error in select" << std::endl;
+    value.clear();
+    if (!sendSDOWithTimeout(data, 8, id, response)) {
         return false;
-    } else if (ret == 0) {
-        std::cerr << "Timeout waiting for response" << std::endl;
+    }
+
+    if (response.data[0] == 0x80) {  // SDO abort code
+        std::cerr << "SDO upload of 0x" << std::hex << index << "/" << static_cast<int>(subindex)
+                  << " aborted with code: 0x"
+                  << (response.data[4] | (response.data[5] << 8) |
+                      (response.data[6] << 16) | (response.data[7] << 24))
+                  << std::dec << std::endl;
         return false;
-    } else {
-        int nbytes = read(socket_, &response, sizeof(struct can_frame));
-        if (nbytes < 0) {
-            std::cerr << "Error in receiving response" << std::endl;
+    }
+    if ((response.data[0] & 0xE0) != 0x40) {
+        std::cerr << "Unexpected upload response code: 0x" << std::hex
+                  << static_cast<int>(response.data[0]) << std::dec << std::endl;
+        return false;
+    }
+
+    // Expedited: up to 4 bytes in the initiate response
+    if (response.data[0] & 0x02) {
+        size_t size = (response.data[0] & 0x01) ? 4 - ((response.data[0] >> 2) & 0x03) : 4;
+        value.assign(&response.data[4], &response.data[4] + size);
+        return true;
+    }
+
+    // Segmented: 7 bytes per segment with alternating toggle bit
+    size_t expected = 0;
+    if (response.data[0] & 0x01) {
+        expected = response.data[4] | (response.data[5] << 8) | (response.data[6] << 16) | (response.data[7] << 24);
+        value.reserve(expected);
+    }
+
+    uint8_t toggle = 0x00;
+    for (;;) {
+        uint8_t segmentRequest[8] = {static_cast<uint8_t>(0x60 | toggle), 0, 0, 0, 0, 0, 0, 0};
+        if (!sendSDOWithTimeout(segmentRequest, 8, id, response)) {
             return false;
         }
-        return true;
+        if (response.data[0] == 0x80) {
+            std::cerr << "SDO segmented upload aborted with code: 0x" << std::hex
+                      << (response.data[4] | (response.data[5] << 8) |
+                          (response.data[6] << 16) | (response.data[7] << 24))
+                      << std::dec << std::endl;
+            return false;
+        }
+        if ((response.data[0] & 0xE0) != 0x00 || (response.data[0] & 0x10) != toggle) {
+            std::cerr << "Unexpected upload segment response: 0x" << std::hex
+                      << static_cast<int>(response.data[0]) << std::dec << std::endl;
+            return false;
+        }
+
+        size_t size = 7 - ((response.data[0] >> 1) & 0x07);
+        value.insert(value.end(), &response.data[1], &response.data[1] + size);
+        if (response.data[0] & 0x01) {  // Last segment
+            break;
+        }
+        toggle ^= 0x10;
+    }
+
+    if (expected != 0 && value.size() != expected) {
+        std::cerr << "SDO upload size mismatch: expected " << expected << ", got " << value.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CanInterface::waitForNode(int id, int settleMs) {
+    // Any SDO answer proves the node is up, an abort (e.g. from a bootloader) included
+    struct can_frame ping;
+    ping.can_id = id + 0x600;
+    ping.can_dlc = 8;
+    static constexpr od::SdoFrame PING = od::sdoUpload(od::DeviceType);
+    std::memcpy(ping.data, PING.data, 8);
+    // The expectation may still name whatever the last request before the reset was
+    session_->demux().expectSdoResponse(id, od::DeviceType.index, od::DeviceType.subindex);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int nextPing = settleMs;
+    int now = 0;
+    while (now < bootWait_.timeoutMs) {
+        if (now >= nextPing) {
+            uint64_t sentNs = realtimeNs();
+            if (write(socket_, &ping, sizeof(struct can_frame)) != sizeof(struct can_frame)) {
+                std::cerr << "Error in sending SDO ping" << std::endl;
+            } else {
+                recordTx(&ping, CAN_MTU, sentNs);
+            }
+            nextPing = now + bootWait_.pingIntervalMs;
+        }
+
+        struct can_frame frame;
+        int waitMs = std::max(1, std::min(nextPing, bootWait_.timeoutMs) - now);
+        if (receiveFrame(frame, waitMs)) {
+            canid_t cobId = frame.can_id & CAN_SFF_MASK;
+            // Boot-up message is always accepted, earlier traffic may still come from before the reset
+            if (cobId == static_cast<canid_t>(0x700 + id) && frame.can_dlc >= 1 && frame.data[0] == 0x00) {
+                return true;
+            }
+            if (elapsedMs(start) >= settleMs &&
+                (cobId == static_cast<canid_t>(0x700 + id) || cobId == static_cast<canid_t>(0x580 + id))) {
+                return true;
+            }
+        }
+        now = elapsedMs(start);
     }
+    return false;
+}
+
+void CanInterface::recordTx(const void* frame, size_t mtu, uint64_t timestampNs) {
+    if (txTap_ == NULL) {
+        return;
+    }
+    if (mtu == CANFD_MTU) {
+        txTap_->record(true, *static_cast<const struct canfd_frame*>(frame), true, timestampNs);
+    } else {
+        txTap_->record(true, *static_cast<const struct can_frame*>(frame), timestampNs);
+    }
+}
+
+bool CanInterface::receiveFrame(struct can_frame& frame, int timeoutMs, uint64_t* timestampNs) {
+    return inbox_.pop(frame, timeoutMs, timestampNs);
+}
+
+bool CanInterface::sendFrames(const struct can_frame* frames, size_t count, int timeoutMs) {
+    return sendBatch(reinterpret_cast<const uint8_t*>(frames), sizeof(struct can_frame), CAN_MTU, count, timeoutMs);
+}
+
+bool CanInterface::sendFrames(const struct canfd_frame* frames, size_t count, bool fd, int timeoutMs) {
+    // struct can_frame is the layout prefix of struct canfd_frame
+    return sendBatch(reinterpret_cast<const uint8_t*>(frames), sizeof(struct canfd_frame),
+                     fd && fdEnabled_ ? CANFD_MTU : CAN_MTU, count, timeoutMs);
+}
+
+bool CanInterface::sendBatch(const uint8_t* frames, size_t stride, size_t mtu, size_t count, int timeoutMs) {
+    // Hand the whole batch to the kernel with as few syscalls as possible
+    const size_t MAX_BATCH = 128;
+    struct mmsghdr msgs[MAX_BATCH];
+    struct iovec iovs[MAX_BATCH];
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastProgress = start;
+    size_t sent = 0;
+    bool ok = true;
+
+    while (sent < count) {
+        size_t batch = std::min(count - sent, MAX_BATCH);
+        for (size_t i = 0; i < batch; i++) {
+            iovs[i].iov_base = const_cast<uint8_t*>(&frames[(sent + i) * stride]);
+            iovs[i].iov_len = mtu;
+            std::memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        sentNs_ = realtimeNs();
+        int ret = sendmmsg(socket_, msgs, batch, MSG_DONTWAIT);
+        txStats_.syscalls++;
+        if (ret > 0) {
+            for (int i = 0; i < ret && txTap_ != NULL; i++) {
+                recordTx(&frames[(sent + i) * stride], mtu, sentNs_);
+            }
+            sent += ret;
+            txStats_.frames += ret;
+            lastProgress = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS && errno != EINTR) {
+            std::cerr << "Error in sending frames: " << strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+
+        // TX queue full: wait for room instead of failing the transfer
+        if (elapsedMs(lastProgress) >= timeoutMs) {
+            std::cerr << "Timeout waiting for room in the TX queue" << std::endl;
+            ok = false;
+            break;
+        }
+        txStats_.queueFullWaits++;
+        bool queueFull = (ret < 0 && errno == ENOBUFS);
+        struct pollfd pfd;
+        pfd.fd = socket_;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        poll(&pfd, 1, 10);
+        if (queueFull) {
+            // ENOBUFS comes from the device queue, which POLLOUT does not track
+            usleep(500);
+        }
+    }
+
+    txStats_.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
 }
 
 bool CanInterface::changeNodeId(int oldId, int newId, const std::string& canInterface) {
+    // Reuses the open session, only the filter moves to the old ID
     if (!initialize(canInterface, oldId)) {
-        std::cerr << "Failed to create CAN socket" << std::endl;
+        std::cerr << "Failed to attach to " << canInterface << std::endl;
+        return false;
+    }
+
+    // Make sure the node is reachable before renumbering it
+    if (!waitForNode(oldId, 0)) {
+        std::cerr << "Node " << oldId << " is not responding" << std::endl;
         return false;
     }
 
@@ -133,13 +457,9 @@ bool CanInterface::changeNodeId(int oldId, int newId, const std::string& canInte
     bool success = true;
     
     // Step 1: Write new ID to 0x2001 subindex 1
-    uint8_t data[8] = {
-        0x2F, 0x01, 0x20, 0x01,  // SDO write command for 0x2001 subindex 1
-        static_cast<uint8_t>(newId),  // New ID value
-        0x00, 0x00, 0x00
-    };
+    od::SdoFrame request = od::sdoDownload(od::CanopenConfig::CANNodeid, static_cast<uint8_t>(newId));
     
-    if (!sendSDOWithTimeout(data, 8, oldId, response)) {
+    if (!sendSDOWithTimeout(request.data, 8, oldId, response)) {
         std::cerr << "Failed to write new ID" << std::endl;
         success = false;
     }
@@ -151,12 +471,11 @@ bool CanInterface::changeNodeId(int oldId, int newId, const std::string& canInte
     }
     
     // Step 2: Write save command to 0x1010 subindex 3
-    uint8_t saveData[8] = {
-        0x23, 0x10, 0x10, 0x03,  // SDO write command for 0x1010 subindex 3
-        0x73, 0x61, 0x76, 0x65   // "save" in ASCII (0x65766173)
-    };
+    // "save" in ASCII
+    static constexpr od::SdoFrame SAVE =
+        od::sdoDownload(od::StoreParameters::SaveApplicationAndManufacturerParameters, 0x65766173);
     
-    if (!sendSDOWithTimeout(saveData, 8, oldId, response)) {
+    if (!sendSDOWithTimeout(SAVE.data, 8, oldId, response)) {
         std::cerr << "Failed to write save command" << std::endl;
         success = false;
     }
@@ -169,11 +488,16 @@ bool CanInterface::changeNodeId(int oldId, int newId, const std::string& canInte
     
     if (success) {
         std::cout << "Node ID changed successfully from " << oldId << " to " << newId << std::endl;
-        sendNMTRestart(oldId);
+        // The node boots up under its new ID
+        if (setNodeFilter(newId) && sendNMTCommand(0x81, oldId)) {
+            std::cout << "NMT restart command sent successfully" << std::endl;
+            if (!waitForNode(newId, bootWait_.settleMs)) {
+                std::cerr << "Node " << newId << " did not come back within " << bootWait_.timeoutMs << " ms" << std::endl;
+            }
+        }
     } else {
         std::cerr << "Failed to change node ID" << std::endl;
     }
     
-    close();
     return success;
 } 
\ No newline at end of file
@@ -8,27 +8,93 @@
 #include <sys/time.h>
 #include <sys/select.h>
 #include <unistd.h>
+#include "bus_session.hpp"
+#include "sdo_timeout.hpp"
+#include <memory>
 #include <string>
 #include <vector>
 #include <cstdint>
 
+// Bounds for waiting on a node after a reset or a jump into/out of the bootloader
+struct BootWaitConfig {
+    int timeoutMs;       // Give up if the node is not back within this time
+    int settleMs;        // Ignore heartbeats and ping replies this long after a reset
+    int pingIntervalMs;  // SDO ping period while no boot-up message has been seen
+
+    BootWaitConfig() : timeoutMs(5000), settleMs(300), pingIntervalMs(100) {}
+};
+
+// Transmit counters for the batched send path
+struct TxStats {
+    uint64_t frames;          // Frames handed to the kernel
+    uint64_t syscalls;        // sendmmsg calls
+    uint64_t queueFullWaits;  // Times the TX queue was full and we had to wait
+    double seconds;           // Time spent inside sendFrames
+
+    TxStats() : frames(0), syscalls(0), queueFullWaits(0), seconds(0) {}
+    double framesPerSecond() const { return seconds > 0 ? frames / seconds : 0; }
+};
+
+class LatencyTracer;
+
 class CanInterface {
 public:
     CanInterface();
     ~CanInterface();
 
+    // Attaches to the interface's bus session, only the first user of an interface opens a socket.
+    // Calling it again on the same interface just moves the filter to the new node.
     bool initialize(const std::string& canInterface, int id);
     void close();
 
+    bool sendNMTCommand(uint8_t command, int id);
     bool sendNMTRestart(int id);
-    bool sendSDOWithTimeout(const uint8_t* data, size_t dataSize, int id, struct can_frame& response);
+    bool waitForNode(int id, int settleMs);
+    bool sendSDOWithTimeout(const uint8_t* data, size_t dataSize, int id, struct can_frame& response, bool fd = false);
+    bool readSDO(int id, uint16_t index, uint8_t subindex, std::vector<uint8_t>& value);
+    bool receiveFrame(struct can_frame& frame, int timeoutMs, uint64_t* timestampNs = NULL);
+    bool sendFrames(const struct can_frame* frames, size_t count, int timeoutMs);
+    // CAN FD frames when fd is set, otherwise the classic 8 byte prefix of each frame
+    bool sendFrames(const struct canfd_frame* frames, size_t count, bool fd, int timeoutMs);
     bool changeNodeId(int oldId, int newId, const std::string& canInterface);
     int getSocket() const { return socket_; }
+    void setBootWait(const BootWaitConfig& config) { bootWait_ = config; }
+    const BootWaitConfig& getBootWait() const { return bootWait_; }
+    const TxStats& getTxStats() const { return txStats_; }
+    FrameDemux::Stats getRxStats() const;
+    BusSession* getSession() const { return session_.get(); }
+    void resetTxStats() { txStats_ = TxStats(); }
+    void setSdoTimeoutPolicy(const SdoTimeoutPolicy& policy) { sdoTimeouts_.setPolicy(policy); }
+    SdoTimeouts& getSdoTimeouts() { return sdoTimeouts_; }
+    // Enables SO_TIMESTAMPING of the session on the next initialize and records every SDO round trip
+    void setTracer(LatencyTracer* tracer) { tracer_ = tracer; }
+    // Records every frame sent and received on the next initialize
+    void setRecorder(FrameRecorder* recorder) { recorder_ = recorder; }
+    // Requests CAN_RAW_FD_FRAMES on the next initialize, granted if the interface has the FD MTU
+    void setFdMode(bool enabled) { fdRequested_ = enabled; }
+    bool isFdEnabled() const { return fdEnabled_; }
+    void traceResponse(const char* kind, int id, uint16_t index, uint8_t subindex, uint64_t rxNs);
 
 private:
-    int socket_;
+    std::shared_ptr<BusSession> session_;
+    int socket_;         // The session's socket, shared with every user of the bus
     std::string canInterface_;
     int nodeId_;
+    bool subscribed_;    // Session filter holds nodeId_
+    BootWaitConfig bootWait_;
+    TxStats txStats_;
+    SdoTimeouts sdoTimeouts_;  // Per node RTT estimates, survive reinitialization
+    FrameQueue inbox_;   // SDO responses and heartbeats of nodeId_, filled by the session's demux
+    LatencyTracer* tracer_;
+    FrameRecorder* recorder_;
+    FrameRecorder::Tap* txTap_;  // Frames this interface sends
+    bool fdRequested_;
+    bool fdEnabled_;
+    uint64_t sentNs_;      // Host clock just before the last request went out
+    uint16_t sdoIndex_;    // Object of the SDO transaction in progress
+    uint8_t sdoSubindex_;
 
-    bool createCanSocket(const std::string& canInterface, int id);
+    void recordTx(const void* frame, size_t mtu, uint64_t timestampNs);
+    bool sendBatch(const uint8_t* frames, size_t stride, size_t mtu, size_t count, int timeoutMs);
+    bool setNodeFilter(int id);
 }; 
\ No newline at end of file
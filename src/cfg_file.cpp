@@ -0,0 +1,297 @@
+#include "cfg_file.hpp"
+#include "param_table.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+static const char COMPILED_MAGIC[8] = {'C', 'A', 'N', 'O', 'P', 'C', 'F', 'G'};
+static const uint16_t COMPILED_VERSION = 1;
+
+// Columns of a parameter line, tab separated
+enum CfgColumn { COLUMN_NAME, COLUMN_INDEX, COLUMN_SUB, COLUMN_LEN, COLUMN_VALID, COLUMN_VALUE, COLUMN_COUNT };
+
+size_t StrRef::find(const char* text, size_t from) const {
+    size_t length = std::strlen(text);
+    for (size_t i = from; i + length <= size; i++) {
+        if (std::memcmp(data + i, text, length) == 0) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+size_t StrRef::find(char c, size_t from) const {
+    if (from >= size) {
+        return npos;
+    }
+    const void* hit = std::memchr(data + from, c, size - from);
+    return hit != NULL ? static_cast<const char*>(hit) - data : npos;
+}
+
+StrRef StrRef::substr(size_t from, size_t length) const {
+    if (from > size) {
+        from = size;
+    }
+    return StrRef(data + from, std::min(length, size - from));
+}
+
+StrRef StrRef::trim() const {
+    size_t begin = 0;
+    size_t end = size;
+    while (begin < end && (data[begin] == ' ' || data[begin] == '\t')) {
+        begin++;
+    }
+    while (end > begin && (data[end - 1] == ' ' || data[end - 1] == '\t')) {
+        end--;
+    }
+    return StrRef(data + begin, end - begin);
+}
+
+// Leading digits like stoul/stoll: stops at the first other character, needs at least one digit
+static bool parseUnsigned(StrRef text, unsigned int base, uint64_t& value) {
+    size_t i = 0;
+    if (base == 16 && text.size >= 2 && text.data[0] == '0' && (text.data[1] == 'x' || text.data[1] == 'X')) {
+        i = 2;
+    }
+    value = 0;
+    size_t digits = 0;
+    for (; i < text.size; i++, digits++) {
+        char c = text.data[i];
+        unsigned int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (base == 16 && c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (base == 16 && c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            break;
+        }
+        if (value > (std::numeric_limits<uint64_t>::max() - digit) / base) {
+            return false;  // Out of range
+        }
+        value = value * base + digit;
+    }
+    return digits > 0;
+}
+
+static bool parseSigned(StrRef text, int64_t& value) {
+    bool negative = !text.empty() && text.data[0] == '-';
+    if (!text.empty() && (text.data[0] == '-' || text.data[0] == '+')) {
+        text = text.substr(1, StrRef::npos);
+    }
+    uint64_t magnitude;
+    if (!parseUnsigned(text, 10, magnitude) ||
+        magnitude > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negative ? 1 : 0)) {
+        return false;
+    }
+    value = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+    return true;
+}
+
+// One hex byte per dotted field, as the node reports 0x1009
+static std::string formatHardwareVersion(uint32_t version) {
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0');
+    ss << std::setw(2) << ((version & 0xFF000000) >> 24) << ".";
+    ss << std::setw(2) << ((version & 0x00FF0000) >> 16) << ".";
+    ss << std::setw(2) << ((version & 0x0000FF00) >> 8) << ".";
+    ss << std::setw(2) << (version & 0x000000FF);
+    return ss.str();
+}
+
+CfgFile::CfgFile() : hardwareNumber_(0) {}
+
+bool CfgFile::load(const std::string& path) {
+    hardwareNumber_ = 0;
+    hardwareVersion_.clear();
+    params_.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening cfg file: " << path << std::endl;
+        return false;
+    }
+
+    // Regular files are parsed straight from the page cache, anything else is read into a buffer
+    struct stat st;
+    const char* data = NULL;
+    size_t size = 0;
+    void* mapping = MAP_FAILED;
+    std::vector<char> buffer;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (mapping != MAP_FAILED) {
+        madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapping);
+        size = st.st_size;
+    } else {
+        char chunk[4096];
+        ssize_t n;
+        while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+            buffer.insert(buffer.end(), chunk, chunk + n);
+        }
+        data = buffer.data();
+        size = buffer.size();
+    }
+    ::close(fd);
+
+    bool ok;
+    if (size >= sizeof(COMPILED_MAGIC) && std::memcmp(data, COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) == 0) {
+        ok = loadCompiled(reinterpret_cast<const uint8_t*>(data), size, path);
+    } else {
+        ok = parseText(data, size);
+    }
+
+    if (mapping != MAP_FAILED) {
+        munmap(mapping, size);
+    }
+    return ok;
+}
+
+bool CfgFile::parseText(const char* data, size_t size) {
+    // Lines end in CR, LF or CR LF; the first one is the header
+    bool header = true;
+    size_t pos = 0;
+    while (pos < size) {
+        size_t end = pos;
+        while (end < size && data[end] != '\r' && data[end] != '\n') {
+            end++;
+        }
+        StrRef line(data + pos, end - pos);
+        if (end < size && data[end] == '\r' && end + 1 < size && data[end + 1] == '\n') {
+            end++;
+        }
+        pos = end + 1;
+
+        if (header) {
+            if (!parseHeader(line)) {
+                return false;
+            }
+            header = false;
+        } else if (!line.empty()) {
+            parseLine(line);
+        }
+    }
+
+    if (header) {
+        std::cerr << "Failed to read first line" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CfgFile::parseHeader(StrRef line) {
+    if (line.empty()) {
+        std::cerr << "Failed to read first line" << std::endl;
+        return false;
+    }
+
+    // Parse hardware version from first line
+    size_t hwPos = line.find("hardware version=");
+    if (hwPos == StrRef::npos) {
+        std::cerr << "Could not find hardware version in first line" << std::endl;
+        return false;
+    }
+    hwPos += 17;  // Skip "hardware version="
+
+    size_t hwEnd = line.find(',', hwPos);
+    if (hwEnd == StrRef::npos) {
+        std::cerr << "Could not find end of hardware version" << std::endl;
+        return false;
+    }
+
+    // Digits up to an optional decimal point, anything else in between is ignored
+    uint64_t number = 0;
+    size_t digits = 0;
+    for (size_t i = hwPos; i < hwEnd && line.data[i] != '.'; i++) {
+        char c = line.data[i];
+        if (c >= '0' && c <= '9' && number <= std::numeric_limits<uint32_t>::max()) {
+            number = number * 10 + (c - '0');
+            digits++;
+        }
+    }
+    if (digits == 0 || number > std::numeric_limits<uint32_t>::max()) {
+        std::cerr << "Error converting hardware version to hex: " << line.substr(hwPos, hwEnd - hwPos).str() << std::endl;
+        return false;
+    }
+    hardwareNumber_ = static_cast<uint32_t>(number);
+
+    hardwareVersion_ = formatHardwareVersion(hardwareNumber_);
+    return true;
+}
+
+void CfgFile::parseLine(StrRef line) {
+    StrRef fields[COLUMN_COUNT];
+    size_t count = 0;
+    size_t start = 0;
+    while (count < COLUMN_COUNT) {
+        size_t end = line.find('\t', start);
+        fields[count++] = line.substr(start, end == StrRef::npos ? StrRef::npos : end - start);
+        if (end == StrRef::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    if (count < COLUMN_COUNT) {
+        return;  // Title or comment line
+    }
+
+    StrRef index = fields[COLUMN_INDEX].trim();
+    StrRef subindex = fields[COLUMN_SUB].trim();
+    StrRef length = fields[COLUMN_LEN].trim();
+    StrRef value = fields[COLUMN_VALUE].trim();
+    if (index.empty() || subindex.empty() || length.empty() || value.empty()) {
+        return;
+    }
+    // Only rows marked valid are written back, the header row has "VALID" here
+    if (!fields[COLUMN_VALID].trim().equals("True")) {
+        return;
+    }
+
+    uint64_t number;
+    ConfigParam param;
+    if (!parseUnsigned(index, 16, number) || number > 0xFFFF) {
+        std::cerr << "Error parsing index: " << index.str() << std::endl;
+        return;
+    }
+    param.index = static_cast<uint16_t>(number);
+    if (!parseUnsigned(subindex, 16, number) || number > 0xFF) {
+        std::cerr << "Error parsing subindex: " << subindex.str() << std::endl;
+        return;
+    }
+    param.subindex = static_cast<uint8_t>(number);
+    if (!parseUnsigned(length, 10, number) || number > 0xFF) {
+        std::cerr << "Error parsing length: " << length.str() << std::endl;
+        return;
+    }
+    param.length = static_cast<uint8_t>(number);
+    if (!parseSigned(value, param.value)) {
+        std::cerr << "Error parsing value: " << value.str() << std::endl;
+        return;
+    }
+    params_.push_back(param);
+}
+
+bool CfgFile::loadCompiled(const uint8_t* data, size_t size, const std::string& path) {
+    ParamTableHeader header(COMPILED_MAGIC, COMPILED_VERSION);
+    if (!readParamTable(data, size, header, params_, path, "compiled cfg file")) {
+        return false;
+    }
+    hardwareNumber_ = header.tag;
+    hardwareVersion_ = formatHardwareVersion(hardwareNumber_);
+    return true;
+}
+
+bool CfgFile::compile(const std::string& outputPath) const {
+    ParamTableHeader header(COMPILED_MAGIC, COMPILED_VERSION);
+    header.tag = hardwareNumber_;
+    return writeParamTable(outputPath, header, params_, "compiled cfg file");
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "config_manager.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Non-owning slice of a character buffer, a C++11 stand-in for std::string_view
+struct StrRef {
+    const char* data;
+    size_t size;
+
+    StrRef() : data(NULL), size(0) {}
+    StrRef(const char* begin, size_t length) : data(begin), size(length) {}
+
+    bool empty() const { return size == 0; }
+    bool equals(const char* text) const { return std::strlen(text) == size && std::memcmp(data, text, size) == 0; }
+    size_t find(const char* text, size_t from = 0) const;
+    size_t find(char c, size_t from = 0) const;
+    StrRef substr(size_t from, size_t length) const;
+    StrRef trim() const;  // Without leading and trailing spaces and tabs
+    std::string str() const { return std::string(data, size); }
+
+    static const size_t npos = static_cast<size_t>(-1);
+};
+
+// Parameter table of a cfg file. Text exports are parsed in place over a
+// memory mapping, field by field without copying; compiled tables (written
+// by compile()) are checked against their CRC and loaded as they are.
+class CfgFile {
+public:
+    CfgFile();
+
+    // Text or compiled, told apart by the magic of compiled tables
+    bool load(const std::string& path);
+    // Compact little endian table: header, CRC16 of the records, 12 bytes per parameter
+    bool compile(const std::string& outputPath) const;
+
+    const std::string& hardwareVersion() const { return hardwareVersion_; }  // "10.00.30.01"
+    const std::vector<ConfigParam>& params() const { return params_; }
+
+private:
+    uint32_t hardwareNumber_;      // Decimal number from the header line
+    std::string hardwareVersion_;  // The same, one hex byte per dotted field
+    std::vector<ConfigParam> params_;
+
+    bool parseText(const char* data, size_t size);
+    bool parseHeader(StrRef line);
+    void parseLine(StrRef line);
+    bool loadCompiled(const uint8_t* data, size_t size, const std::string& path);
+};
@@ -0,0 +1,98 @@
+#include "config_cache.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+ConfigCache::ConfigCache(const std::string& path) : path_(path) {}
+
+std::string ConfigCache::defaultPath() {
+    const char* home = getenv("HOME");
+    return std::string(home ? home : ".") + "/.canopenCommand_config.cache";
+}
+
+bool ConfigCache::load() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+
+    std::ifstream file(path_);
+    if (!file) {
+        return true;  // No cache yet
+    }
+
+    // <node> <serial> <index> <subindex> <length> <value>, one parameter per line
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        int nodeId;
+        uint32_t serialNumber;
+        unsigned int index, subindex, length;
+        long long value;
+        if (!(fields >> std::dec >> nodeId >> std::hex >> serialNumber >> index >> subindex
+                    >> std::dec >> length >> value)) {
+            continue;
+        }
+        ConfigParam param;
+        param.index = static_cast<uint16_t>(index);
+        param.subindex = static_cast<uint8_t>(subindex);
+        param.length = static_cast<uint8_t>(length);
+        param.value = value;
+        entries_[Key(nodeId, serialNumber)][std::make_pair(param.index, param.subindex)] = param;
+    }
+    return true;
+}
+
+bool ConfigCache::lookup(int nodeId, uint32_t serialNumber, ConfigCacheEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<Key, ParamMap>::const_iterator it = entries_.find(Key(nodeId, serialNumber));
+    if (it == entries_.end()) {
+        return false;
+    }
+    entry.nodeId = nodeId;
+    entry.serialNumber = serialNumber;
+    entry.params.clear();
+    for (ParamMap::const_iterator param = it->second.begin(); param != it->second.end(); ++param) {
+        entry.params.push_back(param->second);
+    }
+    return true;
+}
+
+bool ConfigCache::store(int nodeId, uint32_t serialNumber, const std::vector<ConfigParam>& params) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ParamMap& known = entries_[Key(nodeId, serialNumber)];
+    for (size_t i = 0; i < params.size(); i++) {
+        known[std::make_pair(params[i].index, params[i].subindex)] = params[i];
+    }
+    return save();
+}
+
+bool ConfigCache::save() {
+    // Write a temporary file and rename it so an interrupted run never truncates the cache
+    std::string tmpPath = path_ + ".tmp";
+    {
+        std::ofstream file(tmpPath.c_str(), std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error writing config cache: " << tmpPath << std::endl;
+            return false;
+        }
+        for (std::map<Key, ParamMap>::const_iterator it = entries_.begin(); it != entries_.end(); ++it) {
+            for (ParamMap::const_iterator param = it->second.begin(); param != it->second.end(); ++param) {
+                const ConfigParam& value = param->second;
+                file << std::dec << it->first.first << " " << std::hex << it->first.second << " "
+                     << value.index << " " << static_cast<int>(value.subindex) << " "
+                     << std::dec << static_cast<int>(value.length) << " " << value.value << "\n";
+            }
+        }
+        if (!file) {
+            std::cerr << "Error writing config cache: " << tmpPath << std::endl;
+            return false;
+        }
+    }
+
+    if (rename(tmpPath.c_str(), path_.c_str()) != 0) {
+        std::cerr << "Error replacing config cache: " << path_ << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "config_manager.hpp"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Parameter values last applied to a node, keyed by node ID and serial number
+struct ConfigCacheEntry {
+    int nodeId;
+    uint32_t serialNumber;
+    std::vector<ConfigParam> params;
+
+    ConfigCacheEntry() : nodeId(0), serialNumber(0) {}
+};
+
+// Local text file remembering applied configurations, safe to share between fleet workers
+class ConfigCache {
+public:
+    ConfigCache(const std::string& path);
+
+    bool load();
+    bool lookup(int nodeId, uint32_t serialNumber, ConfigCacheEntry& entry);
+    // Merges params into what is known about the node, newer values win
+    bool store(int nodeId, uint32_t serialNumber, const std::vector<ConfigParam>& params);
+
+    static std::string defaultPath();
+
+private:
+    typedef std::pair<int, uint32_t> Key;
+    typedef std::map<std::pair<uint16_t, uint8_t>, ConfigParam> ParamMap;
+
+    std::string path_;
+    std::map<Key, ParamMap> entries_;
+    std::mutex mutex_;
+
+    bool save();
+};
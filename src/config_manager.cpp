@@ -1,11 +1,28 @@
 #include "config_manager.hpp"
+#include "cfg_file.hpp"
+#include "config_cache.hpp"
+#include "config_snapshot.hpp"
+#include "device_identity.hpp"
+#include "eds_dictionary.hpp"
+#include "flow_od.hpp"
+#include <sys/stat.h>
+#include <cerrno>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <future>
+#include <map>
 
-ConfigManager::ConfigManager(CanInterface& canInterface) : canInterface_(canInterface) {}
+ConfigManager::ConfigManager(CanInterface& canInterface) : canInterface_(canInterface), sdoClient_(NULL), onlyChanged_(false), cache_(NULL), dictionary_(NULL) {}
+
+bool ConfigManager::sdoTransaction(int id, const uint8_t* data, struct can_frame& response) {
+    if (sdoClient_ != NULL) {
+        return sdoClient_->transact(id, data, response);
+    }
+    return canInterface_.sendSDOWithTimeout(data, 8, id, response);
+}
 
 bool ConfigManager::applyConfiguration(const std::string& cfgPath, int id) {
     // Parse cfg file
@@ -15,9 +32,21 @@ bool ConfigManager::applyConfiguration(const std::string& cfgPath, int id) {
         std::cerr << "Failed to parse cfg file" << std::endl;
         return false;
     }
+
+    // Reject the whole cfg up front rather than halfway through on a drive abort
+    if (dictionary_ != NULL) {
+        size_t errors = dictionary_->validate(params);
+        if (errors != 0) {
+            std::cerr << errors << " of " << params.size() << " parameters do not match the EDS, nothing written" << std::endl;
+            return false;
+        }
+    }
     
-    // Read hardware version from device
-    std::string deviceHwVersion = readHardwareVersion(id);
+    // Read hardware version from device, cached until the node reboots
+    std::string deviceHwVersion;
+    if (!readHardwareVersion(canInterface_, id, deviceHwVersion, sdoClient_)) {
+        return false;
+    }
     std::cout << "Device Hardware Version: " << deviceHwVersion << std::endl;
     std::cout << "Cfg Hardware Version: " << hardwareVersion << std::endl;
     
@@ -29,191 +58,300 @@ bool ConfigManager::applyConfiguration(const std::string& cfgPath, int id) {
         return false;
     }
     
+    // The serial number keys the config cache and names the snapshot
+    bool transactional = !snapshotDir_.empty();
+    uint32_t serialNumber = 0;
+    bool haveSerial = (cache_ != NULL || transactional) && readSerialNumber(id, serialNumber);
+    bool useCache = cache_ != NULL && haveSerial;
+    if (cache_ != NULL && !haveSerial) {
+        std::cerr << "Not using the config cache" << std::endl;
+    }
+    if (transactional && !haveSerial) {
+        std::cerr << "Cannot take a snapshot, nothing written" << std::endl;
+        return false;
+    }
+
+    // Only what the device does not hold already needs writing. The cache
+    // learns only values the node confirmed, by readback or a 0x60 response.
+    std::vector<ConfigParam> changes;
+    std::vector<ConfigParam> confirmed;
+    if (onlyChanged_) {
+        if (!selectChanges(id, params, useCache ? &serialNumber : NULL, changes, confirmed)) {
+            return false;
+        }
+        std::cout << changes.size() << " of " << params.size() << " parameters differ" << std::endl;
+        if (changes.empty()) {
+            if (useCache) {
+                cache_->store(id, serialNumber, confirmed);
+            }
+            std::cout << "Configuration already applied, nothing to save" << std::endl;
+            return true;
+        }
+    } else {
+        changes = params;
+    }
+
+    // Keep what the node holds now, so a failed apply can be undone
+    ConfigSnapshot snapshot(id, serialNumber);
+    if (transactional && !takeSnapshot(id, changes, snapshot)) {
+        std::cerr << "Failed to take a snapshot, nothing written" << std::endl;
+        return false;
+    }
+
     // Apply configuration
     std::cout << "Applying configuration..." << std::endl;
-    for (const auto& param : params) {
+    for (size_t i = 0; i < changes.size(); i++) {
+        const ConfigParam& param = changes[i];
         if (!writeSDO(id, param.index, param.subindex, param.length, param.value)) {
             std::cerr << "Failed to write parameter" << std::endl;
+            if (transactional) {
+                // The failed write may have been taken in part, restore it too
+                rollback(id, snapshot, i + 1);
+            }
             return false;
         }
+        confirmed.push_back(param);
+        if (progress_) {
+            progress_(i + 1, changes.size());
+        }
     }
     
     // Save configuration
     std::cout << "Saving configuration..." << std::endl;
     if (!saveConfiguration(id)) {
         std::cerr << "Failed to save configuration" << std::endl;
+        // What was stored is unknown, store the old values again
+        if (transactional && rollback(id, snapshot, changes.size()) && !saveConfiguration(id)) {
+            std::cerr << "Failed to save the restored configuration" << std::endl;
+        }
         return false;
     }
     
     // Send NMT restart command
     std::cout << "Restarting device..." << std::endl;
     canInterface_.sendNMTRestart(id);
+
+    if (useCache) {
+        cache_->store(id, serialNumber, confirmed);
+    }
     
     std::cout << "Configuration applied successfully" << std::endl;
     return true;
 }
 
-bool ConfigManager::parseCfgFile(const std::string& cfgPath, std::vector<ConfigParam>& params, std::string& hardwareVersion) {
-    std::ifstream file(cfgPath);
-    if (!file) {
-        std::cerr << "Error opening cfg file: " << cfgPath << std::endl;
-        return false;
+bool ConfigManager::selectChanges(int id, const std::vector<ConfigParam>& params, const uint32_t* serialNumber,
+                                  std::vector<ConfigParam>& changes, std::vector<ConfigParam>& unchanged) {
+    // Values applied by an earlier run on this very device need no readback
+    std::map<std::pair<uint16_t, uint8_t>, ConfigParam> known;
+    ConfigCacheEntry cached;
+    if (serialNumber != NULL && cache_->lookup(id, *serialNumber, cached)) {
+        for (size_t i = 0; i < cached.params.size(); i++) {
+            known[std::make_pair(cached.params[i].index, cached.params[i].subindex)] = cached.params[i];
+        }
     }
 
-    // Read first line to get hardware version
-    std::string firstLine;
-    char c;
-    while (file.get(c)) {
-        if (c == '\r' || c == '\n') {
-            if (c == '\r' && file.peek() == '\n') {
-                file.get(); // Skip \n
+    std::vector<bool> differs(params.size(), false);
+    std::vector<size_t> unknown;
+    for (size_t i = 0; i < params.size(); i++) {
+        std::map<std::pair<uint16_t, uint8_t>, ConfigParam>::const_iterator it =
+            known.find(std::make_pair(params[i].index, params[i].subindex));
+        if (it == known.end() || it->second.length != params[i].length) {
+            unknown.push_back(i);
+        } else {
+            std::vector<uint8_t> cachedBytes;
+            for (uint8_t b = 0; b < it->second.length; b++) {
+                cachedBytes.push_back(static_cast<uint8_t>((it->second.value >> (b * 8)) & 0xFF));
             }
-            break;
+            differs[i] = !sameValue(params[i], cachedBytes);
         }
-        firstLine += c;
     }
-    
-    if (firstLine.empty()) {
-        std::cerr << "Failed to read first line" << std::endl;
+    if (!unknown.empty()) {
+        std::cout << "Reading " << unknown.size() << " current values..." << std::endl;
+        if (!readCurrentValues(id, params, unknown, differs)) {
+            return false;
+        }
+    }
+
+    // Written in cfg order, some parameters only take effect after others
+    changes.clear();
+    unchanged.clear();
+    for (size_t i = 0; i < params.size(); i++) {
+        (differs[i] ? changes : unchanged).push_back(params[i]);
+    }
+    return true;
+}
+
+bool ConfigManager::readCurrentValues(int id, const std::vector<ConfigParam>& params, const std::vector<size_t>& which,
+                                      std::vector<bool>& differs) {
+    // A value that cannot be read back (write only, aborted) is simply written
+    std::vector<std::vector<uint8_t> > values;
+    std::vector<bool> read;
+    readValues(id, params, which, values, read);
+    for (size_t i = 0; i < which.size(); i++) {
+        differs[which[i]] = !read[i] || !sameValue(params[which[i]], values[i]);
+    }
+    return true;
+}
+
+void ConfigManager::readValues(int id, const std::vector<ConfigParam>& params, const std::vector<size_t>& which,
+                               std::vector<std::vector<uint8_t> >& values, std::vector<bool>& read) {
+    values.assign(which.size(), std::vector<uint8_t>());
+    read.assign(which.size(), false);
+    if (sdoClient_ != NULL) {
+        // Queue every read at once, the client sends the next as soon as a response arrives
+        std::vector<std::future<SdoResult> > reads;
+        for (size_t i = 0; i < which.size(); i++) {
+            reads.push_back(sdoClient_->read(id, params[which[i]].index, params[which[i]].subindex));
+        }
+        for (size_t i = 0; i < which.size(); i++) {
+            SdoResult result = reads[i].get();
+            read[i] = result.success;
+            values[i].swap(result.data);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < which.size(); i++) {
+        const ConfigParam& param = params[which[i]];
+        read[i] = canInterface_.readSDO(id, param.index, param.subindex, values[i]);
+    }
+}
+
+bool ConfigManager::takeSnapshot(int id, const std::vector<ConfigParam>& changes, ConfigSnapshot& snapshot) {
+    std::cout << "Reading " << changes.size() << " values for the snapshot..." << std::endl;
+    std::vector<size_t> all(changes.size());
+    for (size_t i = 0; i < all.size(); i++) {
+        all[i] = i;
+    }
+    std::vector<std::vector<uint8_t> > values;
+    std::vector<bool> read;
+    readValues(id, changes, all, values, read);
+
+    // A value that cannot be read back could not be restored either
+    size_t errors = 0;
+    for (size_t i = 0; i < changes.size(); i++) {
+        size_t size = values[i].size();
+        if (!read[i] || (size != 1 && size != 2 && size != 4)) {
+            std::cerr << "0x" << std::hex << changes[i].index << "/" << static_cast<int>(changes[i].subindex)
+                      << std::dec << " cannot be read back for the snapshot" << std::endl;
+            errors++;
+            continue;
+        }
+        snapshot.add(changes[i].index, changes[i].subindex, values[i]);
+    }
+    if (errors != 0) {
         return false;
     }
-    
-    // Parse hardware version from first line
-    size_t hwPos = firstLine.find("hardware version=");
-    if (hwPos == std::string::npos) {
-        std::cerr << "Could not find hardware version in first line" << std::endl;
+
+    if (mkdir(snapshotDir_.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Error creating snapshot directory: " << snapshotDir_ << std::endl;
         return false;
     }
-    hwPos += 16; // Skip "hardware version="
-    
-    size_t hwEnd = firstLine.find_first_of(",", hwPos);
-    if (hwEnd == std::string::npos) {
-        std::cerr << "Could not find end of hardware version" << std::endl;
+    std::string path = ConfigSnapshot::pathFor(snapshotDir_, id, snapshot.serialNumber());
+    if (!snapshot.save(path)) {
         return false;
     }
-    
-    // Extract and trim hardware version
-    std::string decVersion = firstLine.substr(hwPos, hwEnd - hwPos);
-    
-    try {
-        // Remove any non-digit characters except decimal point
-        decVersion.erase(std::remove_if(decVersion.begin(), decVersion.end(),
-            [](char c) { return !std::isdigit(c) && c != '.'; }), decVersion.end());
-        
-        // If the string contains a decimal point, convert to integer first
-        size_t dotPos = decVersion.find('.');
-        if (dotPos != std::string::npos) {
-            decVersion = decVersion.substr(0, dotPos);
+    std::cout << "Snapshot of " << snapshot.params().size() << " values saved to " << path << std::endl;
+    return true;
+}
+
+bool ConfigManager::rollback(int id, const ConfigSnapshot& snapshot, size_t count) {
+    // Newest write first, undoing the apply step by step
+    std::cerr << "Rolling back " << count << " parameters..." << std::endl;
+    size_t failed = 0;
+    for (size_t i = count; i-- > 0;) {
+        const ConfigParam& param = snapshot.params()[i];
+        if (!writeSDO(id, param.index, param.subindex, param.length, param.value)) {
+            std::cerr << "Failed to restore 0x" << std::hex << param.index << "/" << static_cast<int>(param.subindex)
+                      << std::dec << std::endl;
+            failed++;
         }
-        
-        uint32_t version = std::stoul(decVersion);
-        std::stringstream ss;
-        ss << std::hex << std::setfill('0');
-        
-        // Extract each byte and format with dots
-        ss << std::setw(2) << ((version & 0xFF000000) >> 24) << ".";
-        ss << std::setw(2) << ((version & 0x00FF0000) >> 16) << ".";
-        ss << std::setw(2) << ((version & 0x0000FF00) >> 8) << ".";
-        ss << std::setw(2) << (version & 0x000000FF);
-        
-        hardwareVersion = ss.str();
-    } catch (const std::exception& e) {
-        std::cerr << "Error converting hardware version to hex: " << e.what() << std::endl;
+    }
+    if (failed != 0) {
+        std::cerr << failed << " of " << count << " parameters could not be restored" << std::endl;
         return false;
     }
-    
-    // Parse parameters
-    std::string line;
-    while (file.get(c)) {
-        if (c == '\r' || c == '\n') {
-            if (c == '\r' && file.peek() == '\n') {
-                file.get(); // Skip \n
-            }
-            
-            if (line.empty()) {
-                line.clear();
-                continue;
-            }
-            
-            // Split line by tabs
-            std::vector<std::string> fields;
-            size_t start = 0;
-            size_t end = line.find('\t');
-            while (end != std::string::npos) {
-                fields.push_back(line.substr(start, end - start));
-                start = end + 1;
-                end = line.find('\t', start);
-            }
-            fields.push_back(line.substr(start));
-            
-            if (fields.size() < 6) {
-                line.clear();
-                continue;
-            }
-            
-            ConfigParam param;
-            
-            try {
-                std::string indexStr = fields[1];
-                indexStr.erase(0, indexStr.find_first_not_of(" \t"));
-                indexStr.erase(indexStr.find_last_not_of(" \t") + 1);
-                if (indexStr.empty()) {
-                    line.clear();
-                    continue;
-                }
-                param.index = std::stoul(indexStr, nullptr, 16);
-                
-                std::string subindexStr = fields[2];
-                subindexStr.erase(0, subindexStr.find_first_not_of(" \t"));
-                subindexStr.erase(subindexStr.find_last_not_of(" \t") + 1);
-                if (subindexStr.empty()) {
-                    line.clear();
-                    continue;
-                }
-                param.subindex = std::stoul(subindexStr, nullptr, 16);
-                
-                std::string lengthStr = fields[3];
-                lengthStr.erase(0, lengthStr.find_first_not_of(" \t"));
-                lengthStr.erase(lengthStr.find_last_not_of(" \t") + 1);
-                if (lengthStr.empty()) {
-                    line.clear();
-                    continue;
-                }
-                param.length = std::stoul(lengthStr);
-                
-                std::string validStr = fields[4];
-                validStr.erase(0, validStr.find_first_not_of(" \t"));
-                validStr.erase(validStr.find_last_not_of(" \t") + 1);
-                if (validStr != "True") {
-                    line.clear();
-                    continue;
-                }
-                
-                std::string valueStr = fields[5];
-                valueStr.erase(0, valueStr.find_first_not_of(" \t"));
-                valueStr.erase(valueStr.find_last_not_of(" \t") + 1);
-                if (valueStr.empty()) {
-                    line.clear();
-                    continue;
-                }
-                param.value = std::stoll(valueStr);
-                
-                params.push_back(param);
-            } catch (const std::exception& e) {
-                std::cerr << "Error parsing line: " << e.what() << std::endl;
-            }
-            
-            line.clear();
-            continue;
+    std::cerr << "Previous values restored" << std::endl;
+    return true;
+}
+
+bool ConfigManager::restoreSnapshot(const std::string& snapshotPath, int id) {
+    ConfigSnapshot snapshot;
+    if (!snapshot.load(snapshotPath)) {
+        return false;
+    }
+
+    // Node IDs get reassigned, the serial number tells whether this is the same device
+    uint32_t serialNumber = 0;
+    if (!readSerialNumber(id, serialNumber)) {
+        return false;
+    }
+    if (serialNumber != snapshot.serialNumber()) {
+        std::cerr << "Snapshot was taken of serial number " << std::hex << snapshot.serialNumber() << ", node "
+                  << std::dec << id << " has " << std::hex << serialNumber << std::dec << std::endl;
+        return false;
+    }
+
+    // Written in the order they were taken, that is cfg order
+    const std::vector<ConfigParam>& params = snapshot.params();
+    std::cout << "Restoring " << params.size() << " parameters..." << std::endl;
+    for (size_t i = 0; i < params.size(); i++) {
+        const ConfigParam& param = params[i];
+        if (!writeSDO(id, param.index, param.subindex, param.length, param.value)) {
+            std::cerr << "Failed to write parameter" << std::endl;
+            return false;
+        }
+        if (progress_) {
+            progress_(i + 1, params.size());
         }
-        
-        line += c;
     }
-    
-    if (!line.empty()) {
-        // Process last line if exists
+
+    std::cout << "Saving configuration..." << std::endl;
+    if (!saveConfiguration(id)) {
+        std::cerr << "Failed to save configuration" << std::endl;
+        return false;
     }
-    
+    std::cout << "Restarting device..." << std::endl;
+    canInterface_.sendNMTRestart(id);
+
+    if (cache_ != NULL) {
+        cache_->store(id, serialNumber, params);
+    }
+    std::cout << "Snapshot restored successfully" << std::endl;
+    return true;
+}
+
+bool ConfigManager::readSerialNumber(int id, uint32_t& serialNumber) {
+    DeviceIdentity identity;
+    if (!readDeviceIdentity(canInterface_, id, identity, IDENTITY_OBJECT, sdoClient_)) {
+        std::cerr << "Failed to read serial number of node " << id << std::endl;
+        return false;
+    }
+    serialNumber = identity.serialNumber;
+    return true;
+}
+
+bool ConfigManager::sameValue(const ConfigParam& param, const std::vector<uint8_t>& current) {
+    if (current.size() != param.length) {
+        return false;
+    }
+    // Signed cfg values compare by their two's complement bytes
+    for (size_t i = 0; i < current.size(); i++) {
+        if (current[i] != static_cast<uint8_t>((param.value >> (i * 8)) & 0xFF)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConfigManager::parseCfgFile(const std::string& cfgPath, std::vector<ConfigParam>& params, std::string& hardwareVersion) {
+    // Text exports and compiled tables alike
+    CfgFile cfg;
+    if (!cfg.load(cfgPath)) {
+        return false;
+    }
+    params = cfg.params();
+    hardwareVersion = cfg.hardwareVersion();
     return true;
 }
 
@@ -247,47 +385,35 @@ bool ConfigManager::writeSDO(int id, uint16_t index, uint8_t subindex, uint8_t l
         data[4 + i] = (value >> (i * 8)) & 0xFF;
     }
     
-    return canInterface_.sendSDOWithTimeout(data, 8, id, response);
+    return sdoTransaction(id, data, response) && downloadConfirmed(response, index, subindex);
 }
 
-bool ConfigManager::saveConfiguration(int id) {
-    struct can_frame response;
-    uint8_t data[8] = {0x23, 0x10, 0x10, 0x03, 0x73, 0x61, 0x76, 0x65}; // "save" in ASCII
-    
-    return canInterface_.sendSDOWithTimeout(data, 8, id, response);
+bool ConfigManager::downloadConfirmed(const struct can_frame& response, uint16_t index, uint8_t subindex) {
+    // A rejected value comes back as an abort, not as a missing response
+    if (response.data[0] == 0x80) {  // SDO abort code
+        std::cerr << "SDO download of 0x" << std::hex << index << "/" << static_cast<int>(subindex)
+                  << " aborted with code: 0x"
+                  << (response.data[4] | (response.data[5] << 8) |
+                      (response.data[6] << 16) | (response.data[7] << 24))
+                  << std::dec << std::endl;
+        return false;
+    }
+    if (response.data[0] != 0x60) {
+        std::cerr << "Unexpected download response code: 0x" << std::hex
+                  << static_cast<int>(response.data[0]) << std::dec << std::endl;
+        return false;
+    }
+    return true;
 }
 
-std::string ConfigManager::readHardwareVersion(int id) {
+bool ConfigManager::saveConfiguration(int id) {
     struct can_frame response;
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-
-    // Read 4 bytes from index 0x1009
-    for (int i = 1; i <= 4; i++) {
-        uint8_t data[8] = {
-            0x40, 0x09, 0x10, static_cast<uint8_t>(i),  // SDO read command for index 0x1009
-            0x00, 0x00, 0x00, 0x00
-        };
-
-        if (!canInterface_.sendSDOWithTimeout(data, 8, id, response)) {
-            std::cerr << "Failed to read byte " << i << " of hardware version" << std::endl;
-            return "0.0.0.0";
-        }
-
-        // Check if response is valid (should start with 0x43)
-        if (response.data[0] != 0x4f) {
-            std::cerr << "Invalid response format for byte " << i << std::endl;
-            return "0.0.0.0";
-        }
-
-        // Add the byte to the version string
-        ss << std::setw(2) << static_cast<int>(response.data[4]);
-        if (i < 4) {
-            ss << ".";
-        }
-    }
-
-    return ss.str();
+    // "save" in ASCII
+    static constexpr od::SdoFrame SAVE =
+        od::sdoDownload(od::StoreParameters::SaveApplicationAndManufacturerParameters, 0x65766173);
+    return sdoTransaction(id, SAVE.data, response) &&
+           downloadConfirmed(response, od::StoreParameters::INDEX,
+                             od::StoreParameters::SaveApplicationAndManufacturerParameters.subindex);
 }
 
 std::string ConfigManager::stringToHex(const std::string& str) {
@@ -1,9 +1,15 @@
 #pragma once
 
 #include "can_interface.hpp"
+#include "sdo_client.hpp"
+#include <functional>
 #include <string>
 #include <vector>
 
+class ConfigCache;
+class ConfigSnapshot;
+class EdsDictionary;
+
 struct ConfigParam {
     uint16_t index;
     uint8_t subindex;
@@ -16,13 +22,44 @@ public:
     ConfigManager(CanInterface& canInterface);
     
     bool applyConfiguration(const std::string& cfgPath, int id);
+    // Writes a snapshot back to the node it was taken of, then saves and restarts it
+    bool restoreSnapshot(const std::string& snapshotPath, int id);
+    void setSdoClient(AsyncSdoClient* sdoClient) { sdoClient_ = sdoClient; }
+    // Read the current values first and write, save and restart only if something differs
+    void setOnlyChanged(bool onlyChanged) { onlyChanged_ = onlyChanged; }
+    // Values known from earlier runs are not read back again, requires setOnlyChanged
+    void setConfigCache(ConfigCache* cache) { cache_ = cache; }
+    // Parameters are checked against the EDS before the first frame and written with its data sizes
+    void setDictionary(const EdsDictionary* dictionary) { dictionary_ = dictionary; }
+    // Transactional apply: the values about to change are saved to a snapshot in this
+    // directory before the first write and written back if the apply fails
+    void setSnapshotDir(const std::string& directory) { snapshotDir_ = directory; }
+    // Called after every parameter written
+    void setProgressCallback(const std::function<void(size_t written, size_t total)>& callback) { progress_ = callback; }
     
 private:
     CanInterface& canInterface_;
+    AsyncSdoClient* sdoClient_;  // Optional, shared between managers on the same bus
+    std::function<void(size_t written, size_t total)> progress_;
+    bool onlyChanged_;
+    ConfigCache* cache_;
+    const EdsDictionary* dictionary_;
+    std::string snapshotDir_;
     
+    bool sdoTransaction(int id, const uint8_t* data, struct can_frame& response);
     bool parseCfgFile(const std::string& cfgPath, std::vector<ConfigParam>& params, std::string& hardwareVersion);
+    bool selectChanges(int id, const std::vector<ConfigParam>& params, const uint32_t* serialNumber,
+                       std::vector<ConfigParam>& changes, std::vector<ConfigParam>& unchanged);
+    bool readCurrentValues(int id, const std::vector<ConfigParam>& params, const std::vector<size_t>& which,
+                           std::vector<bool>& differs);
+    void readValues(int id, const std::vector<ConfigParam>& params, const std::vector<size_t>& which,
+                    std::vector<std::vector<uint8_t> >& values, std::vector<bool>& read);
+    bool takeSnapshot(int id, const std::vector<ConfigParam>& changes, ConfigSnapshot& snapshot);
+    bool rollback(int id, const ConfigSnapshot& snapshot, size_t count);
+    bool readSerialNumber(int id, uint32_t& serialNumber);
+    static bool sameValue(const ConfigParam& param, const std::vector<uint8_t>& current);
     bool writeSDO(int id, uint16_t index, uint8_t subindex, uint8_t length, int64_t value);
+    bool downloadConfirmed(const struct can_frame& response, uint16_t index, uint8_t subindex);
     bool saveConfiguration(int id);
-    std::string readHardwareVersion(int id);
     std::string stringToHex(const std::string& str);
 }; 
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "config_snapshot.hpp"
+#include "param_table.hpp"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static const char SNAPSHOT_MAGIC[8] = {'C', 'A', 'N', 'O', 'P', 'S', 'N', 'P'};
+static const uint16_t SNAPSHOT_VERSION = 1;
+
+void ConfigSnapshot::add(uint16_t index, uint8_t subindex, const std::vector<uint8_t>& value) {
+    ConfigParam param;
+    param.index = index;
+    param.subindex = subindex;
+    param.length = static_cast<uint8_t>(value.size());
+    param.value = value.empty() ? 0 : static_cast<int64_t>(getLe(&value[0], value.size()));
+    params_.push_back(param);
+}
+
+bool ConfigSnapshot::load(const std::string& path) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file) {
+        std::cerr << "Error opening snapshot file: " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    ParamTableHeader header(SNAPSHOT_MAGIC, SNAPSHOT_VERSION);
+    if (!readParamTable(data.data(), data.size(), header, params_, path, "snapshot file")) {
+        return false;
+    }
+    serialNumber_ = header.tag;
+    nodeId_ = static_cast<int>(header.extra);
+    for (size_t i = 0; i < params_.size(); i++) {
+        if (params_[i].length != 1 && params_[i].length != 2 && params_[i].length != 4) {
+            std::cerr << "Invalid value length in snapshot file: " << path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConfigSnapshot::save(const std::string& path) const {
+    ParamTableHeader header(SNAPSHOT_MAGIC, SNAPSHOT_VERSION);
+    header.tag = serialNumber_;
+    header.extra = static_cast<uint32_t>(nodeId_);
+    return writeParamTable(path, header, params_, "snapshot file");
+}
+
+std::string ConfigSnapshot::pathFor(const std::string& directory, int nodeId, uint32_t serialNumber) {
+    time_t now = time(NULL);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    char name[64];
+    snprintf(name, sizeof(name), "node%d-%08x-%04d%02d%02dT%02d%02d%02dZ.snap", nodeId, serialNumber,
+             utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec);
+    return directory + "/" + name;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "config_manager.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Values a node held for the objects a configuration was about to change,
+// read before the first write. Stored as a compact little endian table in
+// the layout of compiled cfg files: a 24 byte header with the node, its
+// serial number and the CRC16 of the records, then 12 bytes per object.
+class ConfigSnapshot {
+public:
+    ConfigSnapshot() : nodeId_(0), serialNumber_(0) {}
+    ConfigSnapshot(int nodeId, uint32_t serialNumber) : nodeId_(nodeId), serialNumber_(serialNumber) {}
+
+    bool load(const std::string& path);
+    // Written to a temporary file and renamed, a crash never leaves half a snapshot
+    bool save(const std::string& path) const;
+
+    // Raw value as uploaded, length 1, 2 or 4
+    void add(uint16_t index, uint8_t subindex, const std::vector<uint8_t>& value);
+
+    int nodeId() const { return nodeId_; }
+    uint32_t serialNumber() const { return serialNumber_; }
+    const std::vector<ConfigParam>& params() const { return params_; }
+
+    // "<dir>/node<id>-<serial>-<UTC time>.snap"
+    static std::string pathFor(const std::string& directory, int nodeId, uint32_t serialNumber);
+
+private:
+    int nodeId_;
+    uint32_t serialNumber_;
+    std::vector<ConfigParam> params_;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC16-CCITT (polynomial 0x1021, initial value 0) as used by SDO block transfer.
+// Can be fed incrementally, e.g. block by block while the data is being sent.
+class Crc16 {
+public:
+    Crc16() : crc_(0) {}
+
+    void init() { crc_ = 0; }
+    void update(const uint8_t* data, size_t length);
+    uint16_t finalize() const { return crc_; }
+
+    static uint16_t compute(const uint8_t* data, size_t length);
+
+    // Kernels, exposed for the benchmark
+    static uint16_t updateTable(uint16_t crc, const uint8_t* data, size_t length);
+    static uint16_t updateSliced(uint16_t crc, const uint8_t* data, size_t length);
+
+private:
+    uint16_t crc_;
+};
@@ -0,0 +1,287 @@
+#include "device_identity.hpp"
+#include "can_interface.hpp"
+#include "flow_od.hpp"
+#include "sdo_client.hpp"
+#include <cctype>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <vector>
+
+struct ObjectAddress {
+    uint16_t index;
+    uint8_t subindex;
+};
+
+static const ObjectAddress IDENTITY_OBJECTS[4] = {
+    {od::Identity::VendorID.index, od::Identity::VendorID.subindex},
+    {od::Identity::ProductCode.index, od::Identity::ProductCode.subindex},
+    {od::Identity::RevisionNumber.index, od::Identity::RevisionNumber.subindex},
+    {od::Identity::SerialNumber.index, od::Identity::SerialNumber.subindex},
+};
+
+static const ObjectAddress HARDWARE_VERSION_BYTES[4] = {
+    {od::HardwareVersionByte1.index, od::HardwareVersionByte1.subindex},
+    {od::HardwareVersionByte2.index, od::HardwareVersionByte2.subindex},
+    {od::HardwareVersionByte3.index, od::HardwareVersionByte3.subindex},
+    {od::HardwareVersionByte4.index, od::HardwareVersionByte4.subindex},
+};
+
+// Copies the parts valid in from
+static void merge(DeviceIdentity& into, const DeviceIdentity& from) {
+    if (from.fields & IDENTITY_HARDWARE) {
+        into.hardwareVersion = from.hardwareVersion;
+    }
+    if (from.fields & IDENTITY_OBJECT) {
+        into.vendorId = from.vendorId;
+        into.productCode = from.productCode;
+        into.revision = from.revision;
+        into.serialNumber = from.serialNumber;
+    }
+    if (from.fields & IDENTITY_SOFTWARE) {
+        into.softwareVersion = from.softwareVersion;
+    }
+    into.fields |= from.fields;
+}
+
+unsigned int IdentityCache::lookup(int nodeId, uint32_t bootCount, DeviceIdentity& identity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<int, Entry>::const_iterator it = entries_.find(nodeId);
+    if (it == entries_.end() || it->second.bootCount != bootCount) {
+        return 0;
+    }
+    identity = it->second.identity;
+    return identity.fields;
+}
+
+bool IdentityCache::store(int nodeId, uint32_t bootCount, const DeviceIdentity& identity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[nodeId];
+    if (entry.bootCount != bootCount) {
+        entry.identity = DeviceIdentity();
+        entry.bootCount = bootCount;
+    }
+
+    merge(entry.identity, identity);
+    bool first = !entry.stored;
+    entry.stored = true;
+    return first;
+}
+
+void IdentityCache::forget(int nodeId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<int, Entry>::iterator it = entries_.find(nodeId);
+    if (it != entries_.end()) {
+        it->second.identity = DeviceIdentity();
+    }
+}
+
+bool IdentityCache::perByteHardwareVersion(int nodeId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<int, Entry>::const_iterator it = entries_.find(nodeId);
+    return it != entries_.end() && it->second.perByteHardwareVersion;
+}
+
+void IdentityCache::setPerByteHardwareVersion(int nodeId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[nodeId].perByteHardwareVersion = true;
+}
+
+// Uploads the objects in order; through the SDO client all requests are queued at once
+static bool readObjects(CanInterface* canInterface, AsyncSdoClient* sdoClient, int id,
+                        const ObjectAddress* objects, size_t count, std::vector<std::vector<uint8_t> >& values) {
+    values.assign(count, std::vector<uint8_t>());
+    if (sdoClient == NULL) {
+        for (size_t i = 0; i < count; i++) {
+            if (!canInterface->readSDO(id, objects[i].index, objects[i].subindex, values[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::future<SdoResult> > pending;
+    pending.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        pending.push_back(sdoClient->read(id, objects[i].index, objects[i].subindex));
+    }
+    bool success = true;
+    for (size_t i = 0; i < count; i++) {
+        SdoResult result = pending[i].get();
+        if (!result.success) {
+            if (success) {
+                std::cerr << "SDO upload of 0x" << std::hex << objects[i].index << "/"
+                          << static_cast<int>(objects[i].subindex) << " failed: " << result.error << std::dec
+                          << std::endl;
+            }
+            success = false;
+            continue;
+        }
+        values[i].swap(result.data);
+    }
+    return success;
+}
+
+static bool toU32(const std::vector<uint8_t>& data, uint32_t& value) {
+    if (data.empty() || data.size() > 4) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        value |= static_cast<uint32_t>(data[i]) << (i * 8);
+    }
+    return true;
+}
+
+// Visible strings may be padded with trailing NULs
+static std::string toString(const std::vector<uint8_t>& data) {
+    std::string text(data.begin(), data.end());
+    while (!text.empty() && text[text.size() - 1] == '\0') {
+        text.erase(text.size() - 1);
+    }
+    return text;
+}
+
+static std::string formatHardwareVersion(const uint8_t* bytes) {
+    char text[12];
+    std::snprintf(text, sizeof(text), "%02x.%02x.%02x.%02x", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return text;
+}
+
+// 0x1009 is a visible string; only its "aa.bb.cc.dd" form is taken, any
+// other answer (such as a 4 byte sub-index count) means reading sub 1-4
+static bool parseHardwareVersion(const std::vector<uint8_t>& value, std::string& version) {
+    std::string text = toString(value);
+    if (text.size() != 11) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); i++) {
+        bool dot = i % 3 == 2;
+        if (dot ? text[i] != '.' : !std::isxdigit(static_cast<unsigned char>(text[i]))) {
+            return false;
+        }
+        text[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])));
+    }
+    version = text;
+    return true;
+}
+
+// One upload of 0x1009 where the device supports it, otherwise one per byte from sub 1-4
+static bool readHardware(CanInterface* canInterface, AsyncSdoClient* sdoClient, IdentityCache* cache, int id,
+                         std::string& version) {
+    if (cache == NULL || !cache->perByteHardwareVersion(id)) {
+        static const ObjectAddress VERSION = {od::ManufacturerHardwareVersion.index,
+                                              od::ManufacturerHardwareVersion.subindex};
+        std::vector<std::vector<uint8_t> > values;
+        if (readObjects(canInterface, sdoClient, id, &VERSION, 1, values) &&
+            parseHardwareVersion(values[0], version)) {
+            return true;
+        }
+        if (cache != NULL) {
+            cache->setPerByteHardwareVersion(id);
+        }
+    }
+
+    std::vector<std::vector<uint8_t> > values;
+    if (!readObjects(canInterface, sdoClient, id, HARDWARE_VERSION_BYTES, 4, values)) {
+        return false;
+    }
+    uint8_t bytes[4];
+    for (size_t i = 0; i < 4; i++) {
+        if (values[i].size() != 1) {
+            std::cerr << "Invalid response format for byte " << i + 1 << std::endl;
+            return false;
+        }
+        bytes[i] = values[i][0];
+    }
+    version = formatHardwareVersion(bytes);
+    return true;
+}
+
+// Reads the parts in missing; the cache, when there is one, remembers nodes that need per byte reads of 0x1009
+static bool readParts(CanInterface* canInterface, AsyncSdoClient* sdoClient, IdentityCache* cache, int id,
+                      unsigned int missing, DeviceIdentity& read) {
+    if (missing & IDENTITY_HARDWARE) {
+        if (!readHardware(canInterface, sdoClient, cache, id, read.hardwareVersion)) {
+            std::cerr << "Failed to read hardware version of node " << id << std::endl;
+            return false;
+        }
+        read.fields |= IDENTITY_HARDWARE;
+    }
+
+    if (missing & IDENTITY_OBJECT) {
+        std::vector<std::vector<uint8_t> > values;
+        if (!readObjects(canInterface, sdoClient, id, IDENTITY_OBJECTS, 4, values) ||
+            !toU32(values[0], read.vendorId) || !toU32(values[1], read.productCode) ||
+            !toU32(values[2], read.revision) || !toU32(values[3], read.serialNumber)) {
+            std::cerr << "Failed to read identity object of node " << id << std::endl;
+            return false;
+        }
+        read.fields |= IDENTITY_OBJECT;
+    }
+
+    // Visible string, usually longer than 4 bytes and therefore segmented
+    if (missing & IDENTITY_SOFTWARE) {
+        static const ObjectAddress VERSION = {od::ManufacturerSoftwareVersion.index,
+                                              od::ManufacturerSoftwareVersion.subindex};
+        std::vector<std::vector<uint8_t> > values;
+        if (!readObjects(canInterface, sdoClient, id, &VERSION, 1, values)) {
+            std::cerr << "Failed to read software version of node " << id << std::endl;
+            return false;
+        }
+        read.softwareVersion = toString(values[0]);
+        read.fields |= IDENTITY_SOFTWARE;
+    }
+    return true;
+}
+
+bool readDeviceIdentity(CanInterface& canInterface, int id, DeviceIdentity& identity, unsigned int fields,
+                        AsyncSdoClient* sdoClient) {
+    BusSession* session = canInterface.getSession();
+    IdentityCache* cache = session != NULL ? &session->identities() : NULL;
+    // Taken before reading, so a boot during the reads retires what they return
+    uint32_t bootCount = session != NULL ? session->demux().bootCount(id) : 0;
+
+    identity = DeviceIdentity();
+    unsigned int missing = fields;
+    if (cache != NULL) {
+        missing &= ~cache->lookup(id, bootCount, identity);
+        if (missing == 0) {
+            return true;
+        }
+    }
+
+    DeviceIdentity read;
+    if (!readParts(&canInterface, sdoClient, cache, id, missing, read)) {
+        return false;
+    }
+
+    // Listen for the node's boot-up from now on, even while nobody talks to it
+    if (cache != NULL && cache->store(id, bootCount, read)) {
+        session->addFilter(id, COB_HEARTBEAT);
+    }
+    merge(identity, read);
+    return true;
+}
+
+bool readDeviceIdentity(AsyncSdoClient& sdoClient, int id, DeviceIdentity& identity, unsigned int fields) {
+    identity = DeviceIdentity();
+    return readParts(NULL, &sdoClient, NULL, id, fields, identity);
+}
+
+bool readHardwareVersion(CanInterface& canInterface, int id, std::string& hardwareVersion,
+                         AsyncSdoClient* sdoClient) {
+    DeviceIdentity identity;
+    if (!readDeviceIdentity(canInterface, id, identity, IDENTITY_HARDWARE, sdoClient)) {
+        return false;
+    }
+    hardwareVersion = identity.hardwareVersion;
+    return true;
+}
+
+void forgetDeviceIdentity(CanInterface& canInterface, int id) {
+    BusSession* session = canInterface.getSession();
+    if (session != NULL) {
+        session->identities().forget(id);
+    }
+}
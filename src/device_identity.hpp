@@ -0,0 +1,73 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <cstdint>
+
+class AsyncSdoClient;
+class CanInterface;
+
+// Parts of the identity, read and cached separately
+enum IdentityField {
+    IDENTITY_HARDWARE = 0x01,  // Manufacturer hardware version (0x1009)
+    IDENTITY_OBJECT   = 0x02,  // Identity object (0x1018 sub 1-4)
+    IDENTITY_SOFTWARE = 0x04,  // Manufacturer software version (0x100A)
+    IDENTITY_ALL      = 0x07
+};
+
+// Identity object (0x1018), hardware (0x1009) and software version (0x100A) of a node
+struct DeviceIdentity {
+    uint32_t vendorId;
+    uint32_t productCode;
+    uint32_t revision;
+    uint32_t serialNumber;
+    std::string softwareVersion;
+    std::string hardwareVersion;  // "aa.bb.cc.dd", one hex byte per field
+    unsigned int fields;          // IdentityField bits that are valid
+
+    DeviceIdentity() : vendorId(0), productCode(0), revision(0), serialNumber(0), fields(0) {}
+};
+
+// Identities of the nodes on one bus, owned by its BusSession. An entry is
+// valid for the boot count it was read at (see FrameDemux::bootCount), so a
+// boot-up message or NMT reset of the node retires it.
+class IdentityCache {
+public:
+    // Copies the valid parts into identity and returns their IdentityField bits
+    unsigned int lookup(int nodeId, uint32_t bootCount, DeviceIdentity& identity);
+    // Merges the parts read; returns true the first time the node is stored
+    bool store(int nodeId, uint32_t bootCount, const DeviceIdentity& identity);
+    void forget(int nodeId);
+
+    // Nodes that abort the 0x1009 string and only give the version byte by byte
+    bool perByteHardwareVersion(int nodeId);
+    void setPerByteHardwareVersion(int nodeId);
+
+private:
+    struct Entry {
+        uint32_t bootCount;
+        DeviceIdentity identity;
+        bool perByteHardwareVersion;  // A property of the device, kept across boots
+        bool stored;
+
+        Entry() : bootCount(0), perByteHardwareVersion(false), stored(false) {}
+    };
+
+    std::mutex mutex_;
+    std::map<int, Entry> entries_;
+};
+
+// Reads the requested parts of the node's identity, taking what its bus
+// session still has cached and reading only the rest. With an SDO client the
+// reads are queued back to back instead of waiting for each in turn.
+bool readDeviceIdentity(CanInterface& canInterface, int id, DeviceIdentity& identity,
+                        unsigned int fields = IDENTITY_ALL, AsyncSdoClient* sdoClient = NULL);
+// Uncached, for nodes no bus session is tracking yet, such as during a bus scan
+bool readDeviceIdentity(AsyncSdoClient& sdoClient, int id, DeviceIdentity& identity,
+                        unsigned int fields = IDENTITY_ALL);
+// Shorthand for the hardware version check before a configuration or upgrade
+bool readHardwareVersion(CanInterface& canInterface, int id, std::string& hardwareVersion,
+                         AsyncSdoClient* sdoClient = NULL);
+// Drops the cached identity, for when the caller knows the node has changed
+void forgetDeviceIdentity(CanInterface& canInterface, int id);
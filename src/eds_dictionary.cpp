@@ -0,0 +1,204 @@
+#include "eds_dictionary.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Limits are device constants; $NODEID only appears in default COB-IDs
+static bool parseLimit(const std::string& text, int64_t& value) {
+    std::string number = trim(text);
+    if (number.empty() || number.find("$NODEID") != std::string::npos) {
+        return false;
+    }
+    char* end = NULL;
+    value = std::strtoll(number.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+static bool entryLess(const EdsEntry& a, const EdsEntry& b) {
+    return a.key < b.key;
+}
+
+bool EdsEntry::isSigned() const {
+    return dataType == EDS_INTEGER8 || dataType == EDS_INTEGER16 || dataType == EDS_INTEGER32 ||
+           dataType == EDS_INTEGER64;
+}
+
+uint8_t EdsDictionary::typeSize(uint16_t dataType) {
+    switch (dataType) {
+        case EDS_BOOLEAN: return 1;
+        case EDS_INTEGER8: return 1;
+        case EDS_INTEGER16: return 2;
+        case EDS_INTEGER32: return 4;
+        case EDS_UNSIGNED8: return 1;
+        case EDS_UNSIGNED16: return 2;
+        case EDS_UNSIGNED32: return 4;
+        case EDS_REAL32: return 4;
+        case EDS_REAL64: return 8;
+        case EDS_INTEGER64: return 8;
+        case EDS_UNSIGNED64: return 8;
+        default: return 0;  // Strings and domains
+    }
+}
+
+bool EdsDictionary::load(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file) {
+        std::cerr << "Error opening EDS file: " << path << std::endl;
+        return false;
+    }
+
+    entries_.clear();
+
+    // Only VAR sections carry a DataType: "[1000]" or "[1018sub1]"
+    std::string line;
+    bool inObject = false;
+    bool hasDataType = false;
+    EdsEntry entry;
+    std::string lowLimit, highLimit;
+
+    while (true) {
+        bool more = static_cast<bool>(std::getline(file, line));
+        line = trim(line);
+        if (!more || (!line.empty() && line[0] == '[')) {
+            if (inObject && hasDataType) {
+                entry.size = typeSize(entry.dataType);
+                if (parseLimit(lowLimit, entry.lowLimit) && parseLimit(highLimit, entry.highLimit)) {
+                    entry.flags |= EdsEntry::HAS_LIMITS;
+                }
+                entries_.push_back(entry);
+            }
+            if (!more) {
+                break;
+            }
+
+            std::string name = line.substr(1, line.find(']') - 1);
+            char* end = NULL;
+            unsigned long index = std::strtoul(name.c_str(), &end, 16);
+            inObject = end == name.c_str() + 4 && (*end == '\0' || std::strncmp(end, "sub", 3) == 0);
+            unsigned long subindex = (inObject && *end != '\0') ? std::strtoul(end + 3, NULL, 16) : 0;
+            std::memset(&entry, 0, sizeof(entry));
+            entry.key = (static_cast<uint32_t>(index & 0xFFFF) << 8) | (subindex & 0xFF);
+            entry.flags = EdsEntry::READABLE;
+            lowLimit.clear();
+            highLimit.clear();
+            hasDataType = false;
+            continue;
+        }
+        if (!inObject || line.empty() || line[0] == ';') {
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        std::string keyName = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        if (keyName == "DataType") {
+            entry.dataType = static_cast<uint16_t>(std::strtoul(value.c_str(), NULL, 0));
+            hasDataType = true;
+        } else if (keyName == "AccessType") {
+            // const and ro are read only, wo cannot be read back
+            entry.flags &= ~(EdsEntry::READABLE | EdsEntry::WRITABLE);
+            if (value != "wo") {
+                entry.flags |= EdsEntry::READABLE;
+            }
+            if (value == "rw" || value == "rww" || value == "rwr" || value == "wo") {
+                entry.flags |= EdsEntry::WRITABLE;
+            }
+        } else if (keyName == "PDOMapping") {
+            if (std::strtoul(value.c_str(), NULL, 0) != 0) {
+                entry.flags |= EdsEntry::PDO_MAPPABLE;
+            }
+        } else if (keyName == "LowLimit") {
+            lowLimit = value;
+        } else if (keyName == "HighLimit") {
+            highLimit = value;
+        }
+    }
+
+    if (entries_.empty()) {
+        std::cerr << "No objects found in EDS file: " << path << std::endl;
+        return false;
+    }
+
+    // Sorted once, a later duplicate section replaces an earlier one
+    std::stable_sort(entries_.begin(), entries_.end(), entryLess);
+    std::vector<EdsEntry> unique;
+    unique.reserve(entries_.size());
+    for (size_t i = 0; i < entries_.size(); i++) {
+        if (!unique.empty() && unique.back().key == entries_[i].key) {
+            unique.back() = entries_[i];
+        } else {
+            unique.push_back(entries_[i]);
+        }
+    }
+    entries_.swap(unique);
+    return true;
+}
+
+const EdsEntry* EdsDictionary::find(uint16_t index, uint8_t subindex) const {
+    EdsEntry probe;
+    probe.key = (static_cast<uint32_t>(index) << 8) | subindex;
+    std::vector<EdsEntry>::const_iterator it = std::lower_bound(entries_.begin(), entries_.end(), probe, entryLess);
+    return it != entries_.end() && it->key == probe.key ? &*it : NULL;
+}
+
+size_t EdsDictionary::validate(std::vector<ConfigParam>& params) const {
+    size_t errors = 0;
+    for (size_t i = 0; i < params.size(); i++) {
+        ConfigParam& param = params[i];
+        const EdsEntry* entry = find(param.index, param.subindex);
+        const char* problem = NULL;
+
+        if (entry == NULL) {
+            problem = "not in the object dictionary";
+        } else if (!entry->writable()) {
+            problem = "is read only";
+        } else if (entry->size == 0 || entry->size > 4 || entry->dataType == EDS_REAL32) {
+            problem = "has no integer type of up to 4 bytes";
+        } else {
+            // The value must fit the data type, whatever length the cfg claims
+            int64_t low = entry->isSigned() ? -(int64_t(1) << (entry->size * 8 - 1)) : 0;
+            int64_t high = entry->isSigned() ? (int64_t(1) << (entry->size * 8 - 1)) - 1
+                                             : (int64_t(1) << (entry->size * 8)) - 1;
+            if (entry->dataType == EDS_BOOLEAN) {
+                high = 1;
+            }
+            if (entry->hasLimits()) {
+                low = std::max(low, entry->lowLimit);
+                high = std::min(high, entry->highLimit);
+            }
+            if (param.value < low || param.value > high) {
+                std::cerr << "0x" << std::hex << param.index << "/" << static_cast<int>(param.subindex) << std::dec
+                          << ": value " << param.value << " outside " << low << ".." << high << std::endl;
+                errors++;
+                continue;
+            }
+            if (param.length != entry->size) {
+                std::cerr << "0x" << std::hex << param.index << "/" << static_cast<int>(param.subindex) << std::dec
+                          << ": cfg length " << static_cast<int>(param.length) << " differs from the EDS, writing "
+                          << static_cast<int>(entry->size) << " bytes" << std::endl;
+                param.length = entry->size;
+            }
+            continue;
+        }
+
+        std::cerr << "0x" << std::hex << param.index << "/" << static_cast<int>(param.subindex) << std::dec
+                  << " " << problem << std::endl;
+        errors++;
+    }
+    return errors;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "config_manager.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CiA 301 basic data types used by drive EDS files
+enum EdsDataType {
+    EDS_BOOLEAN = 0x0001,
+    EDS_INTEGER8 = 0x0002,
+    EDS_INTEGER16 = 0x0003,
+    EDS_INTEGER32 = 0x0004,
+    EDS_UNSIGNED8 = 0x0005,
+    EDS_UNSIGNED16 = 0x0006,
+    EDS_UNSIGNED32 = 0x0007,
+    EDS_REAL32 = 0x0008,
+    EDS_VISIBLE_STRING = 0x0009,
+    EDS_OCTET_STRING = 0x000A,
+    EDS_DOMAIN = 0x000F,
+    EDS_REAL64 = 0x0011,
+    EDS_INTEGER64 = 0x0015,
+    EDS_UNSIGNED64 = 0x001B
+};
+
+// One VAR of the object dictionary, 24 bytes
+struct EdsEntry {
+    enum Flags {
+        READABLE = 0x01,
+        WRITABLE = 0x02,
+        PDO_MAPPABLE = 0x04,
+        HAS_LIMITS = 0x08
+    };
+
+    uint32_t key;        // index << 8 | subindex, the sort order of the table
+    uint16_t dataType;
+    uint8_t flags;
+    uint8_t size;        // Bytes of fixed size types, 0 for strings and domains
+    int64_t lowLimit;
+    int64_t highLimit;
+
+    uint16_t index() const { return static_cast<uint16_t>(key >> 8); }
+    uint8_t subindex() const { return static_cast<uint8_t>(key); }
+    bool readable() const { return (flags & READABLE) != 0; }
+    bool writable() const { return (flags & WRITABLE) != 0; }
+    bool pdoMappable() const { return (flags & PDO_MAPPABLE) != 0; }
+    bool hasLimits() const { return (flags & HAS_LIMITS) != 0; }
+    bool isSigned() const;
+};
+
+// Object dictionary of a device type, loaded from its EDS into a flat table
+// sorted by (index, subindex) and searched by bisection. Read only after
+// load(), so one instance can serve all fleet workers.
+class EdsDictionary {
+public:
+    bool load(const std::string& path);
+
+    const EdsEntry* find(uint16_t index, uint8_t subindex) const;
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+    // Checks a cfg parameter list against the dictionary before anything is
+    // sent: object present, writable, numeric, value within the data type
+    // and the EDS limits. Sets each parameter's length from its data type.
+    // Reports every problem and returns how many there were.
+    size_t validate(std::vector<ConfigParam>& params) const;
+
+    static uint8_t typeSize(uint16_t dataType);
+
+private:
+    std::vector<EdsEntry> entries_;
+};
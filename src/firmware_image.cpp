@@ -0,0 +1,100 @@
+#include "firmware_image.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+FirmwareImage::FirmwareImage() : data_(NULL), size_(0), mapping_(NULL) {}
+
+FirmwareImage::~FirmwareImage() {
+    close();
+}
+
+bool FirmwareImage::open(const std::string& path) {
+    close();
+
+    bool isStdin = (path == "-");
+    int fd = isStdin ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening firmware file: " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        std::cerr << "Error reading firmware file status: " << path << std::endl;
+        if (!isStdin) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    bool ok = true;
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            // The image is read front to back exactly once while sending
+            madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+            mapping_ = mapping;
+            data_ = static_cast<const uint8_t*>(mapping);
+            size_ = st.st_size;
+        } else {
+            ok = readStream(fd, st.st_size);
+        }
+    } else {
+        ok = readStream(fd, 0);
+    }
+
+    if (!isStdin) {
+        ::close(fd);  // The mapping stays valid after closing the descriptor
+    }
+
+    if (!ok) {
+        std::cerr << "Error reading firmware file: " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FirmwareImage::close() {
+    if (mapping_ != NULL) {
+        munmap(mapping_, size_);
+        mapping_ = NULL;
+    }
+    std::vector<uint8_t>().swap(buffer_);
+    data_ = NULL;
+    size_ = 0;
+}
+
+bool FirmwareImage::readStream(int fd, size_t sizeHint) {
+    // Read in large chunks, the block transfer needs the total size up front
+    const size_t CHUNK_SIZE = 64 * 1024;
+    buffer_.resize(sizeHint > 0 ? sizeHint : CHUNK_SIZE);
+    size_t used = 0;
+
+    for (;;) {
+        if (used == buffer_.size()) {
+            buffer_.resize(buffer_.size() * 2);
+        }
+        ssize_t n = read(fd, &buffer_[used], buffer_.size() - used);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        used += n;
+    }
+
+    buffer_.resize(used);
+    data_ = buffer_.data();
+    size_ = used;
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view of a firmware image. Regular files are memory-mapped so
+// the data is never copied; pipes and stdin ("-") are read into a buffer.
+class FirmwareImage {
+public:
+    FirmwareImage();
+    ~FirmwareImage();
+
+    bool open(const std::string& path);
+    void close();
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool isMapped() const { return mapping_ != NULL; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    void* mapping_;
+    std::vector<uint8_t> buffer_;
+
+    bool readStream(int fd, size_t sizeHint);
+
+    FirmwareImage(const FirmwareImage&);
+    FirmwareImage& operator=(const FirmwareImage&);
+};
@@ -1,4 +1,10 @@
 #include "firmware_upgrade.hpp"
+#include "crc16.hpp"
+#include "firmware_image.hpp"
+#include "device_identity.hpp"
+#include "flow_od.hpp"
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -6,25 +12,31 @@
 #include <unistd.h>
 #include <cstring>
 
-// Define the CRC table
-static uint16_t crctable[256] = {
-    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
-    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6, 0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
-    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485, 0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
-    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4, 0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
-    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823, 0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
-    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12, 0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
-    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41, 0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
-    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70, 0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
-    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F, 0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
-    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E, 0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
-    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D, 0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
-    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C, 0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
-    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB, 0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
-    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A, 0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
-    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9, 0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
-    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8, 0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
-};
+// Block download tuning
+static const int MAX_BLOCK_RETRIES = 8;           // Consecutive blocks without progress before giving up
+static const int MAX_FRAME_GAP_US = 2000;         // Upper bound for the inter-frame gap on lossy buses
+static const int FRAME_GAP_STEP_US = 50;          // Gap added/removed per block when adapting
+static const int TX_QUEUE_TIMEOUT_MS = 1000;      // Give up if the TX queue stays full this long
+static const int UPLOAD_SEGMENT_TIMEOUT_MS = 200; // Longest gap before a block upload sub-block is treated as ended
+static const uint8_t UPLOAD_BLOCK_SIZE = 127;     // Segments per block we ask for in block upload
+static const size_t CLASSIC_SEGMENT_BYTES = 7;    // Data bytes after the sequence number of a classic segment
+
+// Milliseconds elapsed since the given start point
+static int elapsedMs(const std::chrono::steady_clock::time_point& start) {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+// Smallest CAN FD data length that holds len bytes, FD frames only come in these sizes
+static size_t fdFrameLength(size_t len) {
+    static const size_t lengths[] = {8, 12, 16, 20, 24, 32, 48, 64};
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        if (len <= lengths[i]) {
+            return lengths[i];
+        }
+    }
+    return CANFD_MAX_DLEN;
+}
 
 // Function to convert string to hex string
 static std::string stringToHex(const std::string& str) {
@@ -44,33 +56,75 @@ static std::string stringToHex(const std::string& str) {
     return ss.str();
 }
 
-FirmwareUpgrader::FirmwareUpgrader(CanInterface& canInterface) : canInterface_(canInterface) {}
+FirmwareUpgrader::FirmwareUpgrader(CanInterface& canInterface)
+    : canInterface_(canInterface), cache_(NULL), verify_(false), sdoClient_(NULL), fd_(false) {}
+
+bool FirmwareUpgrader::sdoTransaction(int id, const uint8_t* data, struct can_frame& response) {
+    if (sdoClient_ != NULL) {
+        return sdoClient_->transact(id, data, response);
+    }
+    return canInterface_.sendSDOWithTimeout(data, 8, id, response);
+}
 
 bool FirmwareUpgrader::upgrade(const std::string& firmwarePath, int id, const std::string& canInterface) {
-    // Send NMT restart command first
-    canInterface_.sendNMTRestart(id);
-    
-    // Load firmware data from the specified path
-    std::vector<uint8_t> firmwareData = loadFirmwareData(firmwarePath);
-    if (firmwareData.empty()) {
+    // Map the firmware image from the specified path, segments are sent straight from it
+    FirmwareImage firmwareImage;
+    if (!firmwareImage.open(firmwarePath) || firmwareImage.empty()) {
         return false;
     }
-    
-    size_t dataSize = firmwareData.size();
-    const uint8_t* firmwareDataPtr = firmwareData.data();
 
-    // Calculate total segment count and the last segment size
-    int lastSegmentSize = dataSize % 7 == 0 ? 7 : dataSize % 7;
-    // Calculate CRC16 for the firmware data
-    uint16_t crcValue = crc16(firmwareDataPtr, dataSize);
     // Get the hardware version from the firmware data
-    std::string hardwareVersion = getHardwareVersion(firmwareDataPtr, dataSize);
+    std::string hardwareVersion = getHardwareVersion(firmwareImage.data(), firmwareImage.size());
+    return upgradeImage(firmwareImage.data(), firmwareImage.size(), hardwareVersion, NULL, id, canInterface);
+}
 
+bool FirmwareUpgrader::upgrade(const StoredImage& image, int id, const std::string& canInterface) {
+    FirmwareImage firmwareImage;
+    if (!firmwareImage.open(image.path)) {
+        return false;
+    }
+
+    // The metadata was validated at import, only make sure the file was not replaced or damaged since
+    if (firmwareImage.size() != image.size ||
+        ImageStore::contentHash(firmwareImage.data(), firmwareImage.size()) != image.contentHash) {
+        std::cerr << "Stored image " << image.path << " does not match its index" << std::endl;
+        return false;
+    }
+    return upgradeImage(firmwareImage.data(), firmwareImage.size(), image.hardwareVersion, &image.crc16, id, canInterface);
+}
+
+bool FirmwareUpgrader::upgradeFromStore(const ImageStore& store, int id, const std::string& canInterface) {
+    // Pick the image matching the hardware the node reports
+    std::string hwVersion;
+    if (!readHardwareVersion(canInterface_, id, hwVersion, sdoClient_)) {
+        return false;
+    }
+
+    StoredImage image;
+    if (!store.lookup(hwVersion, image)) {
+        return false;
+    }
+    std::cout << "Selected image " << image.path << " for hardware version " << hwVersion << std::endl;
+    return upgrade(image, id, canInterface);
+}
+
+bool FirmwareUpgrader::upgradeImage(const uint8_t* firmwareDataPtr, size_t dataSize, const std::string& hardwareVersion,
+                                    const uint16_t* knownCrc, int id, const std::string& canInterface) {
     std::cout << "Hardware Version: " << hardwareVersion << std::endl;
-    std::cout << "Firmware CRC16: 0x" << std::hex << crcValue << std::endl;
 
-    // Example invalid length value
-    int invalidLength = 7 - lastSegmentSize;
+    // Skip nodes that already run this image
+    UpgradeCacheEntry imageInfo;
+    if (cache_ != NULL) {
+        imageInfo.imageSize = dataSize;
+        imageInfo.imageCrc = knownCrc != NULL ? *knownCrc : Crc16::compute(firmwareDataPtr, dataSize);
+        imageInfo.hardwareVersion = hardwareVersion;
+        if (isUpToDate(id, imageInfo)) {
+            return true;
+        }
+    }
+
+    // Send NMT restart command first
+    canInterface_.sendNMTRestart(id);
 
     bool ret;
     // Execute the steps with the new id parameter
@@ -79,10 +133,18 @@ bool FirmwareUpgrader::upgrade(const std::string& firmwarePath, int id, const st
         std::cerr << "sendESDO failed" << std::endl;
         return false;
     }
-    sleep(3);  // Sleep for 3 seconds
+    // Wait for the bootloader to come up instead of a fixed delay
+    if (!canInterface_.waitForNode(id, canInterface_.getBootWait().settleMs)) {
+        std::cerr << "Node " << id << " did not enter the bootloader within "
+                  << canInterface_.getBootWait().timeoutMs << " ms" << std::endl;
+        return false;
+    }
 
-    // Read hardware version before upgrade
-    std::string hwVersion = readHardwareVersion(id);
+    // Read hardware version before upgrade, the restart retired what was cached in the application
+    std::string hwVersion;
+    if (!readHardwareVersion(canInterface_, id, hwVersion, sdoClient_)) {
+        return false;
+    }
     std::cout << "Current Hardware Version: " << hwVersion << std::endl;
     
     // Compare hardware versions
@@ -93,26 +155,46 @@ bool FirmwareUpgrader::upgrade(const std::string& firmwarePath, int id, const st
         return false;
     }
 
-    struct can_frame blockDownloadInitResponse;
-    ret = sdoBlockDownloadInit(dataSize, id, blockDownloadInitResponse);
+    uint8_t blockSize;
+    size_t segmentBytes;
+    ret = sdoBlockDownloadInit(dataSize, id, blockSize, segmentBytes);
     if(!ret) {
         std::cerr << "sdoBlockDownloadInit failed" << std::endl;
         return false;
     }
-    ret = sendDataBlocks(firmwareDataPtr, dataSize, id);
+    // Unused bytes in the last classic segment. The end request has room for
+    // at most 7, FD transfers leave it at 0 and the server cuts at the announced size.
+    int invalidLength = 0;
+    if (segmentBytes == CLASSIC_SEGMENT_BYTES) {
+        int lastSegmentSize = dataSize % 7 == 0 ? 7 : dataSize % 7;
+        invalidLength = 7 - lastSegmentSize;
+    }
+    // CRC16 is computed block by block while the data is sent
+    uint16_t crcValue;
+    ret = sendDataBlocks(firmwareDataPtr, dataSize, id, blockSize, segmentBytes, crcValue);
     if(!ret) {
         std::cerr << "sendDataBlocks failed" << std::endl;
         return false;
     }
+    std::cout << "Firmware CRC16: 0x" << std::hex << crcValue << std::dec << std::endl;
     ret = sdoBlockDownloadEnd(crcValue, invalidLength, id);
     if(!ret) {
         std::cerr << "sdoBlockDownloadEnd failed" << std::endl;
         return false;
     }
 
+    // Read the image back from the bootloader before it starts the application
+    if (verify_) {
+        ret = verifyImage(firmwareDataPtr, dataSize, id);
+        if(!ret) {
+            std::cerr << "verifyImage failed" << std::endl;
+            return false;
+        }
+    }
+
     // Change node ID from 126 back to original ID
     std::cout << "Changing node ID from 126 back to " << id << "..." << std::endl;
-    sleep(3);  // Wait for the device to stabilize
+    // changeNodeId waits until the node answers under ID 126
     if (!canInterface_.changeNodeId(126, id, canInterface)) {
         std::cerr << "Failed to change node ID from 126 back to " << id << std::endl;
         std::cerr << "Please try to change the node ID manually using the --change-node-id command" << std::endl;
@@ -120,15 +202,60 @@ bool FirmwareUpgrader::upgrade(const std::string& firmwarePath, int id, const st
     } else {
         std::cout << "Node ID changed successfully from 126 back to " << id << std::endl;
     }
+
+    if (cache_ != NULL) {
+        recordUpgrade(id, canInterface, imageInfo);
+    }
     
     return true;
 }
 
+bool FirmwareUpgrader::isUpToDate(int id, const UpgradeCacheEntry& image) {
+    DeviceIdentity identity;
+    if (!readDeviceIdentity(canInterface_, id, identity, IDENTITY_OBJECT | IDENTITY_SOFTWARE, sdoClient_)) {
+        return false;
+    }
+
+    UpgradeCacheEntry entry;
+    if (!cache_->lookup(id, identity.serialNumber, entry)) {
+        return false;
+    }
+
+    // The cached software version must still be what the device reports, otherwise it was reflashed elsewhere
+    if (entry.imageSize != image.imageSize || entry.imageCrc != image.imageCrc ||
+        entry.hardwareVersion != image.hardwareVersion || entry.softwareVersion != identity.softwareVersion) {
+        return false;
+    }
+
+    std::cout << "Node " << id << " (serial " << std::hex << identity.serialNumber
+              << ") already runs this image (CRC16 0x" << image.imageCrc << ", software version "
+              << identity.softwareVersion << "), skipping upgrade" << std::dec << std::endl;
+    return true;
+}
+
+void FirmwareUpgrader::recordUpgrade(int id, const std::string& canInterface, UpgradeCacheEntry image) {
+    // changeNodeId leaves the session on the new ID, make sure the node answers under its original ID.
+    // It runs new software now whether or not its boot-up was seen.
+    DeviceIdentity identity;
+    forgetDeviceIdentity(canInterface_, id);
+    if (!canInterface_.initialize(canInterface, id) || !canInterface_.waitForNode(id, 0) ||
+        !readDeviceIdentity(canInterface_, id, identity, IDENTITY_OBJECT | IDENTITY_SOFTWARE, sdoClient_)) {
+        std::cerr << "Could not read identity after upgrade, not caching the result" << std::endl;
+        return;
+    }
+
+    image.nodeId = id;
+    image.serialNumber = identity.serialNumber;
+    image.softwareVersion = identity.softwareVersion;
+    cache_->store(image);
+}
+
 bool FirmwareUpgrader::sendESDO(int id) {
     struct can_frame response;
-    uint8_t data[8] = {0x23, 0x40, 0x40, 0x00, 0x75, 0x70, 0x64, 0x74};
+    // "updt" in ASCII
+    static constexpr od::SdoFrame ESDO = od::sdoDownload(od::EnterBootloader, 0x74647075);
     bool ret;
-    ret = canInterface_.sendSDOWithTimeout(data, 8, id, response);
+    ret = sdoTransaction(id, ESDO.data, response);
 
     if (!ret) {
         return false;
@@ -140,7 +267,7 @@ bool FirmwareUpgrader::sendESDO(int id) {
                   << std::hex 
                   << (response.data[4] | (response.data[5] << 8) | 
                       (response.data[6] << 16) | (response.data[7] << 24))
-                  << std::endl;
+                  << std::dec << std::endl;
         return false;
     }
 
@@ -149,23 +276,29 @@ bool FirmwareUpgrader::sendESDO(int id) {
         std::cerr << "Unexpected response code: 0x" 
                   << std::hex 
                   << static_cast<int>(response.data[0]) 
-                  << std::endl;
+                  << std::dec << std::endl;
         return false;
     }
 
     return true;
 }
 
-bool FirmwareUpgrader::sdoBlockDownloadInit(size_t byteCount, int id, struct can_frame& response) {
-    uint8_t data[8] = {
-        0xC6, 0x50, 0x1F, 0x00, 
-        static_cast<uint8_t>(byteCount & 0xFF), 
-        static_cast<uint8_t>((byteCount >> 8) & 0xFF), 
-        static_cast<uint8_t>((byteCount >> 16) & 0xFF),
-        0x00
-    };
+bool FirmwareUpgrader::requestBlockDownload(size_t byteCount, int id, bool fd, struct can_frame& response) {
+    od::SdoFrame request = od::sdoBlockDownload(od::ProgramData, static_cast<uint32_t>(byteCount));
+    return canInterface_.sendSDOWithTimeout(request.data, 8, id, response, fd);
+}
+
+bool FirmwareUpgrader::sdoBlockDownloadInit(size_t byteCount, int id, uint8_t& blockSize, size_t& segmentBytes) {
+    struct can_frame response;
+    bool fd = fd_ && canInterface_.isFdEnabled();
     bool ret;
-    ret = canInterface_.sendSDOWithTimeout(data, 8, id, response);
+    ret = requestBlockDownload(byteCount, id, fd, response);
+    if (fd && (!ret || response.data[0] == 0x80)) {
+        // A bootloader without FD support may not take the FD initiate, ask again in a classic frame
+        std::cout << "FD block download refused by node " << id << ", using classic frames" << std::endl;
+        fd = false;
+        ret = requestBlockDownload(byteCount, id, fd, response);
+    }
     if (!ret) {
         return false;
     }
@@ -175,31 +308,78 @@ bool FirmwareUpgrader::sdoBlockDownloadInit(size_t byteCount, int id, struct can
                   << std::hex 
                   << (response.data[4] | (response.data[5] << 8) | 
                       (response.data[6] << 16) | (response.data[7] << 24))
-                  << std::endl;
+                  << std::dec << std::endl;
         return false;
     }
 
+    // Verify response format (A0/A4 XX XX XX blksize 00 00 00)
+    if ((response.data[0] & 0xFB) != 0xA0) {
+        std::cerr << "Unexpected response code: 0x" 
+                  << std::hex 
+                  << static_cast<int>(response.data[0]) 
+                  << std::dec << std::endl;
+        return false;
+    }
+
+    // Number of segments per block chosen by the server
+    blockSize = response.data[4];
+    if (blockSize < 1 || blockSize > 127) {
+        std::cerr << "Invalid block size from server: " << static_cast<int>(blockSize) << std::endl;
+        return false;
+    }
+
+    // An FD capable server answers an FD initiate with its FD frame length in
+    // the otherwise reserved byte 5. Anything else keeps classic segments.
+    segmentBytes = CLASSIC_SEGMENT_BYTES;
+    size_t frameLength = response.data[5];
+    if (fd && frameLength > CAN_MAX_DLEN && frameLength <= CANFD_MAX_DLEN && fdFrameLength(frameLength) == frameLength) {
+        segmentBytes = frameLength - 1;
+        std::cout << "Block download in CAN FD frames of " << frameLength << " bytes" << std::endl;
+    }
+
     return true;
 }
 
-bool FirmwareUpgrader::sendDataBlocks(const uint8_t* data, size_t dataSize, int id) {
-    struct can_frame frame;
-    frame.can_id = id + 0x600; // Convert id to can_id
-    frame.can_dlc = 8;
-
-    const size_t BLOCK_SIZE = 127; // Maximum number of segments per block
-    size_t totalSegments = (dataSize + 6) / 7; // Calculate total number of segments
-    size_t currentSegment = 1;
+bool FirmwareUpgrader::sendDataBlocks(const uint8_t* data, size_t dataSize, int id, uint8_t blockSize, size_t segmentBytes,
+                                      uint16_t& crcValue) {
+    // One frame array per block, sent in a single batch. Classic segments go
+    // out as the can_frame prefix of each entry, FD segments as full frames.
+    bool fd = segmentBytes != CLASSIC_SEGMENT_BYTES;
+    std::vector<struct canfd_frame> frames(127);
+    for (size_t i = 0; i < frames.size(); i++) {
+        std::memset(&frames[i], 0, sizeof(frames[i]));
+        frames[i].can_id = id + 0x600; // Convert id to can_id
+        frames[i].len = 8;
+        if (fd) {
+            frames[i].flags = CANFD_BRS;
+        }
+    }
+    canInterface_.resetTxStats();
+
+    size_t totalSegments = (dataSize + segmentBytes - 1) / segmentBytes; // Calculate total number of segments
+    size_t ackedSegments = 0;                  // Segments confirmed by the server
+    size_t retransmitted = 0;
+    int failedBlocks = 0;
+    int frameGapUs = 0;
+    Crc16 crc;
+    size_t crcOffset = 0;  // Bytes already folded into the CRC
+
+    while (ackedSegments < totalSegments) {
+        // The server decides the block size, every block restarts at sequence number 1
+        size_t segmentsInBlock = std::min(static_cast<size_t>(blockSize), totalSegments - ackedSegments);
+
+        // Add data that is sent for the first time, retransmitted segments are already included
+        size_t blockEnd = std::min((ackedSegments + segmentsInBlock) * segmentBytes, dataSize);
+        if (blockEnd > crcOffset) {
+            crc.update(&data[crcOffset], blockEnd - crcOffset);
+            crcOffset = blockEnd;
+        }
 
-    // Process data in blocks of 127 segments
-    while (currentSegment <= totalSegments) {
-        // Calculate segments to send in this block
-        size_t segmentsInBlock = std::min(BLOCK_SIZE, totalSegments - currentSegment + 1);
-        
-        // Send segments in current block
+        // Build segments of current block
         for (size_t i = 1; i <= segmentsInBlock; i++) {
-            size_t dataOffset = (currentSegment - 1 + (i-1)) * 7;
-            bool isLastSegment = (currentSegment + (i-1)) == totalSegments;
+            struct canfd_frame& frame = frames[i - 1];
+            size_t dataOffset = (ackedSegments + (i-1)) * segmentBytes;
+            bool isLastSegment = (ackedSegments + i) == totalSegments;
             
             // Set sequence number (add 0x80 if it's the last segment)
             frame.data[0] = i & 0x7F;
@@ -207,54 +387,122 @@ bool FirmwareUpgrader::sendDataBlocks(const uint8_t* data, size_t dataSize, int
                 frame.data[0] |= 0x80;
             }
             
-            // Copy data (up to 7 bytes)
-            size_t bytesToCopy = std::min(size_t(7), dataSize - dataOffset);
+            // Copy data (up to one segment)
+            size_t bytesToCopy = std::min(segmentBytes, dataSize - dataOffset);
             std::memcpy(&frame.data[1], &data[dataOffset], bytesToCopy);
+            frame.len = fd ? fdFrameLength(1 + bytesToCopy) : 8;
             
             // Fill remaining bytes with zeros if needed
-            if (bytesToCopy < 7) {
-                std::memset(&frame.data[1 + bytesToCopy], 0, 7 - bytesToCopy);
+            if (1 + bytesToCopy < frame.len) {
+                std::memset(&frame.data[1 + bytesToCopy], 0, frame.len - 1 - bytesToCopy);
             }
+        }
 
-            if (write(canInterface_.getSocket(), &frame, sizeof(struct can_frame)) != sizeof(struct can_frame)) {
+        // Send the block in one batch, or frame by frame when pacing a lossy bus
+        if (frameGapUs == 0) {
+            if (!canInterface_.sendFrames(frames.data(), segmentsInBlock, fd, TX_QUEUE_TIMEOUT_MS)) {
                 std::cerr << "Error in sending data block" << std::endl;
                 return false;
             }
+        } else {
+            for (size_t i = 0; i < segmentsInBlock; i++) {
+                if (!canInterface_.sendFrames(&frames[i], 1, fd, TX_QUEUE_TIMEOUT_MS)) {
+                    std::cerr << "Error in sending data block" << std::endl;
+                    return false;
+                }
+                usleep(frameGapUs);
+            }
         }
 
-        // Wait for response after block
-        struct can_frame response;
-        struct timeval timeout;
-        timeout.tv_sec = 2;
-        timeout.tv_usec = 0;
-
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(canInterface_.getSocket(), &readfds);
-
-        int ret = select(canInterface_.getSocket() + 1, &readfds, NULL, NULL, &timeout);
-        if (ret == -1) {
-            std::cerr << "Error in select" << std::endl;
-            return false;
-        } else if (ret == 0) {
-            std::cerr << "Timeout waiting for response at segment " << currentSegment << std::endl;
+        uint8_t ackSeq;
+        if (!waitBlockAck(id, ackSeq, blockSize)) {
+            std::cerr << "Block download failed at segment " << ackedSegments + 1 << std::endl;
             return false;
         }
 
-        int nbytes = read(canInterface_.getSocket(), &response, sizeof(struct can_frame));
-        if (nbytes < 0) {
-            std::cerr << "Error in receiving response" << std::endl;
+        if (ackSeq > segmentsInBlock) {
+            std::cerr << "Invalid ackseq " << static_cast<int>(ackSeq)
+                      << " for block of " << segmentsInBlock << " segments" << std::endl;
             return false;
         }
 
-        // Verify response format (A2 XX XX 00 00 00 00 00)
-        if (response.data[0] != 0xA2) {
-            std::cerr << "Invalid response command specifier" << std::endl;
+        // Everything after ackseq was lost and is sent again in the next block
+        ackedSegments += ackSeq;
+        if (progress_) {
+            progress_(std::min(ackedSegments * segmentBytes, dataSize), dataSize);
+        }
+        if (ackSeq < segmentsInBlock) {
+            retransmitted += segmentsInBlock - ackSeq;
+            if (ackSeq == 0 && ++failedBlocks > MAX_BLOCK_RETRIES) {
+                std::cerr << "No progress after " << MAX_BLOCK_RETRIES << " blocks, giving up" << std::endl;
+                return false;
+            }
+            // Back off so the server has more time per frame
+            frameGapUs = std::min(frameGapUs * 2 + FRAME_GAP_STEP_US, MAX_FRAME_GAP_US);
+        } else {
+            failedBlocks = 0;
+            frameGapUs = std::max(frameGapUs - FRAME_GAP_STEP_US, 0);
+        }
+    }
+
+    if (retransmitted > 0) {
+        std::cout << "Block download needed " << retransmitted << " retransmitted segments" << std::endl;
+    }
+    const TxStats& stats = canInterface_.getTxStats();
+    std::cout << "Sent " << stats.frames << " frames in " << stats.syscalls << " syscalls ("
+              << static_cast<int>(stats.framesPerSecond()) << " frames/s, TX queue full "
+              << stats.queueFullWaits << " times)" << std::endl;
+    crcValue = crc.finalize();
+    return true;
+}
+
+bool FirmwareUpgrader::waitBlockAck(int id, uint8_t& ackSeq, uint8_t& blockSize) {
+    struct can_frame response;
+    uint64_t rxNs;
+
+    // A block cannot be acknowledged twice, so there is no retry: wait as long as all attempts would take
+    SdoTimeouts& timeouts = canInterface_.getSdoTimeouts();
+    int timeoutMs = timeouts.patienceMs(id, SdoTimeouts::BLOCK_ACK);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Skip frames that are not an SDO response from this node; heartbeats must not extend the wait
+    int remaining = timeoutMs;
+    for (;;) {
+        if (remaining <= 0 || !canInterface_.receiveFrame(response, remaining, &rxNs)) {
+            std::cerr << "Timeout waiting for block acknowledge (" << timeoutMs << " ms)" << std::endl;
             return false;
         }
-        // Move to next block
-        currentSegment += segmentsInBlock;
+        if ((response.can_id & CAN_SFF_MASK) == static_cast<canid_t>(0x580 + id)) {
+            break;
+        }
+        remaining = timeoutMs - elapsedMs(start);
     }
+    timeouts.sample(id, SdoTimeouts::BLOCK_ACK,
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    // From the last segment of the block leaving the host to its acknowledge
+    canInterface_.traceResponse("block-ack", id, od::ProgramData.index, od::ProgramData.subindex, rxNs);
+
+    if (response.data[0] == 0x80) {  // SDO abort code
+        std::cerr << "SDO block download failed with abort code: 0x" 
+                  << std::hex 
+                  << (response.data[4] | (response.data[5] << 8) | 
+                      (response.data[6] << 16) | (response.data[7] << 24))
+                  << std::dec << std::endl;
+        return false;
+    }
+
+    // Verify response format (A2 ackseq blksize 00 00 00 00 00)
+    if (response.data[0] != 0xA2) {
+        std::cerr << "Invalid response command specifier" << std::endl;
+        return false;
+    }
+
+    ackSeq = response.data[1];
+    if (response.data[2] < 1 || response.data[2] > 127) {
+        std::cerr << "Invalid block size from server: " << static_cast<int>(response.data[2]) << std::endl;
+        return false;
+    }
+    blockSize = response.data[2];
     return true;
 }
 
@@ -294,7 +542,7 @@ bool FirmwareUpgrader::sdoBlockDownloadEnd(uint16_t crc, int invalidLength, int
                   << std::hex 
                   << (response.data[4] | (response.data[5] << 8) | 
                       (response.data[6] << 16) | (response.data[7] << 24))
-                  << std::endl;
+                  << std::dec << std::endl;
         return false;
     }
 
@@ -303,7 +551,7 @@ bool FirmwareUpgrader::sdoBlockDownloadEnd(uint16_t crc, int invalidLength, int
         std::cerr << "Unexpected response code: 0x" 
                   << std::hex 
                   << static_cast<int>(response.data[0]) 
-                  << std::endl;
+                  << std::dec << std::endl;
         return false;
     }
 
@@ -311,14 +559,274 @@ bool FirmwareUpgrader::sdoBlockDownloadEnd(uint16_t crc, int invalidLength, int
     return true;
 }
 
-std::vector<uint8_t> FirmwareUpgrader::loadFirmwareData(const std::string& firmwarePath) {
-    std::ifstream file(firmwarePath, std::ios::binary);
-    if (!file) {
-        std::cerr << "Error opening firmware file: " << firmwarePath << std::endl;
-        return {};
+bool FirmwareUpgrader::sdoBlockUpload(int id, uint16_t index, uint8_t subindex, const UploadSink& sink, size_t& uploadedSize) {
+    struct can_frame response;
+    uint8_t data[8] = {
+        0xA4,  // Block upload initiate, CRC supported
+        static_cast<uint8_t>(index & 0xFF), static_cast<uint8_t>((index >> 8) & 0xFF), subindex,
+        UPLOAD_BLOCK_SIZE,
+        0x00,  // No protocol switch
+        0x00, 0x00
+    };
+
+    uploadedSize = 0;
+    if (!canInterface_.sendSDOWithTimeout(data, 8, id, response)) {
+        return false;
+    }
+    if (response.data[0] == 0x80) {  // SDO abort code
+        std::cerr << "SDO block upload initiate failed with abort code: 0x" 
+                  << std::hex 
+                  << (response.data[4] | (response.data[5] << 8) | 
+                      (response.data[6] << 16) | (response.data[7] << 24))
+                  << std::dec << std::endl;
+        return false;
+    }
+    // Verify response format (C0 | sc << 2 | s << 1, index, subindex, size)
+    if ((response.data[0] & 0xF9) != 0xC0) {
+        std::cerr << "Unexpected response code: 0x" 
+                  << std::hex 
+                  << static_cast<int>(response.data[0]) 
+                  << std::dec << std::endl;
+        return false;
+    }
+    bool serverCrc = (response.data[0] & 0x04) != 0;
+    size_t announcedSize = 0;
+    if (response.data[0] & 0x02) {
+        announcedSize = response.data[4] | (response.data[5] << 8) | (response.data[6] << 16) | (response.data[7] << 24);
+    }
+
+    // Start the transfer, the server answers with the first block
+    struct can_frame start;
+    start.can_id = id + 0x600;
+    start.can_dlc = 8;
+    std::memset(start.data, 0, 8);
+    start.data[0] = 0xA3;
+    if (!canInterface_.sendFrames(&start, 1, TX_QUEUE_TIMEOUT_MS)) {
+        std::cerr << "Error in starting block upload" << std::endl;
+        return false;
+    }
+
+    // The last 7 bytes are held back until the end frame tells how many are padding
+    Crc16 crc;
+    uint8_t holdback[7];
+    bool haveHoldback = false;
+    std::vector<uint8_t> blockData;
+    blockData.reserve(UPLOAD_BLOCK_SIZE * 7);
+    bool lastSegment = false;
+    size_t retransmitted = 0;
+
+    while (!lastSegment) {
+        uint8_t ackSeq;
+        if (!receiveUploadBlock(id, UPLOAD_BLOCK_SIZE, ackSeq, lastSegment, blockData)) {
+            sendAbort(id, index, subindex, 0x05040000);  // SDO protocol timed out
+            return false;
+        }
+        if (ackSeq < UPLOAD_BLOCK_SIZE && !lastSegment) {
+            retransmitted += UPLOAD_BLOCK_SIZE - ackSeq;
+        }
+
+        // Deliver everything accepted in this block except the newest segment
+        for (size_t offset = 0; offset < blockData.size(); offset += 7) {
+            if (haveHoldback) {
+                crc.update(holdback, 7);
+                if (!sink(holdback, 7)) {
+                    sendAbort(id, index, subindex, 0x08000000);  // General error
+                    return false;
+                }
+                uploadedSize += 7;
+            }
+            std::memcpy(holdback, &blockData[offset], 7);
+            haveHoldback = true;
+        }
+
+        struct can_frame ack;
+        ack.can_id = id + 0x600;
+        ack.can_dlc = 8;
+        std::memset(ack.data, 0, 8);
+        ack.data[0] = 0xA2;
+        ack.data[1] = ackSeq;
+        ack.data[2] = UPLOAD_BLOCK_SIZE;
+        if (!canInterface_.sendFrames(&ack, 1, TX_QUEUE_TIMEOUT_MS)) {
+            std::cerr << "Error in sending block upload acknowledge" << std::endl;
+            return false;
+        }
+        if (progress_ && announcedSize > 0) {
+            progress_(std::min(uploadedSize, announcedSize), announcedSize);
+        }
+    }
+
+    // End of transfer: C1 | n << 2, CRC
+    int endTimeoutMs = canInterface_.getSdoTimeouts().patienceMs(id, SdoTimeouts::REQUEST);
+    std::chrono::steady_clock::time_point endStart = std::chrono::steady_clock::now();
+    int remaining = endTimeoutMs;
+    for (;;) {
+        if (remaining <= 0 || !canInterface_.receiveFrame(response, remaining)) {
+            std::cerr << "Timeout waiting for block upload end" << std::endl;
+            sendAbort(id, index, subindex, 0x05040000);
+            return false;
+        }
+        if ((response.can_id & CAN_SFF_MASK) == static_cast<canid_t>(0x580 + id)) {
+            break;
+        }
+        remaining = endTimeoutMs - elapsedMs(endStart);
+    }
+
+    if ((response.data[0] & 0xE3) != 0xC1) {
+        std::cerr << "Unexpected block upload end: 0x" << std::hex << static_cast<int>(response.data[0]) << std::dec << std::endl;
+        sendAbort(id, index, subindex, 0x05040001);  // Invalid command specifier
+        return false;
+    }
+    size_t unused = (response.data[0] >> 2) & 0x07;
+    if (haveHoldback) {
+        crc.update(holdback, 7 - unused);
+        if (!sink(holdback, 7 - unused)) {
+            sendAbort(id, index, subindex, 0x08000000);
+            return false;
+        }
+        uploadedSize += 7 - unused;
+    }
+
+    uint16_t serverCrcValue = response.data[1] | (response.data[2] << 8);
+    if (serverCrc && serverCrcValue != crc.finalize()) {
+        std::cerr << "Block upload CRC mismatch: server 0x" << std::hex << serverCrcValue
+                  << ", received 0x" << crc.finalize() << std::dec << std::endl;
+        sendAbort(id, index, subindex, 0x05040004);  // CRC error
+        return false;
+    }
+    if (announcedSize != 0 && uploadedSize != announcedSize) {
+        std::cerr << "Block upload size mismatch: announced " << announcedSize
+                  << ", received " << uploadedSize << std::endl;
+        sendAbort(id, index, subindex, 0x06070010);  // Length does not match
+        return false;
+    }
+
+    struct can_frame end;
+    end.can_id = id + 0x600;
+    end.can_dlc = 8;
+    std::memset(end.data, 0, 8);
+    end.data[0] = 0xA1;
+    if (!canInterface_.sendFrames(&end, 1, TX_QUEUE_TIMEOUT_MS)) {
+        std::cerr << "Error in ending block upload" << std::endl;
+        return false;
+    }
+
+    if (retransmitted > 0) {
+        std::cout << "Block upload needed " << retransmitted << " retransmitted segments" << std::endl;
+    }
+    return true;
+}
+
+bool FirmwareUpgrader::receiveUploadBlock(int id, uint8_t blockSize, uint8_t& ackSeq, bool& lastSegment,
+                                          std::vector<uint8_t>& blockData) {
+    struct can_frame frame;
+    ackSeq = 0;
+    lastSegment = false;
+    blockData.clear();
+
+    // Accept segments in order, anything after a gap is dropped and resent by the server
+    const SdoTimeouts& timeouts = canInterface_.getSdoTimeouts();
+    int firstTimeoutMs = timeouts.patienceMs(id, SdoTimeouts::REQUEST);
+    int gapTimeoutMs = std::min(timeouts.timeoutMs(id, SdoTimeouts::REQUEST, 0), UPLOAD_SEGMENT_TIMEOUT_MS);
+    bool firstFrame = true;
+    for (;;) {
+        int timeoutMs = firstFrame ? firstTimeoutMs : gapTimeoutMs;
+        if (!canInterface_.receiveFrame(frame, timeoutMs)) {
+            if (firstFrame) {
+                std::cerr << "Timeout waiting for block upload data" << std::endl;
+                return false;
+            }
+            break;  // Tail of the block was lost
+        }
+        if ((frame.can_id & CAN_SFF_MASK) != static_cast<canid_t>(0x580 + id)) {
+            continue;
+        }
+        firstFrame = false;
+
+        if (frame.data[0] == 0x80) {  // SDO abort code
+            std::cerr << "SDO block upload aborted with code: 0x" 
+                      << std::hex 
+                      << (frame.data[4] | (frame.data[5] << 8) | 
+                          (frame.data[6] << 16) | (frame.data[7] << 24))
+                      << std::dec << std::endl;
+            return false;
+        }
+
+        uint8_t seq = frame.data[0] & 0x7F;
+        if (seq == ackSeq + 1) {
+            ackSeq = seq;
+            blockData.insert(blockData.end(), &frame.data[1], &frame.data[8]);
+            if (frame.data[0] & 0x80) {
+                lastSegment = true;
+                break;
+            }
+        }
+        if (seq >= blockSize) {
+            break;
+        }
     }
+    return true;
+}
 
-    return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+void FirmwareUpgrader::sendAbort(int id, uint16_t index, uint8_t subindex, uint32_t abortCode) {
+    struct can_frame frame;
+    frame.can_id = id + 0x600;
+    frame.can_dlc = 8;
+    frame.data[0] = 0x80;
+    frame.data[1] = index & 0xFF;
+    frame.data[2] = (index >> 8) & 0xFF;
+    frame.data[3] = subindex;
+    for (int i = 0; i < 4; i++) {
+        frame.data[4 + i] = (abortCode >> (i * 8)) & 0xFF;
+    }
+    canInterface_.sendFrames(&frame, 1, TX_QUEUE_TIMEOUT_MS);
+}
+
+bool FirmwareUpgrader::verifyImage(const uint8_t* data, size_t dataSize, int id) {
+    std::cout << "Verifying image by block upload..." << std::endl;
+
+    // Compare each chunk as it arrives, nothing is buffered
+    size_t offset = 0;
+    UploadSink compare = [&](const uint8_t* chunk, size_t length) {
+        if (offset + length > dataSize || std::memcmp(&data[offset], chunk, length) != 0) {
+            std::cerr << "Readback differs from image near offset " << offset << std::endl;
+            return false;
+        }
+        offset += length;
+        return true;
+    };
+
+    size_t uploadedSize;
+    if (!sdoBlockUpload(id, od::ProgramNumber1.index, od::ProgramNumber1.subindex, compare, uploadedSize)) {
+        return false;
+    }
+    if (uploadedSize != dataSize) {
+        std::cerr << "Readback size " << uploadedSize << " differs from image size " << dataSize << std::endl;
+        return false;
+    }
+
+    std::cout << "Image verified (" << uploadedSize << " bytes)" << std::endl;
+    return true;
+}
+
+bool FirmwareUpgrader::dumpImage(int id, const std::string& outputPath) {
+    std::ofstream out(outputPath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error opening output file: " << outputPath << std::endl;
+        return false;
+    }
+
+    UploadSink write = [&out](const uint8_t* chunk, size_t length) {
+        out.write(reinterpret_cast<const char*>(chunk), length);
+        return static_cast<bool>(out);
+    };
+
+    size_t uploadedSize;
+    if (!sdoBlockUpload(id, od::ProgramNumber1.index, od::ProgramNumber1.subindex, write, uploadedSize)) {
+        return false;
+    }
+
+    std::cout << "Dumped " << uploadedSize << " bytes to " << outputPath << std::endl;
+    return true;
 }
 
 std::string FirmwareUpgrader::getHardwareVersion(const uint8_t* firmwareDataPtr, size_t dataSize) {
@@ -350,45 +858,3 @@ std::string FirmwareUpgrader::getHardwareVersion(const uint8_t* firmwareDataPtr,
         return "0.0.0.0";
     }
 }
-
-std::string FirmwareUpgrader::readHardwareVersion(int id) {
-    struct can_frame response;
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-
-    // Read 4 bytes from index 0x1009
-    for (int i = 1; i <= 4; i++) {
-        uint8_t data[8] = {
-            0x40, 0x09, 0x10, static_cast<uint8_t>(i),  // SDO read command for index 0x1009
-            0x00, 0x00, 0x00, 0x00
-        };
-
-        if (!canInterface_.sendSDOWithTimeout(data, 8, id, response)) {
-            std::cerr << "Failed to read byte " << i << " of hardware version" << std::endl;
-            return "0.0.0.0";
-        }
-
-        // Check if response is valid (should start with 0x43)
-        if (response.data[0] != 0x4f) {
-            std::cerr << "Invalid response format for byte " << i << std::endl;
-            return "0.0.0.0";
-        }
-
-        // Add the byte to the version string
-        ss << std::setw(2) << static_cast<int>(response.data[4]);
-        if (i < 4) {
-            ss << ".";
-        }
-    }
-
-    return ss.str();
-}
-
-uint16_t FirmwareUpgrader::crc16(const uint8_t* data, size_t length) {
-    uint16_t crcValue = 0x0000;
-    for (size_t i = 0; i < length; ++i) {
-        crcValue = (crcValue << 8) ^ crctable[(crcValue >> 8) ^ data[i]];
-        crcValue &= 0xFFFF; // Ensure CRC remains 16 bits
-    }
-    return crcValue;
-} 
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "can_interface.hpp"
+#include "upgrade_cache.hpp"
+#include "image_store.hpp"
+#include "sdo_client.hpp"
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -9,17 +13,43 @@ public:
     FirmwareUpgrader(CanInterface& canInterface);
     
     bool upgrade(const std::string& firmwarePath, int id, const std::string& canInterface);
+    bool upgrade(const StoredImage& image, int id, const std::string& canInterface);
+    bool upgradeFromStore(const ImageStore& store, int id, const std::string& canInterface);
+    bool dumpImage(int id, const std::string& outputPath);
+    void setProgressCallback(const std::function<void(size_t sent, size_t total)>& callback) { progress_ = callback; }
+    void setUpgradeCache(UpgradeCache* cache) { cache_ = cache; }
+    void setVerify(bool verify) { verify_ = verify; }
+    void setSdoClient(AsyncSdoClient* sdoClient) { sdoClient_ = sdoClient; }
+    // Offer CAN FD segments for block download, used when the interface and the bootloader support them
+    void setFdMode(bool fd) { fd_ = fd; }
+
+    static std::string getHardwareVersion(const uint8_t* firmwareDataPtr, size_t dataSize);
     
 private:
     CanInterface& canInterface_;
+    std::function<void(size_t sent, size_t total)> progress_;
+    UpgradeCache* cache_;
+    bool verify_;
+    AsyncSdoClient* sdoClient_;  // Optional, used for the expedited requests around the block transfer
+    bool fd_;
     
+    bool sdoTransaction(int id, const uint8_t* data, struct can_frame& response);
+    bool upgradeImage(const uint8_t* firmwareDataPtr, size_t dataSize, const std::string& hardwareVersion,
+                      const uint16_t* knownCrc, int id, const std::string& canInterface);
+    bool isUpToDate(int id, const UpgradeCacheEntry& image);
+    void recordUpgrade(int id, const std::string& canInterface, UpgradeCacheEntry image);
     bool sendESDO(int id);
-    bool sdoBlockDownloadInit(size_t byteCount, int id, struct can_frame& response);
-    bool sendDataBlocks(const uint8_t* data, size_t dataSize, int id);
+    bool sdoBlockDownloadInit(size_t byteCount, int id, uint8_t& blockSize, size_t& segmentBytes);
+    bool requestBlockDownload(size_t byteCount, int id, bool fd, struct can_frame& response);
+    bool sendDataBlocks(const uint8_t* data, size_t dataSize, int id, uint8_t blockSize, size_t segmentBytes,
+                        uint16_t& crcValue);
+    bool waitBlockAck(int id, uint8_t& ackSeq, uint8_t& blockSize);
     bool sdoBlockDownloadEnd(uint16_t crc, int invalidLength, int id);
-    
-    std::vector<uint8_t> loadFirmwareData(const std::string& firmwarePath);
-    std::string getHardwareVersion(const uint8_t* firmwareDataPtr, size_t dataSize);
-    std::string readHardwareVersion(int id);
-    uint16_t crc16(const uint8_t* data, size_t length);
+
+    typedef std::function<bool(const uint8_t* data, size_t length)> UploadSink;
+    bool sdoBlockUpload(int id, uint16_t index, uint8_t subindex, const UploadSink& sink, size_t& uploadedSize);
+    bool receiveUploadBlock(int id, uint8_t blockSize, uint8_t& ackSeq, bool& lastSegment,
+                            std::vector<uint8_t>& blockData);
+    void sendAbort(int id, uint16_t index, uint8_t subindex, uint32_t abortCode);
+    bool verifyImage(const uint8_t* data, size_t dataSize, int id);
 }; 
\ No newline at end of file
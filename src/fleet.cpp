@@ -0,0 +1,165 @@
+#include "fleet.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+FleetRunner::FleetRunner(const BootWaitConfig& bootWait) : bootWait_(bootWait), tracer_(NULL), recorder_(NULL), fd_(false), nodesPerBus_(1) {}
+
+std::vector<FleetResult> FleetRunner::run(const std::vector<FleetTarget>& targets, const Job& job) {
+    std::vector<FleetResult> results(targets.size());
+
+    // Group targets by bus, keeping the requested order within each bus
+    std::map<std::string, std::vector<size_t> > buses;
+    for (size_t i = 0; i < targets.size(); i++) {
+        buses[targets[i].canInterface].push_back(i);
+    }
+
+    std::vector<std::thread> workers;
+    for (std::map<std::string, std::vector<size_t> >::const_iterator it = buses.begin(); it != buses.end(); ++it) {
+        workers.push_back(std::thread(&FleetRunner::runBus, this, std::cref(it->second),
+                                      std::cref(targets), std::cref(job), std::ref(results)));
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    return results;
+}
+
+void FleetRunner::runBus(const std::vector<size_t>& indices, const std::vector<FleetTarget>& targets,
+                         const Job& job, std::vector<FleetResult>& results) {
+    // One socket for all targets on this bus, each job only moves the filter to its node
+    std::shared_ptr<BusSession> session = BusSession::open(targets[indices[0]].canInterface);
+
+    // Each worker has its own CanInterface, so every node gets its own SDO
+    // stream and inbox while all of them share the session's socket
+    std::atomic<size_t> next(0);
+    std::function<void()> worker = [&]() {
+        for (size_t n = next++; n < indices.size(); n = next++) {
+            runTarget(targets[indices[n]], n, indices.size(), job, results[indices[n]]);
+        }
+    };
+
+    size_t count = std::min(std::max<size_t>(nodesPerBus_, 1), indices.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < count; i++) {
+        workers.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+void FleetRunner::runTarget(const FleetTarget& target, size_t position, size_t count, const Job& job, FleetResult& result) {
+    result.target = target;
+    result.success = false;
+
+    // Lines are formatted locally, std::cout may be left in any state by a job
+    {
+        std::ostringstream line;
+        line << "[" << target.canInterface << ":" << target.nodeId << "] started ("
+             << position + 1 << "/" << count << " on this bus)";
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        std::cout << line.str() << std::endl;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CanInterface can;
+    can.setBootWait(bootWait_);
+    can.setTracer(tracer_);
+    can.setRecorder(recorder_);
+    can.setSdoTimeoutPolicy(sdoTimeoutPolicy_);
+    can.setFdMode(fd_);
+    if (can.initialize(target.canInterface, target.nodeId)) {
+        int lastPercent = -1;
+        ProgressFn progress = [this, &target, &lastPercent](size_t done, size_t total) {
+            reportProgress(target, done, total, lastPercent);
+        };
+        result.success = job(can, target, progress);
+        can.close();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ostringstream line;
+    line << "[" << target.canInterface << ":" << target.nodeId << "] "
+         << (result.success ? "done" : "FAILED") << " after " << result.seconds << " s";
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    std::cout << line.str() << std::endl;
+}
+
+void FleetRunner::reportProgress(const FleetTarget& target, size_t done, size_t total, int& lastPercent) {
+    if (total == 0) {
+        return;
+    }
+
+    // Report in 10% steps so parallel buses do not flood the terminal
+    int percent = static_cast<int>(done * 100 / total);
+    if (percent / 10 == lastPercent / 10 && percent != 100) {
+        return;
+    }
+    lastPercent = percent;
+
+    std::ostringstream line;
+    line << "[" << target.canInterface << ":" << target.nodeId << "] " << percent << "%";
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    std::cout << line.str() << std::endl;
+}
+
+void FleetRunner::printSummary(const std::vector<FleetResult>& results) {
+    size_t failed = 0;
+    std::ostringstream summary;
+    summary << "Fleet summary:\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const FleetResult& result = results[i];
+        summary << "  " << result.target.canInterface << " node " << result.target.nodeId << " "
+                << result.target.path << ": " << (result.success ? "OK" : "FAILED")
+                << " (" << result.seconds << " s)\n";
+        if (!result.success) {
+            failed++;
+        }
+    }
+    summary << results.size() - failed << " succeeded, " << failed << " failed";
+    std::cout << summary.str() << std::endl;
+}
+
+bool FleetRunner::parseTargets(const std::string& targetsPath, std::vector<FleetTarget>& targets) {
+    std::ifstream file(targetsPath);
+    if (!file) {
+        std::cerr << "Error opening targets file: " << targetsPath << std::endl;
+        return false;
+    }
+
+    // One target per line: <can_interface> <id> <file>, '#' starts a comment
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream fields(line);
+        FleetTarget target;
+        if (!(fields >> target.canInterface)) {
+            continue;  // Empty line
+        }
+        if (!(fields >> target.nodeId >> target.path) || target.nodeId < 1 || target.nodeId > 127) {
+            std::cerr << "Invalid target on line " << lineNumber << " of " << targetsPath << std::endl;
+            return false;
+        }
+        targets.push_back(target);
+    }
+
+    if (targets.empty()) {
+        std::cerr << "No targets in " << targetsPath << std::endl;
+        return false;
+    }
+    return true;
+}
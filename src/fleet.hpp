@@ -0,0 +1,56 @@
+#pragma once
+
+#include "can_interface.hpp"
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct FleetTarget {
+    std::string canInterface;
+    int nodeId;
+    std::string path;  // Firmware image or cfg file for this node
+};
+
+struct FleetResult {
+    FleetTarget target;
+    bool success;
+    double seconds;
+};
+
+// Runs one job per target, one worker thread per CAN interface.
+// Targets on the same interface are processed in the order given, up to
+// setNodesPerBus() of them at the same time.
+class FleetRunner {
+public:
+    typedef std::function<void(size_t done, size_t total)> ProgressFn;
+    typedef std::function<bool(CanInterface& can, const FleetTarget& target, const ProgressFn& progress)> Job;
+
+    FleetRunner(const BootWaitConfig& bootWait);
+
+    void setTracer(LatencyTracer* tracer) { tracer_ = tracer; }
+    void setRecorder(FrameRecorder* recorder) { recorder_ = recorder; }
+    void setSdoTimeoutPolicy(const SdoTimeoutPolicy& policy) { sdoTimeoutPolicy_ = policy; }
+    void setFdMode(bool fd) { fd_ = fd; }
+    // Targets of one bus worked on concurrently, 1 (the default) runs them one after another
+    void setNodesPerBus(size_t count) { nodesPerBus_ = count; }
+
+    std::vector<FleetResult> run(const std::vector<FleetTarget>& targets, const Job& job);
+    void printSummary(const std::vector<FleetResult>& results);
+
+    static bool parseTargets(const std::string& targetsPath, std::vector<FleetTarget>& targets);
+
+private:
+    BootWaitConfig bootWait_;
+    LatencyTracer* tracer_;
+    FrameRecorder* recorder_;
+    SdoTimeoutPolicy sdoTimeoutPolicy_;
+    bool fd_;
+    size_t nodesPerBus_;
+    std::mutex outputMutex_;
+
+    void runBus(const std::vector<size_t>& indices, const std::vector<FleetTarget>& targets,
+                const Job& job, std::vector<FleetResult>& results);
+    void runTarget(const FleetTarget& target, size_t position, size_t count, const Job& job, FleetResult& result);
+    void reportProgress(const FleetTarget& target, size_t done, size_t total, int& lastPercent);
+};
@@ -0,0 +1,387 @@
+#include "frame_demux.hpp"
+#include <linux/errqueue.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+FrameQueue::FrameQueue() : sleeping_(false), woken_(false) {}
+
+bool FrameQueue::push(const TimedFrame& item) {
+    if (!ring_.push(item)) {
+        return false;
+    }
+    // Only pay for a wakeup when the consumer is actually parked. The fence
+    // orders the ring push before the flag load; it pairs with the one in
+    // pop, so either we see the flag or the consumer sees the frame.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.notify_one();
+    }
+    return true;
+}
+
+bool FrameQueue::take(struct can_frame& frame, uint64_t* timestampNs) {
+    TimedFrame item;
+    if (!ring_.pop(item)) {
+        return false;
+    }
+    frame = item.frame;
+    if (timestampNs != NULL) {
+        *timestampNs = item.timestampNs;
+    }
+    return true;
+}
+
+bool FrameQueue::tryPop(struct can_frame& frame, uint64_t* timestampNs) {
+    return take(frame, timestampNs);
+}
+
+bool FrameQueue::pop(struct can_frame& frame, int timeoutMs, uint64_t* timestampNs) {
+    if (take(frame, timestampNs)) {
+        return true;
+    }
+
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        sleeping_.store(true);
+        // Re-check after announcing we sleep, the producer may have pushed in between
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (take(frame, timestampNs)) {
+            sleeping_.store(false);
+            return true;
+        }
+        // Checked under the mutex wake() takes before notifying, so no wakeup is lost
+        if (woken_.exchange(false)) {
+            sleeping_.store(false);
+            return false;
+        }
+        if (ready_.wait_until(lock, deadline) == std::cv_status::timeout) {
+            sleeping_.store(false);
+            return take(frame, timestampNs);
+        }
+    }
+}
+
+void FrameQueue::wake() {
+    woken_.store(true);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.notify_one();
+}
+
+void FrameQueue::clear() {
+    TimedFrame item;
+    while (ring_.pop(item)) {
+    }
+}
+
+FrameDemux::FrameDemux()
+    : socket_(-1), wakeup_(-1), tap_(NULL), received_(0), delivered_(0), unrouted_(0), mismatched_(0), overflows_(0) {
+    for (size_t i = 0; i < COB_ID_COUNT; i++) {
+        routes_[i].store(NULL);
+        txTimestamps_[i].store(0);
+    }
+    for (size_t i = 0; i < 128; i++) {
+        sdoClaims_[i].store(NULL);
+        expectedMux_[i].store(0);
+        boots_[i].store(0);
+    }
+}
+
+FrameDemux::~FrameDemux() {
+    stop();
+}
+
+bool FrameDemux::start(int socket) {
+    stop();
+
+    wakeup_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_ < 0) {
+        std::cerr << "Error creating demux wakeup descriptor" << std::endl;
+        return false;
+    }
+    socket_ = socket;
+    thread_ = std::thread(&FrameDemux::run, this);
+    return true;
+}
+
+void FrameDemux::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        if (write(wakeup_, &one, sizeof(one)) < 0) {
+            std::cerr << "Error stopping demux" << std::endl;
+        }
+        thread_.join();
+    }
+    if (wakeup_ >= 0) {
+        ::close(wakeup_);
+        wakeup_ = -1;
+    }
+    socket_ = -1;
+}
+
+void FrameDemux::route(canid_t cobId, FrameQueue* queue) {
+    routes_[cobId & CAN_SFF_MASK].store(queue, std::memory_order_release);
+}
+
+void FrameDemux::claimSdoResponses(int nodeId, FrameQueue* queue) {
+    sdoClaims_[nodeId & 0x7F].store(queue, std::memory_order_release);
+}
+
+void FrameDemux::detach(FrameQueue* queue) {
+    for (size_t i = 0; i < COB_ID_COUNT; i++) {
+        FrameQueue* expected = queue;
+        routes_[i].compare_exchange_strong(expected, NULL);
+    }
+    for (size_t i = 0; i < 128; i++) {
+        FrameQueue* expected = queue;
+        sdoClaims_[i].compare_exchange_strong(expected, NULL);
+    }
+    // A batch in progress may still hold the old route, wait for it to finish
+    std::lock_guard<std::mutex> lock(dispatchMutex_);
+}
+
+void FrameDemux::setTap(FrameRecorder::Tap* tap) {
+    tap_.store(tap);
+    std::lock_guard<std::mutex> lock(dispatchMutex_);
+}
+
+uint64_t FrameDemux::lastTxTimestamp(canid_t cobId) const {
+    return txTimestamps_[cobId & CAN_SFF_MASK].load();
+}
+
+void FrameDemux::expectSdoResponse(int nodeId, uint16_t index, uint8_t subindex) {
+    expectedMux_[nodeId & 0x7F].store(MUX_VALID | (static_cast<uint32_t>(index) << 8) | subindex);
+}
+
+void FrameDemux::expectAnySdoResponse(int nodeId) {
+    expectedMux_[nodeId & 0x7F].store(0);
+}
+
+uint32_t FrameDemux::bootCount(int nodeId) const {
+    return boots_[nodeId & 0x7F].load();
+}
+
+void FrameDemux::noteReset(int nodeId) {
+    if (nodeId != 0) {
+        boots_[nodeId & 0x7F]++;
+        return;
+    }
+    for (size_t i = 0; i < 128; i++) {
+        boots_[i]++;
+    }
+}
+
+FrameDemux::Stats FrameDemux::getStats() const {
+    Stats stats;
+    stats.received = received_.load();
+    stats.delivered = delivered_.load();
+    stats.unrouted = unrouted_.load();
+    stats.mismatched = mismatched_.load();
+    stats.overflows = overflows_.load();
+    return stats;
+}
+
+static uint64_t realtimeNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+// Software timestamp from SO_TIMESTAMPING, 0 when the kernel attached none
+static uint64_t softwareTimestamp(struct msghdr* msg) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPING) {
+            struct scm_timestamping ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return static_cast<uint64_t>(ts.ts[0].tv_sec) * 1000000000ULL + ts.ts[0].tv_nsec;
+        }
+    }
+    return 0;
+}
+
+static const size_t CONTROL_SIZE = CMSG_SPACE(sizeof(struct scm_timestamping)) + CMSG_SPACE(sizeof(struct sock_extended_err));
+
+void FrameDemux::run() {
+    const unsigned int BATCH = 32;
+    // FD sized buffers, an FD socket delivers classic frames as CAN_MTU and FD frames as CANFD_MTU
+    struct canfd_frame frames[BATCH];
+    struct iovec iovs[BATCH];
+    struct mmsghdr msgs[BATCH];
+    uint64_t control[BATCH][(CONTROL_SIZE + 7) / 8];
+    for (unsigned int i = 0; i < BATCH; i++) {
+        iovs[i].iov_base = &frames[i];
+        iovs[i].iov_len = sizeof(struct canfd_frame);
+        std::memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    struct pollfd fds[2];
+    fds[0].fd = socket_;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeup_;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error in demux poll" << std::endl;
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            return;
+        }
+        if (fds[0].revents & (POLLHUP | POLLNVAL)) {
+            std::cerr << "CAN socket closed under the demux" << std::endl;
+            return;
+        }
+        // POLLERR signals TX timestamps on the error queue. Take them before
+        // the responses so a waiter always sees the request's TX time.
+        if ((fds[0].revents & POLLERR) && drainErrorQueue() == 0) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(socket_, SOL_SOCKET, SO_ERROR, &error, &length);
+            std::cerr << "CAN socket error: " << strerror(error) << std::endl;
+            return;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        // Everything that is queued in one syscall. The kernel shrinks
+        // msg_controllen to what it used, so reset it for every batch.
+        for (unsigned int i = 0; i < BATCH; i++) {
+            msgs[i].msg_hdr.msg_control = control[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+        }
+        int count = recvmmsg(socket_, msgs, BATCH, MSG_DONTWAIT, NULL);
+        std::lock_guard<std::mutex> lock(dispatchMutex_);
+        FrameRecorder::Tap* tap = tap_.load();
+        uint64_t fallback = 0;
+        for (int i = 0; i < count; i++) {
+            uint64_t timestampNs = softwareTimestamp(&msgs[i].msg_hdr);
+            if (timestampNs == 0) {
+                // No SO_TIMESTAMPING on this socket, our own clock is the next best thing
+                if (fallback == 0) {
+                    fallback = realtimeNs();
+                }
+                timestampNs = fallback;
+            }
+            if (tap != NULL) {
+                tap->record(false, frames[i], msgs[i].msg_len == CANFD_MTU, timestampNs);
+            }
+            // Consumers speak classic frames, longer FD payloads have no consumer here
+            if (frames[i].len > CAN_MAX_DLEN) {
+                received_++;
+                unrouted_++;
+                continue;
+            }
+            TimedFrame item;
+            std::memcpy(&item.frame, &frames[i], sizeof(struct can_frame));
+            item.timestampNs = timestampNs;
+            dispatch(item);
+        }
+    }
+}
+
+// SDO server responses that echo index/subindex in bytes 1-3
+static bool hasMultiplexer(uint8_t cs) {
+    return (cs & 0xE0) == 0x40 ||                       // Upload initiate
+           (cs & 0xE0) == 0x60 ||                       // Download initiate
+           cs == 0x80 ||                                // Abort
+           ((cs & 0xE0) == 0xA0 && (cs & 0x03) == 0) || // Block download initiate
+           ((cs & 0xE0) == 0xC0 && (cs & 0x01) == 0);   // Block upload initiate
+}
+
+size_t FrameDemux::drainErrorQueue() {
+    size_t drained = 0;
+    for (;;) {
+        struct canfd_frame frame;
+        struct iovec iov;
+        iov.iov_base = &frame;
+        iov.iov_len = sizeof(frame);
+        uint64_t control[(CONTROL_SIZE + 7) / 8];
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        // The error queue returns a copy of the sent frame, so we know its COB-ID
+        ssize_t n = recvmsg(socket_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+        if (n < static_cast<ssize_t>(sizeof(canid_t))) {
+            return drained;
+        }
+        drained++;
+        uint64_t timestamp = softwareTimestamp(&msg);
+        if (timestamp != 0 && !(frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG))) {
+            txTimestamps_[frame.can_id & CAN_SFF_MASK].store(timestamp);
+        }
+    }
+}
+
+void FrameDemux::dispatch(const TimedFrame& item) {
+    const struct can_frame& frame = item.frame;
+    received_++;
+    if (frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) {
+        unrouted_++;
+        return;
+    }
+
+    canid_t cobId = frame.can_id & CAN_SFF_MASK;
+    if (cobId > 0x700 && cobId <= 0x77F && frame.can_dlc >= 1 && frame.data[0] == 0x00) {
+        boots_[cobId - 0x700]++;  // Boot-up message
+    } else if (cobId == 0x000 && frame.can_dlc >= 2 && (frame.data[0] == 0x81 || frame.data[0] == 0x82)) {
+        noteReset(frame.data[1]);  // Reset by another NMT master
+    }
+
+    // The SDO client checks the multiplexer itself
+    if (cobId > 0x580 && cobId <= 0x5FF) {
+        FrameQueue* claim = sdoClaims_[cobId - 0x580].load(std::memory_order_acquire);
+        if (claim != NULL) {
+            deliver(claim, item);
+            return;
+        }
+    }
+
+    FrameQueue* queue = routes_[cobId].load(std::memory_order_acquire);
+    if (queue == NULL) {
+        unrouted_++;
+        return;
+    }
+
+    if (cobId > 0x580 && cobId <= 0x5FF) {
+        int nodeId = cobId - 0x580;
+        uint32_t expected = expectedMux_[nodeId].load();
+        if ((expected & MUX_VALID) && hasMultiplexer(frame.data[0])) {
+            uint32_t mux = (static_cast<uint32_t>(frame.data[1] | (frame.data[2] << 8)) << 8) | frame.data[3];
+            if (mux != (expected & ~MUX_VALID)) {
+                mismatched_++;
+                return;
+            }
+            // The expectation covers exactly one response, later segments carry no multiplexer
+            expectedMux_[nodeId].compare_exchange_strong(expected, 0);
+        }
+    }
+    deliver(queue, item);
+}
+
+void FrameDemux::deliver(FrameQueue* queue, const TimedFrame& item) {
+    if (queue->push(item)) {
+        delivered_++;
+    } else {
+        overflows_++;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "spsc_ring.hpp"
+#include "frame_recorder.hpp"
+#include <linux/can.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+
+// Frame with its kernel receive timestamp (CLOCK_REALTIME, nanoseconds)
+struct TimedFrame {
+    struct can_frame frame;
+    uint64_t timestampNs;
+};
+
+// Frames for one consumer thread. The demux RX thread is the only producer.
+class FrameQueue {
+public:
+    FrameQueue();
+
+    bool pop(struct can_frame& frame, int timeoutMs, uint64_t* timestampNs = NULL);
+    bool tryPop(struct can_frame& frame, uint64_t* timestampNs = NULL);
+    void clear();
+    // Makes a pop in progress, or the next one, return false early; safe from any thread
+    void wake();
+
+private:
+    friend class FrameDemux;
+
+    SpscRing<TimedFrame, 512> ring_;
+    std::atomic<bool> sleeping_;
+    std::atomic<bool> woken_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+
+    bool push(const TimedFrame& item);
+    bool take(struct can_frame& frame, uint64_t* timestampNs);
+};
+
+// Single reader of a CAN socket. Every frame is classified by COB-ID and
+// handed to the queue routed for it; SDO responses are also checked against
+// the multiplexer the waiter expects, so a stale or foreign answer is never
+// taken for the reply. Frames nobody routed are dropped.
+class FrameDemux {
+public:
+    struct Stats {
+        uint64_t received;
+        uint64_t delivered;
+        uint64_t unrouted;     // No queue for this COB-ID
+        uint64_t mismatched;   // SDO response for another index/subindex
+        uint64_t overflows;    // Queue full
+    };
+
+    FrameDemux();
+    ~FrameDemux();
+
+    bool start(int socket);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    void route(canid_t cobId, FrameQueue* queue);
+    // While set, the node's SDO responses go to queue instead of their route and
+    // skip the multiplexer check; the AsyncSdoClient of the bus claims the nodes it talks to
+    void claimSdoResponses(int nodeId, FrameQueue* queue);
+    // Unroutes every COB-ID and claim of the queue and returns once the RX thread no longer touches it
+    void detach(FrameQueue* queue);
+    // Records every received frame, NULL stops; returns once the RX thread no longer uses the old tap
+    void setTap(FrameRecorder::Tap* tap);
+    // Kernel TX timestamp of the last frame sent with this COB-ID, 0 if none was reported
+    uint64_t lastTxTimestamp(canid_t cobId) const;
+    void expectSdoResponse(int nodeId, uint16_t index, uint8_t subindex);
+    void expectAnySdoResponse(int nodeId);
+    // Boot-up messages and NMT resets seen for the node since the session opened
+    uint32_t bootCount(int nodeId) const;
+    // Counts a reset we sent ourselves, node 0 for all nodes
+    void noteReset(int nodeId);
+    Stats getStats() const;
+
+private:
+    static const size_t COB_ID_COUNT = CAN_SFF_MASK + 1;
+    static const uint32_t MUX_VALID = 0x80000000;
+
+    int socket_;
+    int wakeup_;
+    std::thread thread_;
+    std::mutex dispatchMutex_;  // Held by the RX thread while it hands out a batch
+    std::atomic<FrameQueue*> routes_[COB_ID_COUNT];
+    std::atomic<FrameQueue*> sdoClaims_[128];
+    std::atomic<FrameRecorder::Tap*> tap_;
+    std::atomic<uint32_t> expectedMux_[128];  // Per node, 0 means any response
+    std::atomic<uint64_t> txTimestamps_[COB_ID_COUNT];
+    std::atomic<uint32_t> boots_[128];
+
+    std::atomic<uint64_t> received_;
+    std::atomic<uint64_t> delivered_;
+    std::atomic<uint64_t> unrouted_;
+    std::atomic<uint64_t> mismatched_;
+    std::atomic<uint64_t> overflows_;
+
+    void run();
+    size_t drainErrorQueue();
+    void dispatch(const TimedFrame& item);
+    void deliver(FrameQueue* queue, const TimedFrame& item);
+};
@@ -0,0 +1,243 @@
+#include "frame_recorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+
+static const char LOG_MAGIC[8] = {'C', 'A', 'N', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t LOG_VERSION = 1;
+static const size_t RECORD_HEADER_SIZE = 16;     // TraceRecord up to the data bytes
+static const size_t FLUSH_BUFFER_SIZE = 1 << 20;
+static const int FLUSH_INTERVAL_MS = 20;
+
+void FrameRecorder::Tap::record(bool tx, const struct can_frame& frame, uint64_t timestampNs) {
+    // struct can_frame is the layout prefix of struct canfd_frame
+    struct canfd_frame fdFrame;
+    std::memcpy(&fdFrame, &frame, sizeof(frame));
+    record(tx, fdFrame, false, timestampNs);
+}
+
+void FrameRecorder::Tap::record(bool tx, const struct canfd_frame& frame, bool fd, uint64_t timestampNs) {
+    TraceRecord item;
+    item.timestampNs = timestampNs;
+    item.canId = frame.can_id;
+    item.channel = channel_;
+    item.flags = (tx ? TraceRecord::TX : 0) | (fd ? TraceRecord::FD : 0);
+    item.len = std::min<uint8_t>(frame.len, fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN);
+    item.reserved = 0;
+    std::memcpy(item.data, frame.data, item.len);
+    if (ring_.push(item)) {
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void* FrameRecorder::Tap::operator new(size_t size) {
+    void* pointer = NULL;
+    if (posix_memalign(&pointer, 64, size) != 0) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void FrameRecorder::Tap::operator delete(void* pointer) {
+    free(pointer);
+}
+
+FrameRecorder::FrameRecorder() : stopping_(false), channelsWritten_(0) {}
+
+FrameRecorder::~FrameRecorder() {
+    close();
+}
+
+bool FrameRecorder::open(const std::string& path) {
+    close();
+    file_.open(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        std::cerr << "Cannot create trace log " << path << std::endl;
+        return false;
+    }
+    uint8_t header[16] = {0};
+    std::memcpy(header, LOG_MAGIC, sizeof(LOG_MAGIC));
+    std::memcpy(&header[8], &LOG_VERSION, sizeof(LOG_VERSION));
+    file_.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    buffer_.reserve(FLUSH_BUFFER_SIZE);
+    stopping_ = false;
+    thread_ = std::thread(&FrameRecorder::run, this);
+    return true;
+}
+
+void FrameRecorder::close() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+FrameRecorder::Tap* FrameRecorder::acquireTap(const std::string& canInterface) {
+    if (!isOpen()) {
+        return NULL;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string>::iterator it = std::find(channels_.begin(), channels_.end(), canInterface);
+    if (it == channels_.end()) {
+        if (channels_.size() > 0xFF) {
+            std::cerr << "Too many channels in trace log" << std::endl;
+            return NULL;
+        }
+        it = channels_.insert(channels_.end(), canInterface);
+    }
+    uint8_t channel = static_cast<uint8_t>(it - channels_.begin());
+
+    // A released tap is handed on once the flush thread has emptied it
+    Tap* tap = NULL;
+    for (size_t i = 0; i < taps_.size() && tap == NULL; i++) {
+        if (!taps_[i]->inUse_ && taps_[i]->ring_.empty()) {
+            tap = taps_[i].get();
+        }
+    }
+    if (tap == NULL) {
+        taps_.push_back(std::unique_ptr<Tap>(new Tap()));
+        tap = taps_.back().get();
+    }
+    tap->channel_ = channel;
+    tap->inUse_ = true;
+    return tap;
+}
+
+void FrameRecorder::releaseTap(Tap* tap) {
+    if (tap == NULL) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    tap->inUse_ = false;
+}
+
+uint64_t FrameRecorder::recorded() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t total = 0;
+    for (size_t i = 0; i < taps_.size(); i++) {
+        total += taps_[i]->recorded_.load();
+    }
+    return total;
+}
+
+uint64_t FrameRecorder::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t total = 0;
+    for (size_t i = 0; i < taps_.size(); i++) {
+        total += taps_[i]->dropped_.load();
+    }
+    return total;
+}
+
+void FrameRecorder::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        bool stopping = wake_.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this] { return stopping_; });
+        // Producers never take the lock, holding it only delays acquireTap
+        flush();
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void FrameRecorder::flush() {
+    // Name new channels before their first frame
+    for (; channelsWritten_ < channels_.size(); channelsWritten_++) {
+        TraceRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.channel = static_cast<uint8_t>(channelsWritten_);
+        record.flags = TraceRecord::CHANNEL;
+        record.len = static_cast<uint8_t>(std::min(channels_[channelsWritten_].size(), sizeof(record.data)));
+        std::memcpy(record.data, channels_[channelsWritten_].data(), record.len);
+        writeRecord(record);
+    }
+
+    TraceRecord record;
+    for (size_t i = 0; i < taps_.size(); i++) {
+        while (taps_[i]->ring_.pop(record)) {
+            writeRecord(record);
+        }
+    }
+    if (!buffer_.empty()) {
+        file_.write(buffer_.data(), buffer_.size());
+        file_.flush();
+        buffer_.clear();
+    }
+}
+
+void FrameRecorder::writeRecord(const TraceRecord& record) {
+    size_t size = RECORD_HEADER_SIZE + record.len;
+    if (buffer_.size() + size > buffer_.capacity()) {
+        file_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+    const char* bytes = reinterpret_cast<const char*>(&record);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+}
+
+bool FrameRecorder::readLog(const std::string& path, std::vector<TraceRecord>& records, std::vector<std::string>& channels) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open trace log " << path << std::endl;
+        return false;
+    }
+    std::vector<char> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    uint32_t version = 0;
+    if (content.size() < 16 || std::memcmp(content.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+        std::cerr << path << " is not a trace log" << std::endl;
+        return false;
+    }
+    std::memcpy(&version, &content[8], sizeof(version));
+    if (version != LOG_VERSION) {
+        std::cerr << "Unsupported trace log version " << version << " in " << path << std::endl;
+        return false;
+    }
+
+    records.clear();
+    channels.clear();
+    size_t offset = 16;
+    while (offset + RECORD_HEADER_SIZE <= content.size()) {
+        TraceRecord record;
+        std::memset(&record, 0, sizeof(record));
+        std::memcpy(&record, &content[offset], RECORD_HEADER_SIZE);
+        if (record.len > CANFD_MAX_DLEN || offset + RECORD_HEADER_SIZE + record.len > content.size()) {
+            break;
+        }
+        std::memcpy(record.data, &content[offset + RECORD_HEADER_SIZE], record.len);
+        offset += RECORD_HEADER_SIZE + record.len;
+
+        if (record.flags & TraceRecord::CHANNEL) {
+            if (channels.size() <= record.channel) {
+                channels.resize(record.channel + 1);
+            }
+            channels[record.channel].assign(reinterpret_cast<const char*>(record.data), record.len);
+        } else {
+            records.push_back(record);
+        }
+    }
+    if (offset != content.size()) {
+        // A log cut short by a crash is still useful up to the damaged record
+        std::cerr << "Trace log " << path << " truncated after " << records.size() << " frames" << std::endl;
+    }
+
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord& a, const TraceRecord& b) {
+        return a.timestampNs < b.timestampNs;
+    });
+    return true;
+}
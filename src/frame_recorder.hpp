@@ -0,0 +1,93 @@
+#pragma once
+
+#include "spsc_ring.hpp"
+#include <linux/can.h>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+// One frame in a trace log. On disk only the first len data bytes follow the
+// 16 byte header; CHANNEL records carry the interface name of a channel.
+struct TraceRecord {
+    uint64_t timestampNs;  // CLOCK_REALTIME
+    uint32_t canId;
+    uint8_t channel;
+    uint8_t flags;
+    uint8_t len;
+    uint8_t reserved;
+    uint8_t data[CANFD_MAX_DLEN];
+
+    enum Flags {
+        TX = 0x01,       // Sent by this tool, otherwise received
+        FD = 0x02,       // CAN FD frame
+        CHANNEL = 0x80   // Names channel, data holds the interface name
+    };
+};
+
+// Records every frame a CanInterface sends and receives into a binary log.
+// Each producer thread writes to its own preallocated SPSC tap, a background
+// thread drains all taps into the file every few milliseconds. Nothing is
+// allocated per frame; a full tap counts the frame as dropped. Records are
+// in order per tap, readers sort by timestamp.
+class FrameRecorder {
+public:
+    static const size_t TAP_CAPACITY = 8192;  // About a second of a fully loaded 1 Mbit/s bus
+
+    class Tap {
+    public:
+        void record(bool tx, const struct can_frame& frame, uint64_t timestampNs);
+        void record(bool tx, const struct canfd_frame& frame, bool fd, uint64_t timestampNs);
+
+        // The ring indices are cache line aligned, which plain new does not honour before C++17
+        static void* operator new(size_t size);
+        static void operator delete(void* pointer);
+
+    private:
+        friend class FrameRecorder;
+
+        SpscRing<TraceRecord, TAP_CAPACITY> ring_;
+        uint8_t channel_;
+        bool inUse_;
+        std::atomic<uint64_t> recorded_;
+        std::atomic<uint64_t> dropped_;
+
+        Tap() : channel_(0), inUse_(false), recorded_(0), dropped_(0) {}
+    };
+
+    FrameRecorder();
+    ~FrameRecorder();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return thread_.joinable(); }
+
+    // Tap for one producer thread on this interface, held until released
+    Tap* acquireTap(const std::string& canInterface);
+    void releaseTap(Tap* tap);
+
+    uint64_t recorded() const;
+    uint64_t dropped() const;
+
+    static bool readLog(const std::string& path, std::vector<TraceRecord>& records, std::vector<std::string>& channels);
+
+private:
+    std::ofstream file_;
+    std::thread thread_;
+    mutable std::mutex mutex_;  // Taps, channels and stop flag, never taken per frame
+    std::condition_variable wake_;
+    bool stopping_;
+    std::vector<std::unique_ptr<Tap> > taps_;
+    std::vector<std::string> channels_;
+    size_t channelsWritten_;
+    std::vector<char> buffer_;
+
+    void run();
+    void flush();
+    void writeRecord(const TraceRecord& record);
+};
@@ -0,0 +1,131 @@
+#include "image_store.hpp"
+#include "crc16.hpp"
+#include "firmware_image.hpp"
+#include "firmware_upgrade.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+ImageStore::ImageStore(const std::string& directory) : directory_(directory) {}
+
+std::string ImageStore::imagePath(const std::string& hardwareVersion) const {
+    return directory_ + "/" + hardwareVersion + ".bin";
+}
+
+std::string ImageStore::indexPath(const std::string& hardwareVersion) const {
+    return directory_ + "/" + hardwareVersion + ".idx";
+}
+
+uint64_t ImageStore::contentHash(const uint8_t* data, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool ImageStore::importImage(const std::string& imagePath, StoredImage& image) {
+    FirmwareImage source;
+    if (!source.open(imagePath)) {
+        return false;
+    }
+    if (source.size() < 4) {
+        std::cerr << "Firmware image too small: " << imagePath << std::endl;
+        return false;
+    }
+
+    image.size = source.size();
+    image.crc16 = Crc16::compute(source.data(), source.size());
+    image.contentHash = contentHash(source.data(), source.size());
+    try {
+        image.hardwareVersion = FirmwareUpgrader::getHardwareVersion(source.data(), source.size());
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid hardware version footer in " << imagePath << ": " << e.what() << std::endl;
+        return false;
+    }
+    image.path = this->imagePath(image.hardwareVersion);
+
+    if (mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Error creating image store: " << directory_ << std::endl;
+        return false;
+    }
+
+    // Copy the image first, the index is what makes it visible to lookups
+    std::string tmpPath = image.path + ".tmp";
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(source.data()), source.size());
+        if (!out) {
+            std::cerr << "Error writing image: " << tmpPath << std::endl;
+            return false;
+        }
+    }
+    if (rename(tmpPath.c_str(), image.path.c_str()) != 0) {
+        std::cerr << "Error storing image: " << image.path << std::endl;
+        return false;
+    }
+
+    std::string idxPath = indexPath(image.hardwareVersion);
+    tmpPath = idxPath + ".tmp";
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::trunc);
+        out << "hardware_version=" << image.hardwareVersion << "\n"
+            << "size=" << std::dec << image.size << "\n"
+            << "crc16=0x" << std::hex << image.crc16 << "\n"
+            << "hash=0x" << std::hex << image.contentHash << "\n"
+            << "source=" << imagePath << "\n";
+        if (!out) {
+            std::cerr << "Error writing index: " << tmpPath << std::endl;
+            return false;
+        }
+    }
+    if (rename(tmpPath.c_str(), idxPath.c_str()) != 0) {
+        std::cerr << "Error storing index: " << idxPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ImageStore::lookup(const std::string& hardwareVersion, StoredImage& image) const {
+    std::ifstream file(indexPath(hardwareVersion).c_str());
+    if (!file) {
+        std::cerr << "No image for hardware version " << hardwareVersion << " in " << directory_ << std::endl;
+        return false;
+    }
+
+    image = StoredImage();
+    std::string line;
+    try {
+        while (std::getline(file, line)) {
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                continue;
+            }
+            std::string key = line.substr(0, eq);
+            std::string value = line.substr(eq + 1);
+            if (key == "hardware_version") {
+                image.hardwareVersion = value;
+            } else if (key == "size") {
+                image.size = std::stoull(value);
+            } else if (key == "crc16") {
+                image.crc16 = static_cast<uint16_t>(std::stoul(value, NULL, 16));
+            } else if (key == "hash") {
+                image.contentHash = std::stoull(value, NULL, 16);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error parsing index line '" << line << "': " << e.what() << std::endl;
+        return false;
+    }
+    image.path = imagePath(hardwareVersion);
+
+    if (image.hardwareVersion != hardwareVersion || image.size == 0) {
+        std::cerr << "Corrupt index for hardware version " << hardwareVersion << std::endl;
+        return false;
+    }
+    return true;
+}
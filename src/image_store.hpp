@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Metadata of an image in the store, validated once at import
+struct StoredImage {
+    std::string path;             // Image file inside the store
+    size_t size;
+    uint16_t crc16;
+    std::string hardwareVersion;  // From the image footer, e.g. "00.98.a5.c9"
+    uint64_t contentHash;         // FNV-1a 64 over the whole image, checked again before each upgrade
+
+    StoredImage() : size(0), crc16(0), contentHash(0) {}
+};
+
+// Directory of firmware images named after their hardware version:
+//   <dir>/<hardware version>.bin  image
+//   <dir>/<hardware version>.idx  sidecar index with the metadata above
+// A lookup by hardware version is a single file open, no scanning.
+class ImageStore {
+public:
+    ImageStore(const std::string& directory);
+
+    bool importImage(const std::string& imagePath, StoredImage& image);
+    bool lookup(const std::string& hardwareVersion, StoredImage& image) const;
+
+    static uint64_t contentHash(const uint8_t* data, size_t length);
+
+private:
+    std::string directory_;
+
+    std::string imagePath(const std::string& hardwareVersion) const;
+    std::string indexPath(const std::string& hardwareVersion) const;
+};
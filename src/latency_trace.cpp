@@ -0,0 +1,121 @@
+#include "latency_trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+void LatencyTracer::record(const char* kind, int nodeId, uint16_t index, uint8_t subindex, uint64_t txNs, uint64_t rxNs) {
+    LatencySample sample;
+    sample.kind = kind;
+    sample.nodeId = nodeId;
+    sample.index = index;
+    sample.subindex = subindex;
+    sample.txNs = txNs;
+    sample.rxNs = std::max(rxNs, txNs);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    samples_.push_back(sample);
+}
+
+// Nearest-rank percentile of sorted latencies
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void printGroups(std::ostream& out, const char* title, std::map<std::string, std::vector<uint64_t> >& groups) {
+    out << title << std::endl;
+    out << "  " << std::left << std::setw(24) << "" << std::right
+        << std::setw(8) << "count" << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms"
+        << std::setw(10) << "max ms" << std::endl;
+    for (std::map<std::string, std::vector<uint64_t> >::iterator it = groups.begin(); it != groups.end(); ++it) {
+        std::vector<uint64_t>& latencies = it->second;
+        std::sort(latencies.begin(), latencies.end());
+        out << "  " << std::left << std::setw(24) << it->first << std::right << std::dec
+            << std::setw(8) << latencies.size() << std::fixed << std::setprecision(3)
+            << std::setw(10) << percentile(latencies, 0.50) / 1e6
+            << std::setw(10) << percentile(latencies, 0.99) / 1e6
+            << std::setw(10) << latencies.back() / 1e6 << std::endl;
+    }
+}
+
+void LatencyTracer::printSummary(std::ostream& out) {
+    std::map<std::string, std::vector<uint64_t> > byNode;
+    std::map<std::string, std::vector<uint64_t> > byIndex;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < samples_.size(); i++) {
+            const LatencySample& sample = samples_[i];
+            uint64_t latency = sample.rxNs - sample.txNs;
+
+            std::ostringstream node;
+            node << "node " << std::setw(3) << sample.nodeId << " " << sample.kind;
+            byNode[node.str()].push_back(latency);
+
+            std::ostringstream index;
+            index << "0x" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << sample.index
+                  << " " << sample.kind;
+            byIndex[index.str()].push_back(latency);
+        }
+    }
+    if (byNode.empty()) {
+        out << "No SDO transactions traced" << std::endl;
+        return;
+    }
+
+    std::ios::fmtflags flags = out.flags();
+    printGroups(out, "Latency per node:", byNode);
+    printGroups(out, "Latency per object index:", byIndex);
+    out.flags(flags);
+}
+
+bool LatencyTracer::writeChromeTrace(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::ofstream file(path.c_str());
+    if (!file) {
+        std::cerr << "Error creating trace file: " << path << std::endl;
+        return false;
+    }
+
+    uint64_t origin = 0;
+    std::set<int> nodes;
+    for (size_t i = 0; i < samples_.size(); i++) {
+        if (origin == 0 || samples_[i].txNs < origin) {
+            origin = samples_[i].txNs;
+        }
+        nodes.insert(samples_[i].nodeId);
+    }
+
+    // Complete ("X") events in microseconds since the first request, one process per node
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    bool first = true;
+    for (std::set<int>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        file << (first ? "" : ",\n") << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << *it
+             << ",\"args\":{\"name\":\"node " << *it << "\"}}";
+        first = false;
+    }
+    file << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < samples_.size(); i++) {
+        const LatencySample& sample = samples_[i];
+        std::ostringstream name;
+        name << "0x" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << sample.index
+             << "/" << std::setw(2) << static_cast<int>(sample.subindex);
+        file << (first ? "" : ",\n") << "{\"name\":\"" << name.str() << "\",\"cat\":\"" << sample.kind
+             << "\",\"ph\":\"X\",\"pid\":" << sample.nodeId << ",\"tid\":\"" << sample.kind
+             << "\",\"ts\":" << (sample.txNs - origin) / 1e3 << ",\"dur\":" << (sample.rxNs - sample.txNs) / 1e3 << "}";
+        first = false;
+    }
+    file << "\n]}" << std::endl;
+
+    if (!file) {
+        std::cerr << "Error writing trace file: " << path << std::endl;
+        return false;
+    }
+    std::cout << "Wrote " << samples_.size() << " traced transactions to " << path << std::endl;
+    return true;
+}
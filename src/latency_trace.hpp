@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One request/response pair, timestamps are CLOCK_REALTIME nanoseconds
+struct LatencySample {
+    const char* kind;   // "sdo" or "block-ack"
+    int nodeId;
+    uint16_t index;
+    uint8_t subindex;
+    uint64_t txNs;      // Request left the host (kernel TX timestamp when available)
+    uint64_t rxNs;      // Response reached the host (kernel RX timestamp)
+};
+
+// Collects SDO and block ack round trips of a whole run, safe to share
+// between fleet workers. Reports p50/p99/max per node and per object index
+// and writes a Chrome trace (chrome://tracing, Perfetto) with one process per node.
+class LatencyTracer {
+public:
+    void record(const char* kind, int nodeId, uint16_t index, uint8_t subindex, uint64_t txNs, uint64_t rxNs);
+
+    void printSummary(std::ostream& out);
+    bool writeChromeTrace(const std::string& path);
+
+private:
+    std::vector<LatencySample> samples_;
+    std::mutex mutex_;
+};
@@ -1,25 +1,257 @@
 #include "can_interface.hpp"
+#include "bus_scan.hpp"
 #include "firmware_upgrade.hpp"
 #include "config_manager.hpp"
+#include "config_cache.hpp"
+#include "cfg_file.hpp"
+#include "eds_dictionary.hpp"
+#include "fleet.hpp"
+#include "latency_trace.hpp"
+#include "frame_recorder.hpp"
+#include "sdo_client.hpp"
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <cstring>
+#include <vector>
+#include <sys/stat.h>
+
+static bool isDirectory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+typedef std::map<std::string, std::shared_ptr<AsyncSdoClient> > SdoClientMap;
+
+// One SDO client per bus, shared by all its fleet workers. Opened up front so
+// the jobs only read the map; a bus without one uses plain SDO requests.
+static void openSdoClients(const std::vector<FleetTarget>& targets, LatencyTracer* tracer, FrameRecorder* recorder,
+                           const SdoTimeoutPolicy& sdoTimeoutPolicy, SdoClientMap& clients) {
+    for (size_t i = 0; i < targets.size(); i++) {
+        const std::string& canInterface = targets[i].canInterface;
+        if (clients.count(canInterface) != 0) {
+            continue;
+        }
+        std::shared_ptr<AsyncSdoClient> client(new AsyncSdoClient());
+        client->setTracer(tracer);
+        client->setRecorder(recorder);
+        client->setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        if (!client->open(canInterface)) {
+            std::cerr << "Not pipelining SDO requests on " << canInterface << std::endl;
+            client.reset();
+        }
+        clients[canInterface] = client;
+    }
+}
+
+// Prints the latency histograms and writes the trace file on every exit path
+struct TraceReport {
+    LatencyTracer* tracer;
+    std::string path;
+
+    ~TraceReport() {
+        if (tracer != NULL) {
+            tracer->printSummary(std::cout);
+            tracer->writeChromeTrace(path);
+        }
+    }
+};
+
+// Flushes the frame log and reports how complete it is on every exit path
+struct RecordReport {
+    FrameRecorder* recorder;
+
+    ~RecordReport() {
+        if (recorder != NULL) {
+            recorder->close();
+            std::cout << "Recorded " << recorder->recorded() << " frames (" << recorder->dropped()
+                      << " dropped)" << std::endl;
+        }
+    }
+};
 
 void printHelp(const char* programName) {
     std::cout << "Usage: " << programName << " <can_interface> <id> <data_file>" << std::endl;
     std::cout << "   or: " << programName << " --change-node-id <can_interface> <old_id> <new_id>" << std::endl;
     std::cout << "   or: " << programName << " --apply-cfg <can_interface> <id> <cfg_file>" << std::endl;
+    std::cout << "   or: " << programName << " --fleet-upgrade <targets_file>" << std::endl;
+    std::cout << "   or: " << programName << " --fleet-apply-cfg <targets_file>" << std::endl;
+    std::cout << "   or: " << programName << " --compile-cfg <cfg_file> <output_file>" << std::endl;
+    std::cout << "   or: " << programName << " --check-cfg <cfg_file> --eds <eds_file>" << std::endl;
+    std::cout << "   or: " << programName << " --restore-snapshot <can_interface> <id> <snapshot_file>" << std::endl;
+    std::cout << "   or: " << programName << " --scan <can_interface>..." << std::endl;
+    std::cout << "   or: " << programName << " --import-image <store_dir> <data_file>" << std::endl;
+    std::cout << "   or: " << programName << " --upgrade-from-store <can_interface> <id> <store_dir>" << std::endl;
+    std::cout << "   or: " << programName << " --dump-image <can_interface> <id> <output_file>" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  --help, -h           Show this help message" << std::endl;
     std::cout << "  --change-node-id     Command to only change the node ID" << std::endl;
     std::cout << "  --apply-cfg          Apply configuration from cfg file" << std::endl;
+    std::cout << "  --fleet-upgrade      Upgrade many nodes, buses in parallel (lines of: <can_interface> <id> <data_file>)" << std::endl;
+    std::cout << "                       <data_file> may also be an image store directory" << std::endl;
+    std::cout << "  --fleet-apply-cfg    Configure many nodes at once (lines of: <can_interface> <id> <cfg_file>)" << std::endl;
+    std::cout << "  --compile-cfg        Turn a cfg file into a checksummed binary table, accepted wherever" << std::endl;
+    std::cout << "                       a cfg file is" << std::endl;
+    std::cout << "  --check-cfg          Validate a cfg file against the EDS without touching the bus" << std::endl;
+    std::cout << "  --eds <file>         Check cfg parameters against this EDS before applying them and" << std::endl;
+    std::cout << "                       write them with the EDS data sizes" << std::endl;
+    std::cout << "  --restore-snapshot   Write a snapshot taken by --snapshot-dir back to its node, save and restart" << std::endl;
+    std::cout << "  --scan               List the nodes on the given buses with identity, hardware and software" << std::endl;
+    std::cout << "                       version; all node IDs are probed at once, buses in parallel" << std::endl;
+    std::cout << "  --scan-window <ms>   How long a scan collects replies (default 200)" << std::endl;
+    std::cout << "  --nodes-per-bus <n>  --fleet-apply-cfg targets worked on at the same time on one bus" << std::endl;
+    std::cout << "                       (default all); --fleet-upgrade always does one node at a time" << std::endl;
+    std::cout << "  --import-image       Validate an image and add it to the image store" << std::endl;
+    std::cout << "  --upgrade-from-store Upgrade with the stored image matching the node's hardware version" << std::endl;
+    std::cout << "  --dump-image         Read the image (0x1F50) back by SDO block upload into a file" << std::endl;
+    std::cout << "  --verify             Read the image back after flashing and compare it" << std::endl;
+    std::cout << "  --fd                 Block download in CAN FD frames of up to 64 bytes when the" << std::endl;
+    std::cout << "                       interface (MTU 72) and the bootloader support it" << std::endl;
+    std::cout << "  --boot-timeout <ms>  Upper bound for waiting on a node to boot (default 5000)" << std::endl;
+    std::cout << "  --skip-if-identical  Do not reflash nodes that already run the image" << std::endl;
+    std::cout << "  --cache <file>       Upgrade cache file (default ~/.canopenCommand_upgrade.cache)" << std::endl;
+    std::cout << "  --only-changed       Apply only cfg values the node does not hold, save and restart only" << std::endl;
+    std::cout << "                       if any; values applied by earlier runs are taken from the config cache" << std::endl;
+    std::cout << "  --config-cache <file> Config cache file (default ~/.canopenCommand_config.cache)" << std::endl;
+    std::cout << "  --snapshot-dir <dir> Apply cfg files transactionally: save the values about to change" << std::endl;
+    std::cout << "                       to a snapshot in <dir> first and write them back if the apply fails" << std::endl;
+    std::cout << "  --sdo-min-timeout <ms> Floor of the RTT based SDO timeout (default 50)" << std::endl;
+    std::cout << "  --sdo-max-timeout <ms> Ceiling of one SDO attempt (default 2000)" << std::endl;
+    std::cout << "  --sdo-retries <n>    Extra attempts for SDO reads and parameter writes (default 2)" << std::endl;
+    std::cout << "  --trace <file>       Time every SDO transaction and block ack with kernel timestamps," << std::endl;
+    std::cout << "                       print p50/p99/max per node and object, write a Chrome trace JSON" << std::endl;
+    std::cout << "  --record <file>      Log every frame sent and received to a binary trace for canopenReplay" << std::endl;
     std::cout << "Examples:" << std::endl;
     std::cout << "  " << programName << " can0 1 firmware.bin              # Upgrade firmware for node ID 1" << std::endl;
     std::cout << "  " << programName << " --change-node-id can0 1 2        # Change node ID from 1 to 2" << std::endl;
     std::cout << "  " << programName << " --apply-cfg can0 1 config.cfg    # Apply configuration from cfg file" << std::endl;
+    std::cout << "  " << programName << " --fleet-upgrade targets.txt      # Upgrade all nodes listed in targets.txt" << std::endl;
+    std::cout << "  " << programName << " --fleet-apply-cfg machine.txt    # Configure all nodes listed in machine.txt" << std::endl;
+    std::cout << "  " << programName << " --compile-cfg config.cfg config.bcfg  # Precompile a cfg template" << std::endl;
+    std::cout << "  " << programName << " --scan can0 can1               # Inventory of two buses" << std::endl;
+    std::cout << "  " << programName << " --restore-snapshot can0 1 snaps/node1-0000002a-20250101T120000Z.snap" << std::endl;
+    std::cout << "  " << programName << " --import-image images fw.bin     # Add fw.bin to the store in ./images" << std::endl;
+    std::cout << "  " << programName << " --upgrade-from-store can0 1 images  # Upgrade node 1 from the store" << std::endl;
+    std::cout << "  " << programName << " --dump-image can0 1 backup.bin   # Save the image of node 1" << std::endl;
 }
 
 int main(int argc, char **argv) {
+    // Strip global options so the positional checks below stay unchanged
+    BootWaitConfig bootWait;
+    bool skipIfIdentical = false;
+    bool verify = false;
+    bool fd = false;
+    bool onlyChanged = false;
+    std::string cachePath = UpgradeCache::defaultPath();
+    std::string configCachePath = ConfigCache::defaultPath();
+    std::string edsPath;
+    std::string snapshotDir;
+    std::string tracePath;
+    std::string recordPath;
+    int nodesPerBus = 0;
+    int scanWindowMs = 200;
+    SdoTimeoutPolicy sdoTimeoutPolicy;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--boot-timeout") == 0 && i + 1 < argc) {
+            bootWait.timeoutMs = std::stoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--fd") == 0) {
+            fd = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--skip-if-identical") == 0) {
+            skipIfIdentical = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--only-changed") == 0) {
+            onlyChanged = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--eds") == 0 && i + 1 < argc) {
+            edsPath = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--snapshot-dir") == 0 && i + 1 < argc) {
+            snapshotDir = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--config-cache") == 0 && i + 1 < argc) {
+            configCachePath = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cachePath = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--sdo-min-timeout") == 0 && i + 1 < argc) {
+            sdoTimeoutPolicy.minTimeoutMs = std::stoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--sdo-max-timeout") == 0 && i + 1 < argc) {
+            sdoTimeoutPolicy.maxTimeoutMs = std::stoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--sdo-retries") == 0 && i + 1 < argc) {
+            sdoTimeoutPolicy.maxRetries = std::stoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--scan-window") == 0 && i + 1 < argc) {
+            scanWindowMs = std::stoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--nodes-per-bus") == 0 && i + 1 < argc) {
+            nodesPerBus = std::stoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+            continue;
+        }
+        args.push_back(argv[i]);
+    }
+    argc = static_cast<int>(args.size());
+    argv = args.data();
+
+    UpgradeCache upgradeCache(cachePath);
+    LatencyTracer latencyTracer;
+    LatencyTracer* tracer = tracePath.empty() ? NULL : &latencyTracer;
+    TraceReport traceReport = { tracer, tracePath };
+    FrameRecorder frameRecorder;
+    FrameRecorder* recorder = NULL;
+    if (!recordPath.empty()) {
+        if (!frameRecorder.open(recordPath)) {
+            return -1;
+        }
+        recorder = &frameRecorder;
+    }
+    RecordReport recordReport = { recorder };
+    if (skipIfIdentical && !upgradeCache.load()) {
+        return -1;
+    }
+    EdsDictionary dictionary;
+    const EdsDictionary* eds = NULL;
+    if (!edsPath.empty()) {
+        if (!dictionary.load(edsPath)) {
+            return -1;
+        }
+        eds = &dictionary;
+    }
+    ConfigCache configCache(configCachePath);
+    if (onlyChanged && !configCache.load()) {
+        return -1;
+    }
+
     // Check for help option
     if (argc > 1 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0)) {
         printHelp(argv[0]);
@@ -39,6 +271,11 @@ int main(int argc, char **argv) {
         int newId = std::stoi(argv[4]);
         
         CanInterface can;
+        can.setBootWait(bootWait);
+        can.setTracer(tracer);
+        can.setRecorder(recorder);
+        can.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        can.setFdMode(fd);
         if (!can.initialize(canInterface, oldId)) {
             std::cerr << "Failed to initialize CAN interface" << std::endl;
             return -1;
@@ -67,12 +304,36 @@ int main(int argc, char **argv) {
         const char* cfgPath = argv[4];
         
         CanInterface can;
+        can.setBootWait(bootWait);
+        can.setTracer(tracer);
+        can.setRecorder(recorder);
+        can.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        can.setFdMode(fd);
         if (!can.initialize(canInterface, id)) {
             std::cerr << "Failed to initialize CAN interface" << std::endl;
             return -1;
         }
         
+        // Readbacks and snapshot reads are queued back to back through the SDO client
+        AsyncSdoClient sdoClient;
+        sdoClient.setTracer(tracer);
+        sdoClient.setRecorder(recorder);
+        sdoClient.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        bool pipelined = sdoClient.open(canInterface);
+        if (!pipelined) {
+            std::cerr << "Not pipelining SDO requests on " << canInterface << std::endl;
+        }
+
         ConfigManager configManager(can);
+        configManager.setDictionary(eds);
+        configManager.setSnapshotDir(snapshotDir);
+        if (pipelined) {
+            configManager.setSdoClient(&sdoClient);
+        }
+        if (onlyChanged) {
+            configManager.setOnlyChanged(true);
+            configManager.setConfigCache(&configCache);
+        }
         if (!configManager.applyConfiguration(cfgPath, id)) {
             std::cerr << "Failed to apply configuration" << std::endl;
             return -1;
@@ -81,10 +342,289 @@ int main(int argc, char **argv) {
         return 0;
     }
 
+    // Check if we're using the scan command
+    if (argc > 1 && strcmp(argv[1], "--scan") == 0) {
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " --scan <can_interface>..." << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        std::vector<std::string> canInterfaces(argv + 2, argv + argc);
+        BusScanner scanner;
+        scanner.setWindow(scanWindowMs);
+        std::vector<ScanEntry> entries;
+        bool ok = scanner.scan(canInterfaces, entries);
+        BusScanner::printInventory(entries, std::cout);
+        return ok ? 0 : -1;
+    }
+
+    // Check if we're using the restore-snapshot command
+    if (argc > 1 && strcmp(argv[1], "--restore-snapshot") == 0) {
+        if (argc != 5) {
+            std::cerr << "Usage: " << argv[0] << " --restore-snapshot <can_interface> <id> <snapshot_file>" << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        const char* canInterface = argv[2];
+        int id = std::stoi(argv[3]);
+
+        CanInterface can;
+        can.setBootWait(bootWait);
+        can.setTracer(tracer);
+        can.setRecorder(recorder);
+        can.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        if (!can.initialize(canInterface, id)) {
+            std::cerr << "Failed to initialize CAN interface" << std::endl;
+            return -1;
+        }
+
+        // Values cached by earlier applies no longer hold after the restore
+        if (!onlyChanged && !configCache.load()) {
+            return -1;
+        }
+        ConfigManager configManager(can);
+        configManager.setConfigCache(&configCache);
+        if (!configManager.restoreSnapshot(argv[4], id)) {
+            std::cerr << "Failed to restore snapshot" << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    // Check if we're using the fleet-upgrade command
+    if (argc > 1 && strcmp(argv[1], "--fleet-upgrade") == 0) {
+        if (argc != 3) {
+            std::cerr << "Usage: " << argv[0] << " --fleet-upgrade <targets_file>" << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        // Nodes restarting into the bootloader come back on its node ID and would collide
+        if (nodesPerBus > 1) {
+            std::cerr << "--nodes-per-bus applies only to --fleet-apply-cfg, upgrades run one node per bus" << std::endl;
+            return -1;
+        }
+
+        std::vector<FleetTarget> targets;
+        if (!FleetRunner::parseTargets(argv[2], targets)) {
+            return -1;
+        }
+
+        FleetRunner runner(bootWait);
+        runner.setTracer(tracer);
+        runner.setRecorder(recorder);
+        runner.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        runner.setFdMode(fd);
+        runner.setNodesPerBus(1);
+        SdoClientMap sdoClients;
+        openSdoClients(targets, tracer, recorder, sdoTimeoutPolicy, sdoClients);
+        std::vector<FleetResult> results = runner.run(targets,
+            [&](CanInterface& can, const FleetTarget& target, const FleetRunner::ProgressFn& progress) {
+                FirmwareUpgrader upgrader(can);
+                upgrader.setProgressCallback(progress);
+                upgrader.setSdoClient(sdoClients.find(target.canInterface)->second.get());
+                upgrader.setVerify(verify);
+                upgrader.setFdMode(fd);
+                if (skipIfIdentical) {
+                    upgrader.setUpgradeCache(&upgradeCache);
+                }
+                if (isDirectory(target.path)) {
+                    return upgrader.upgradeFromStore(ImageStore(target.path), target.nodeId, target.canInterface);
+                }
+                return upgrader.upgrade(target.path, target.nodeId, target.canInterface);
+            });
+        runner.printSummary(results);
+
+        for (size_t i = 0; i < results.size(); i++) {
+            if (!results[i].success) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    // Check if we're using the fleet-apply-cfg command
+    if (argc > 1 && strcmp(argv[1], "--fleet-apply-cfg") == 0) {
+        if (argc != 3) {
+            std::cerr << "Usage: " << argv[0] << " --fleet-apply-cfg <targets_file>" << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        std::vector<FleetTarget> targets;
+        if (!FleetRunner::parseTargets(argv[2], targets)) {
+            return -1;
+        }
+
+        // Parameter writes are short expedited transfers, nodes on one bus overlap well
+        FleetRunner runner(bootWait);
+        runner.setTracer(tracer);
+        runner.setRecorder(recorder);
+        runner.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        runner.setNodesPerBus(nodesPerBus > 0 ? static_cast<size_t>(nodesPerBus) : targets.size());
+
+        SdoClientMap sdoClients;
+        openSdoClients(targets, tracer, recorder, sdoTimeoutPolicy, sdoClients);
+        std::vector<FleetResult> results = runner.run(targets,
+            [&](CanInterface& can, const FleetTarget& target, const FleetRunner::ProgressFn& progress) {
+                ConfigManager configManager(can);
+                configManager.setProgressCallback(progress);
+                configManager.setDictionary(eds);
+                configManager.setSnapshotDir(snapshotDir);
+                configManager.setSdoClient(sdoClients.find(target.canInterface)->second.get());
+                if (onlyChanged) {
+                    configManager.setOnlyChanged(true);
+                    configManager.setConfigCache(&configCache);
+                }
+                return configManager.applyConfiguration(target.path, target.nodeId);
+            });
+        runner.printSummary(results);
+
+        for (size_t i = 0; i < results.size(); i++) {
+            if (!results[i].success) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    // Check if we're using the compile-cfg command
+    if (argc > 1 && strcmp(argv[1], "--compile-cfg") == 0) {
+        if (argc != 4) {
+            std::cerr << "Usage: " << argv[0] << " --compile-cfg <cfg_file> <output_file>" << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        CfgFile cfg;
+        if (!cfg.load(argv[2]) || !cfg.compile(argv[3])) {
+            std::cerr << "Failed to compile cfg file" << std::endl;
+            return -1;
+        }
+        std::cout << "Compiled " << cfg.params().size() << " parameters for hardware version "
+                  << cfg.hardwareVersion() << " into " << argv[3] << std::endl;
+        return 0;
+    }
+
+    // Check if we're using the check-cfg command
+    if (argc > 1 && strcmp(argv[1], "--check-cfg") == 0) {
+        if (argc != 3 || eds == NULL) {
+            std::cerr << "Usage: " << argv[0] << " --check-cfg <cfg_file> --eds <eds_file>" << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        CfgFile cfg;
+        if (!cfg.load(argv[2])) {
+            return -1;
+        }
+        std::vector<ConfigParam> params = cfg.params();
+        size_t errors = eds->validate(params);
+        std::cout << params.size() - errors << " of " << params.size() << " parameters valid against "
+                  << edsPath << std::endl;
+        return errors == 0 ? 0 : -1;
+    }
+
+    // Check if we're using the import-image command
+    if (argc > 1 && strcmp(argv[1], "--import-image") == 0) {
+        if (argc != 4) {
+            std::cerr << "Usage: " << argv[0] << " --import-image <store_dir> <data_file>" << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        ImageStore store(argv[2]);
+        StoredImage image;
+        if (!store.importImage(argv[3], image)) {
+            std::cerr << "Failed to import image" << std::endl;
+            return -1;
+        }
+        std::cout << "Imported " << argv[3] << " as " << image.path << " (hardware version "
+                  << image.hardwareVersion << ", " << image.size << " bytes, CRC16 0x"
+                  << std::hex << image.crc16 << std::dec << ")" << std::endl;
+        return 0;
+    }
+
+    // Check if we're using the upgrade-from-store command
+    if (argc > 1 && strcmp(argv[1], "--upgrade-from-store") == 0) {
+        if (argc != 5) {
+            std::cerr << "Usage: " << argv[0] << " --upgrade-from-store <can_interface> <id> <store_dir>" << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        const char* canInterface = argv[2];
+        int id = std::stoi(argv[3]);
+
+        CanInterface can;
+        can.setBootWait(bootWait);
+        can.setTracer(tracer);
+        can.setRecorder(recorder);
+        can.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        can.setFdMode(fd);
+        if (!can.initialize(canInterface, id)) {
+            std::cerr << "Failed to initialize CAN interface" << std::endl;
+            return -1;
+        }
+
+        FirmwareUpgrader upgrader(can);
+        upgrader.setVerify(verify);
+        upgrader.setFdMode(fd);
+        if (skipIfIdentical) {
+            upgrader.setUpgradeCache(&upgradeCache);
+        }
+        if (!upgrader.upgradeFromStore(ImageStore(argv[4]), id, canInterface)) {
+            std::cerr << "Failed to upgrade firmware" << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    // Check if we're using the dump-image command
+    if (argc > 1 && strcmp(argv[1], "--dump-image") == 0) {
+        if (argc != 5) {
+            std::cerr << "Usage: " << argv[0] << " --dump-image <can_interface> <id> <output_file>" << std::endl;
+            std::cerr << "Use --help for more information" << std::endl;
+            return -1;
+        }
+
+        const char* canInterface = argv[2];
+        int id = std::stoi(argv[3]);
+
+        CanInterface can;
+        can.setBootWait(bootWait);
+        can.setTracer(tracer);
+        can.setRecorder(recorder);
+        can.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+        can.setFdMode(fd);
+        if (!can.initialize(canInterface, id)) {
+            std::cerr << "Failed to initialize CAN interface" << std::endl;
+            return -1;
+        }
+
+        FirmwareUpgrader upgrader(can);
+        if (!upgrader.dumpImage(id, argv[4])) {
+            std::cerr << "Failed to dump image" << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
     if (argc != 4) {
         std::cerr << "Usage: " << argv[0] << " <can_interface> <id> <data_file>" << std::endl;
         std::cerr << "   or: " << argv[0] << " --change-node-id <can_interface> <old_id> <new_id>" << std::endl;
         std::cerr << "   or: " << argv[0] << " --apply-cfg <can_interface> <id> <cfg_file>" << std::endl;
+        std::cerr << "   or: " << argv[0] << " --fleet-upgrade <targets_file>" << std::endl;
+        std::cerr << "   or: " << argv[0] << " --fleet-apply-cfg <targets_file>" << std::endl;
+        std::cerr << "   or: " << argv[0] << " --compile-cfg <cfg_file> <output_file>" << std::endl;
+        std::cerr << "   or: " << argv[0] << " --check-cfg <cfg_file> --eds <eds_file>" << std::endl;
+        std::cerr << "   or: " << argv[0] << " --restore-snapshot <can_interface> <id> <snapshot_file>" << std::endl;
+        std::cerr << "   or: " << argv[0] << " --scan <can_interface>..." << std::endl;
+        std::cerr << "   or: " << argv[0] << " --import-image <store_dir> <data_file>" << std::endl;
+        std::cerr << "   or: " << argv[0] << " --upgrade-from-store <can_interface> <id> <store_dir>" << std::endl;
+        std::cerr << "   or: " << argv[0] << " --dump-image <can_interface> <id> <output_file>" << std::endl;
         std::cerr << "Use --help for more information" << std::endl;
         return -1;
     }
@@ -94,12 +634,22 @@ int main(int argc, char **argv) {
     const char* firmwarePath = argv[3];
 
     CanInterface can;
+    can.setBootWait(bootWait);
+    can.setTracer(tracer);
+    can.setRecorder(recorder);
+    can.setSdoTimeoutPolicy(sdoTimeoutPolicy);
+    can.setFdMode(fd);
     if (!can.initialize(canInterface, id)) {
         std::cerr << "Failed to initialize CAN interface" << std::endl;
         return -1;
     }
 
     FirmwareUpgrader upgrader(can);
+    upgrader.setVerify(verify);
+    upgrader.setFdMode(fd);
+    if (skipIfIdentical) {
+        upgrader.setUpgradeCache(&upgradeCache);
+    }
     if (!upgrader.upgrade(firmwarePath, id, canInterface)) {
         std::cerr << "Failed to upgrade firmware" << std::endl;
         return -1;
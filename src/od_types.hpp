@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compile-time object descriptors and SDO request encoders. The descriptors
+// for the Flow drive are generated from its EDS into flow_od.hpp; an object
+// used with the wrong direction or value type fails to compile instead of
+// being aborted by the drive.
+namespace od {
+
+enum Access { CONST, RO, WO, RW };
+
+// Value type and size per CiA 301 data type, expedited transfers only know these
+template <uint16_t DataType> struct TypeTraits { static constexpr size_t size = 0; };
+template <> struct TypeTraits<0x0001> { typedef bool value_type;     static constexpr size_t size = 1; };  // BOOLEAN
+template <> struct TypeTraits<0x0002> { typedef int8_t value_type;   static constexpr size_t size = 1; };  // INTEGER8
+template <> struct TypeTraits<0x0003> { typedef int16_t value_type;  static constexpr size_t size = 2; };  // INTEGER16
+template <> struct TypeTraits<0x0004> { typedef int32_t value_type;  static constexpr size_t size = 4; };  // INTEGER32
+template <> struct TypeTraits<0x0005> { typedef uint8_t value_type;  static constexpr size_t size = 1; };  // UNSIGNED8
+template <> struct TypeTraits<0x0006> { typedef uint16_t value_type; static constexpr size_t size = 2; };  // UNSIGNED16
+template <> struct TypeTraits<0x0007> { typedef uint32_t value_type; static constexpr size_t size = 4; };  // UNSIGNED32
+
+template <uint16_t Index, uint8_t Subindex, uint16_t DataType, Access Mode>
+struct Object {
+    static constexpr uint16_t index = Index;
+    static constexpr uint8_t subindex = Subindex;
+    static constexpr uint16_t dataType = DataType;
+    static constexpr Access access = Mode;
+    static constexpr size_t size = TypeTraits<DataType>::size;  // 0 for strings and domains
+    static constexpr bool readable = Mode != WO;
+    static constexpr bool writable = Mode == RW || Mode == WO;
+};
+
+// Command specifier of an expedited download with the size indicated
+template <size_t Size> struct ExpeditedDownload;
+template <> struct ExpeditedDownload<1> { static constexpr uint8_t cs = 0x2F; };
+template <> struct ExpeditedDownload<2> { static constexpr uint8_t cs = 0x2B; };
+template <> struct ExpeditedDownload<4> { static constexpr uint8_t cs = 0x23; };
+
+// One 8 byte SDO request, ready to send
+struct SdoFrame {
+    uint8_t data[8];
+};
+
+template <class Obj>
+constexpr uint8_t valueByte(typename TypeTraits<Obj::dataType>::value_type value, size_t byte) {
+    return byte < Obj::size ? static_cast<uint8_t>(static_cast<uint32_t>(value) >> (byte * 8)) : 0;
+}
+
+// Initiate upload (read) of any readable object
+template <class Obj>
+constexpr SdoFrame sdoUpload(Obj) {
+    static_assert(Obj::readable, "object is write only");
+    return SdoFrame{{0x40, static_cast<uint8_t>(Obj::index & 0xFF), static_cast<uint8_t>(Obj::index >> 8),
+                     Obj::subindex, 0x00, 0x00, 0x00, 0x00}};
+}
+
+// Expedited download (write); the command specifier follows from the data type
+template <class Obj>
+constexpr SdoFrame sdoDownload(Obj, typename TypeTraits<Obj::dataType>::value_type value) {
+    static_assert(Obj::writable, "object is read only");
+    static_assert(Obj::size > 0 && Obj::size <= 4, "object needs a segmented or block transfer");
+    return SdoFrame{{ExpeditedDownload<Obj::size>::cs, static_cast<uint8_t>(Obj::index & 0xFF),
+                     static_cast<uint8_t>(Obj::index >> 8), Obj::subindex,
+                     valueByte<Obj>(value, 0), valueByte<Obj>(value, 1),
+                     valueByte<Obj>(value, 2), valueByte<Obj>(value, 3)}};
+}
+
+// Initiate block download with CRC and size indicated (ccs 6, cc, s)
+template <class Obj>
+constexpr SdoFrame sdoBlockDownload(Obj, uint32_t size) {
+    static_assert(Obj::writable, "object is read only");
+    return SdoFrame{{0xC6, static_cast<uint8_t>(Obj::index & 0xFF), static_cast<uint8_t>(Obj::index >> 8),
+                     Obj::subindex, static_cast<uint8_t>(size), static_cast<uint8_t>(size >> 8),
+                     static_cast<uint8_t>(size >> 16), static_cast<uint8_t>(size >> 24)}};
+}
+
+}  // namespace od
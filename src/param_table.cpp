@@ -0,0 +1,76 @@
+#include "param_table.hpp"
+#include "crc16.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+ParamTableHeader::ParamTableHeader(const char* fileMagic, uint16_t fileVersion)
+    : version(fileVersion), tag(0), extra(0) {
+    std::memcpy(magic, fileMagic, sizeof(magic));
+}
+
+bool readParamTable(const uint8_t* data, size_t size, ParamTableHeader& header, std::vector<ConfigParam>& params,
+                    const std::string& path, const char* kind) {
+    if (size < PARAM_TABLE_HEADER_SIZE || std::memcmp(data, header.magic, sizeof(header.magic)) != 0 ||
+        getLe(&data[8], 2) != header.version) {
+        std::cerr << "Unsupported " << kind << ": " << path << std::endl;
+        return false;
+    }
+    uint16_t crc = static_cast<uint16_t>(getLe(&data[10], 2));
+    uint32_t count = static_cast<uint32_t>(getLe(&data[16], 4));
+    if (size != PARAM_TABLE_HEADER_SIZE + static_cast<size_t>(count) * PARAM_TABLE_RECORD_SIZE) {
+        std::cerr << "Wrong size for the record count of " << kind << ": " << path << std::endl;
+        return false;
+    }
+    const uint8_t* records = data + PARAM_TABLE_HEADER_SIZE;
+    if (Crc16::compute(records, count * PARAM_TABLE_RECORD_SIZE) != crc) {
+        std::cerr << "CRC mismatch in " << kind << ": " << path << std::endl;
+        return false;
+    }
+
+    header.tag = static_cast<uint32_t>(getLe(&data[12], 4));
+    header.extra = static_cast<uint32_t>(getLe(&data[20], 4));
+    params.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* record = records + i * PARAM_TABLE_RECORD_SIZE;
+        params[i].index = static_cast<uint16_t>(getLe(record, 2));
+        params[i].subindex = record[2];
+        params[i].length = record[3];
+        params[i].value = static_cast<int64_t>(getLe(&record[4], 8));
+    }
+    return true;
+}
+
+bool writeParamTable(const std::string& path, const ParamTableHeader& header, const std::vector<ConfigParam>& params,
+                     const char* kind) {
+    std::vector<uint8_t> table(PARAM_TABLE_HEADER_SIZE + params.size() * PARAM_TABLE_RECORD_SIZE, 0);
+    for (size_t i = 0; i < params.size(); i++) {
+        uint8_t* record = &table[PARAM_TABLE_HEADER_SIZE + i * PARAM_TABLE_RECORD_SIZE];
+        putLe(record, params[i].index, 2);
+        record[2] = params[i].subindex;
+        record[3] = params[i].length;
+        putLe(&record[4], static_cast<uint64_t>(params[i].value), 8);
+    }
+    std::memcpy(&table[0], header.magic, sizeof(header.magic));
+    putLe(&table[8], header.version, 2);
+    putLe(&table[10], Crc16::compute(&table[PARAM_TABLE_HEADER_SIZE], params.size() * PARAM_TABLE_RECORD_SIZE), 2);
+    putLe(&table[12], header.tag, 4);
+    putLe(&table[16], params.size(), 4);
+    putLe(&table[20], header.extra, 4);
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(table.data()), table.size());
+        if (!file) {
+            std::cerr << "Error writing " << kind << ": " << tmpPath << std::endl;
+            return false;
+        }
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error replacing " << kind << ": " << path << std::endl;
+        return false;
+    }
+    return true;
+}
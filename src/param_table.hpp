@@ -0,0 +1,46 @@
+#pragma once
+
+#include "config_manager.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Little endian parameter table, the layout of compiled cfg files and config
+// snapshots. A 24 byte header (magic, u16 version, CRC16 of the records, two
+// words left to the file type, u32 record count) is followed by 12 bytes per
+// parameter: u16 index, u8 subindex, u8 length, i64 value.
+struct ParamTableHeader {
+    char magic[8];
+    uint16_t version;
+    uint32_t tag;    // Bytes 12-15, e.g. the hardware version or serial number
+    uint32_t extra;  // Bytes 20-23, e.g. the node ID
+
+    ParamTableHeader() : version(0), tag(0), extra(0) { magic[0] = '\0'; }
+    ParamTableHeader(const char* fileMagic, uint16_t fileVersion);
+};
+
+static const size_t PARAM_TABLE_HEADER_SIZE = 24;
+static const size_t PARAM_TABLE_RECORD_SIZE = 12;
+
+inline void putLe(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+inline uint64_t getLe(const uint8_t* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(in[i]) << (i * 8);
+    }
+    return value;
+}
+
+// Checks magic, version, size and CRC against header and fills in its tag,
+// extra and the records. kind names the file in messages ("snapshot file").
+bool readParamTable(const uint8_t* data, size_t size, ParamTableHeader& header, std::vector<ConfigParam>& params,
+                    const std::string& path, const char* kind);
+// Written to a temporary file and renamed, readers never see half a table
+bool writeParamTable(const std::string& path, const ParamTableHeader& header, const std::vector<ConfigParam>& params,
+                     const char* kind);
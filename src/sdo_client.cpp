@@ -0,0 +1,513 @@
+#include "sdo_client.hpp"
+#include "latency_trace.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <new>
+
+static const uint32_t ABORT_TIMEOUT = 0x05040000;      // SDO protocol timed out
+static const uint32_t ABORT_INVALID_CS = 0x05040001;   // Command specifier not valid
+static const uint32_t ABORT_TOGGLE = 0x05030000;       // Toggle bit not alternated
+static const int IDLE_WAIT_MS = 1000;                  // Loop wait with nothing in flight, submit() wakes it
+
+// Same clock the kernel uses for SO_TIMESTAMPING software timestamps
+static uint64_t realtimeNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+AsyncSdoClient::AsyncSdoClient()
+    : socket_(-1), tracer_(NULL), recorder_(NULL), txTap_(NULL), running_(false) {}
+
+AsyncSdoClient::~AsyncSdoClient() {
+    close();
+}
+
+void* AsyncSdoClient::operator new(size_t size) {
+    void* pointer = NULL;
+    if (posix_memalign(&pointer, 64, size) != 0) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void AsyncSdoClient::operator delete(void* pointer) {
+    free(pointer);
+}
+
+bool AsyncSdoClient::open(const std::string& canInterface) {
+    close();
+    session_ = BusSession::open(canInterface);
+    if (!session_) {
+        return false;
+    }
+    socket_ = session_->socket();
+
+    if (tracer_ != NULL && !session_->enableTimestamping()) {
+        std::cerr << "Kernel timestamps unavailable, tracing with host timestamps" << std::endl;
+    }
+    if (recorder_ != NULL) {
+        session_->setRecorder(recorder_);
+        txTap_ = recorder_->acquireTap(canInterface);
+    }
+
+    running_ = true;
+    thread_ = std::thread(&AsyncSdoClient::run, this);
+    return true;
+}
+
+void AsyncSdoClient::close() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        inbox_.wake();
+        thread_.join();
+    }
+    if (!session_) {
+        return;
+    }
+
+    // The session outlives us when others share it, make sure the demux lets go of the inbox
+    session_->demux().detach(&inbox_);
+    if (!subscribed_.empty()) {
+        session_->removeFilter(std::vector<int>(subscribed_.begin(), subscribed_.end()), COB_SDO_RESPONSE);
+        subscribed_.clear();
+    }
+    if (txTap_ != NULL) {
+        recorder_->releaseTap(txTap_);
+        txTap_ = NULL;
+    }
+    session_.reset();
+    socket_ = -1;
+}
+
+void AsyncSdoClient::submit(const SdoRequest& request, const Callback& callback) {
+    Transaction transaction;
+    transaction.request = request;
+    transaction.callback = callback;
+    transaction.state = INITIATE;
+    transaction.sentNs = 0;
+    transaction.attempt = 0;
+    transaction.attempts = 1;
+    transaction.slow = false;
+    transaction.toggle = 0;
+    transaction.offset = 0;
+    enqueue(transaction);
+}
+
+void AsyncSdoClient::enqueue(const Transaction& transaction) {
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            submitted_.push_back(transaction);
+            accepted = true;
+        }
+    }
+
+    if (!accepted) {
+        SdoResult result;
+        result.error = "SDO client is not running";
+        transaction.callback(result);
+        return;
+    }
+    inbox_.wake();
+}
+
+std::future<SdoResult> AsyncSdoClient::submit(const SdoRequest& request) {
+    std::shared_ptr<std::promise<SdoResult> > promise(new std::promise<SdoResult>());
+    std::future<SdoResult> future = promise->get_future();
+    submit(request, [promise](const SdoResult& result) { promise->set_value(result); });
+    return future;
+}
+
+std::future<SdoResult> AsyncSdoClient::read(int nodeId, uint16_t index, uint8_t subindex, int timeoutMs) {
+    SdoRequest request;
+    request.nodeId = nodeId;
+    request.upload = true;
+    request.index = index;
+    request.subindex = subindex;
+    request.timeoutMs = timeoutMs;
+    return submit(request);
+}
+
+std::future<SdoResult> AsyncSdoClient::write(int nodeId, uint16_t index, uint8_t subindex,
+                                             const uint8_t* data, size_t length, int timeoutMs) {
+    SdoRequest request;
+    request.nodeId = nodeId;
+    request.upload = false;
+    request.index = index;
+    request.subindex = subindex;
+    request.data.assign(data, data + length);
+    request.timeoutMs = timeoutMs;
+    return submit(request);
+}
+
+bool AsyncSdoClient::transact(int nodeId, const uint8_t* data, struct can_frame& response, int timeoutMs) {
+    // Raw requests carry the complete frame in data and return the complete response
+    SdoRequest request;
+    request.nodeId = nodeId;
+    request.index = data[1] | (data[2] << 8);
+    request.subindex = data[3];
+    request.data.assign(data, data + 8);
+    request.timeoutMs = timeoutMs;
+
+    std::shared_ptr<std::promise<SdoResult> > promise(new std::promise<SdoResult>());
+    std::future<SdoResult> future = promise->get_future();
+
+    Transaction transaction;
+    transaction.request = request;
+    transaction.callback = [promise](const SdoResult& result) { promise->set_value(result); };
+    transaction.state = RAW;
+    transaction.sentNs = 0;
+    transaction.attempt = 0;
+    transaction.attempts = 1;
+    transaction.slow = false;
+    transaction.toggle = 0;
+    transaction.offset = 0;
+    enqueue(transaction);
+
+    SdoResult result = future.get();
+    if (!result.success) {
+        std::cerr << "SDO request to node " << nodeId << " failed: " << result.error << std::endl;
+        return false;
+    }
+    response.can_id = 0x580 + nodeId;
+    response.can_dlc = 8;
+    std::memcpy(response.data, result.data.data(), 8);
+    return true;
+}
+
+void AsyncSdoClient::run() {
+    for (;;) {
+        takeSubmitted();
+
+        // Drain everything that arrived, one wakeup may cover many responses
+        struct can_frame frame;
+        uint64_t rxNs;
+        if (inbox_.pop(frame, waitMs(), &rxNs)) {
+            do {
+                handleFrame(frame, rxNs);
+            } while (inbox_.tryPop(frame, &rxNs));
+        }
+        handleTimeouts();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            break;
+        }
+    }
+
+    // Fail whatever is left so no caller waits forever
+    takeSubmitted();
+    for (std::map<int, std::deque<Transaction> >::iterator it = queues_.begin(); it != queues_.end(); ++it) {
+        while (!it->second.empty()) {
+            SdoResult result;
+            result.error = "SDO client closed";
+            it->second.front().callback(result);
+            it->second.pop_front();
+        }
+    }
+}
+
+void AsyncSdoClient::takeSubmitted() {
+    std::vector<Transaction> submitted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        submitted.swap(submitted_);
+    }
+
+    for (size_t i = 0; i < submitted.size(); i++) {
+        int nodeId = submitted[i].request.nodeId;
+        std::deque<Transaction>& queue = queues_[nodeId];
+        queue.push_back(submitted[i]);
+        if (queue.size() == 1) {
+            startNext(nodeId);
+        }
+    }
+}
+
+bool AsyncSdoClient::sendFrame(int nodeId, const uint8_t* data) {
+    struct can_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
+    frame.can_id = 0x600 + nodeId;
+    frame.can_dlc = 8;
+    std::memcpy(frame.data, data, 8);
+
+    uint64_t sentNs = realtimeNs();
+    if (::write(socket_, &frame, sizeof(frame)) != sizeof(frame)) {
+        return false;
+    }
+    if (txTap_ != NULL) {
+        txTap_->record(true, frame, sentNs);
+    }
+    std::deque<Transaction>& queue = queues_[nodeId];
+    if (!queue.empty()) {
+        Transaction& transaction = queue.front();
+        transaction.sent = Clock::now();
+        transaction.sentNs = sentNs;
+        transaction.deadline = transaction.sent + std::chrono::milliseconds(responseTimeoutMs(transaction));
+    }
+    return true;
+}
+
+// Reads and parameter writes are repeated on timeout, everything else gets one longer wait
+int AsyncSdoClient::responseTimeoutMs(const Transaction& transaction) const {
+    const SdoRequest& request = transaction.request;
+    if (request.timeoutMs > 0) {
+        return request.timeoutMs;
+    }
+    if (transaction.state != RAW && transaction.state != INITIATE) {
+        return timeouts_.patienceMs(request.nodeId, SdoTimeouts::REQUEST);  // Segments are never repeated
+    }
+    return transaction.slow ? timeouts_.policy().slowTimeoutMs
+         : transaction.attempts > 1 ? timeouts_.timeoutMs(request.nodeId, SdoTimeouts::REQUEST, transaction.attempt)
+         : timeouts_.patienceMs(request.nodeId, SdoTimeouts::REQUEST);
+}
+
+void AsyncSdoClient::startNext(int nodeId) {
+    std::deque<Transaction>& queue = queues_[nodeId];
+    if (!queue.empty()) {
+        // Take the node's responses over from whoever routes them, until its queue is empty again
+        if (subscribed_.insert(nodeId).second) {
+            session_->addFilter(nodeId, COB_SDO_RESPONSE);
+        }
+        session_->demux().claimSdoResponses(nodeId, &inbox_);
+
+        Transaction& transaction = queue.front();
+        const SdoRequest& request = transaction.request;
+
+        uint8_t* data = transaction.initiate;
+        std::memset(data, 0, 8);
+        if (transaction.state == RAW) {
+            std::memcpy(data, request.data.data(), 8);
+        } else {
+            data[1] = request.index & 0xFF;
+            data[2] = (request.index >> 8) & 0xFF;
+            data[3] = request.subindex;
+            if (request.upload) {
+                data[0] = 0x40;
+            } else if (request.data.size() <= 4 && !request.data.empty()) {
+                // Expedited download with size indicated
+                data[0] = 0x23 | ((4 - request.data.size()) << 2);
+                std::memcpy(&data[4], request.data.data(), request.data.size());
+            } else {
+                // Segmented download, the initiate carries the total size
+                uint32_t size = request.data.size();
+                data[0] = 0x21;
+                for (int i = 0; i < 4; i++) {
+                    data[4 + i] = (size >> (i * 8)) & 0xFF;
+                }
+            }
+        }
+        transaction.attempt = 0;
+        transaction.attempts = SdoTimeouts::isIdempotent(data) ? timeouts_.policy().maxRetries + 1 : 1;
+        transaction.slow = SdoTimeouts::isSlow(data);
+
+        if (!sendFrame(nodeId, data)) {
+            // complete() moves on to the next queued transaction
+            complete(nodeId, false, "error sending SDO request", 0);
+        }
+    }
+}
+
+void AsyncSdoClient::sendSegment(Transaction& transaction) {
+    const std::vector<uint8_t>& value = transaction.request.data;
+    size_t length = std::min(value.size() - transaction.offset, size_t(7));
+    bool last = transaction.offset + length == value.size();
+
+    uint8_t data[8] = {0};
+    data[0] = transaction.toggle | ((7 - length) << 1) | (last ? 0x01 : 0x00);
+    std::memcpy(&data[1], &value[transaction.offset], length);
+    transaction.offset += length;
+
+    if (!sendFrame(transaction.request.nodeId, data)) {
+        complete(transaction.request.nodeId, false, "error sending SDO segment", 0);
+    }
+}
+
+void AsyncSdoClient::handleFrame(const struct can_frame& frame, uint64_t rxNs) {
+    int nodeId = (frame.can_id & CAN_SFF_MASK) - 0x580;
+    std::map<int, std::deque<Transaction> >::iterator it = queues_.find(nodeId);
+    if (it == queues_.end() || it->second.empty()) {
+        return;  // Nobody waiting on this node
+    }
+
+    Transaction& transaction = it->second.front();
+    const SdoRequest& request = transaction.request;
+    uint8_t cs = frame.data[0];
+
+    // Initiate responses echo the multiplexer, use it to drop stale answers
+    bool muxMatches = (frame.data[1] | (frame.data[2] << 8)) == request.index && frame.data[3] == request.subindex;
+
+    // Initiate responses and aborts for another object are stale answers to an earlier transaction
+    if (!muxMatches && (transaction.state == RAW || transaction.state == INITIATE || cs == 0x80)) {
+        return;
+    }
+
+    // Karn: the answer to a repeated initiate cannot be matched to one send time
+    if (transaction.attempt == 0 && !transaction.slow) {
+        double rttMs = std::chrono::duration<double, std::milli>(Clock::now() - transaction.sent).count();
+        timeouts_.sample(nodeId, SdoTimeouts::REQUEST, rttMs);
+    }
+    if (tracer_ != NULL) {
+        // A kernel TX stamp older than our own send time belongs to an earlier frame
+        uint64_t txNs = session_->demux().lastTxTimestamp(0x600 + nodeId);
+        tracer_->record("sdo", nodeId, request.index, request.subindex,
+                        txNs < transaction.sentNs ? transaction.sentNs : txNs, rxNs);
+    }
+
+    // Raw callers inspect the response themselves, aborts included
+    if (transaction.state == RAW) {
+        transaction.result.data.assign(frame.data, frame.data + 8);
+        complete(nodeId, true, "", 0);
+        return;
+    }
+
+    if (cs == 0x80) {
+        uint32_t abortCode = frame.data[4] | (frame.data[5] << 8) | (frame.data[6] << 16) | (frame.data[7] << 24);
+        complete(nodeId, false, "aborted by node", abortCode);
+        return;
+    }
+
+    switch (transaction.state) {
+        case RAW:
+            return;
+
+        case INITIATE:
+            if (request.upload) {
+                if ((cs & 0xE0) != 0x40) {
+                    complete(nodeId, false, "unexpected upload response", ABORT_INVALID_CS);
+                    return;
+                }
+                if (cs & 0x02) {
+                    // Expedited: size in n if indicated, else 4 bytes
+                    size_t size = (cs & 0x01) ? 4 - ((cs >> 2) & 0x03) : 4;
+                    transaction.result.data.assign(&frame.data[4], &frame.data[4] + size);
+                    complete(nodeId, true, "", 0);
+                    return;
+                }
+                transaction.state = UPLOAD_SEGMENT;
+                transaction.attempt = 0;  // Segment round trips are sampled again
+                uint8_t data[8] = {0x60, 0, 0, 0, 0, 0, 0, 0};
+                if (!sendFrame(nodeId, data)) {
+                    complete(nodeId, false, "error sending SDO segment request", 0);
+                }
+                return;
+            }
+            if (cs != 0x60) {
+                complete(nodeId, false, "unexpected download response", ABORT_INVALID_CS);
+                return;
+            }
+            if (request.data.size() <= 4 && !request.data.empty()) {
+                complete(nodeId, true, "", 0);
+                return;
+            }
+            transaction.state = DOWNLOAD_SEGMENT;
+            transaction.attempt = 0;
+            sendSegment(transaction);
+            return;
+
+        case UPLOAD_SEGMENT: {
+            if ((cs & 0xE0) != 0x00 || (cs & 0x10) != transaction.toggle) {
+                complete(nodeId, false, "unexpected upload segment", ABORT_TOGGLE);
+                return;
+            }
+            size_t size = 7 - ((cs >> 1) & 0x07);
+            transaction.result.data.insert(transaction.result.data.end(), &frame.data[1], &frame.data[1] + size);
+            if (cs & 0x01) {
+                complete(nodeId, true, "", 0);
+                return;
+            }
+            transaction.toggle ^= 0x10;
+            uint8_t data[8] = {static_cast<uint8_t>(0x60 | transaction.toggle), 0, 0, 0, 0, 0, 0, 0};
+            if (!sendFrame(nodeId, data)) {
+                complete(nodeId, false, "error sending SDO segment request", 0);
+            }
+            return;
+        }
+
+        case DOWNLOAD_SEGMENT:
+            if ((cs & 0xEF) != 0x20 || (cs & 0x10) != transaction.toggle) {
+                complete(nodeId, false, "unexpected download segment response", ABORT_TOGGLE);
+                return;
+            }
+            if (transaction.offset == request.data.size()) {
+                complete(nodeId, true, "", 0);
+                return;
+            }
+            transaction.toggle ^= 0x10;
+            sendSegment(transaction);
+            return;
+    }
+}
+
+void AsyncSdoClient::handleTimeouts() {
+    Clock::time_point now = Clock::now();
+    for (std::map<int, std::deque<Transaction> >::iterator it = queues_.begin(); it != queues_.end(); ++it) {
+        if (!it->second.empty() && it->second.front().deadline <= now) {
+            Transaction& transaction = it->second.front();
+            const SdoRequest& request = transaction.request;
+
+            // An answer to an earlier attempt is as good as one to this attempt
+            bool initiate = transaction.state == RAW || transaction.state == INITIATE;
+            if (initiate && transaction.attempt + 1 < transaction.attempts) {
+                std::cerr << "No SDO response from node " << it->first << " within "
+                          << responseTimeoutMs(transaction) << " ms, retrying" << std::endl;
+                transaction.attempt++;
+                if (!sendFrame(it->first, transaction.initiate)) {
+                    complete(it->first, false, "error sending SDO request", 0);
+                }
+                continue;
+            }
+
+            // Tell the node we gave up so it does not stay in a segmented transfer
+            uint8_t data[8] = {
+                0x80, static_cast<uint8_t>(request.index & 0xFF), static_cast<uint8_t>((request.index >> 8) & 0xFF),
+                request.subindex, 0x00, 0x00, 0x04, 0x05
+            };
+            sendFrame(it->first, data);
+            complete(it->first, false, "timeout", ABORT_TIMEOUT);
+        }
+    }
+}
+
+// Until the earliest deadline of the transactions in flight
+int AsyncSdoClient::waitMs() const {
+    bool any = false;
+    Clock::time_point earliest;
+    for (std::map<int, std::deque<Transaction> >::const_iterator it = queues_.begin(); it != queues_.end(); ++it) {
+        if (!it->second.empty() && (!any || it->second.front().deadline < earliest)) {
+            earliest = it->second.front().deadline;
+            any = true;
+        }
+    }
+    if (!any) {
+        return IDLE_WAIT_MS;
+    }
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(earliest - Clock::now()).count() + 1;
+    return static_cast<int>(std::max(1LL, std::min(ms, static_cast<long long>(IDLE_WAIT_MS))));
+}
+
+void AsyncSdoClient::complete(int nodeId, bool success, const std::string& error, uint32_t abortCode) {
+    std::deque<Transaction>& queue = queues_[nodeId];
+    Transaction transaction = queue.front();
+    queue.pop_front();
+
+    transaction.result.success = success;
+    transaction.result.error = error;
+    transaction.result.abortCode = abortCode;
+    transaction.callback(transaction.result);
+
+    if (!queue.empty()) {
+        startNext(nodeId);
+    } else {
+        session_->demux().claimSdoResponses(nodeId, NULL);
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "bus_session.hpp"
+#include "sdo_timeout.hpp"
+#include <linux/can.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+class LatencyTracer;
+
+struct SdoRequest {
+    int nodeId;
+    bool upload;                // true: read from the node, false: write to it
+    uint16_t index;
+    uint8_t subindex;
+    std::vector<uint8_t> data;  // Value to write, expedited up to 4 bytes, segmented above
+    int timeoutMs;              // Wait per response, 0 follows the client's SdoTimeoutPolicy
+
+    SdoRequest() : nodeId(0), upload(true), index(0), subindex(0), timeoutMs(0) {}
+};
+
+struct SdoResult {
+    bool success;
+    uint32_t abortCode;         // Set when the node (or we, on timeout) aborted
+    std::vector<uint8_t> data;  // Uploaded value
+    std::string error;
+
+    SdoResult() : success(false), abortCode(0) {}
+};
+
+// Asynchronous SDO client. Runs an event loop on its own thread and keeps
+// one transaction in flight per server node, as CiA 301 allows, so
+// transactions to different nodes overlap on the bus. Requests to the same
+// node are queued and run in submission order. Requests go out on the bus
+// session's socket and the session's demux hands the responses of the nodes
+// in flight to the client, so recording and tracing see them like any other
+// SDO traffic. One client per bus. Callbacks run on the event loop thread
+// and must not block.
+class AsyncSdoClient {
+public:
+    typedef std::function<void(const SdoResult& result)> Callback;
+
+    AsyncSdoClient();
+    ~AsyncSdoClient();
+
+    // The inbox is cache line aligned, which plain new does not honour before C++17
+    static void* operator new(size_t size);
+    static void operator delete(void* pointer);
+
+    // Both take effect on the next open, as with CanInterface
+    void setTracer(LatencyTracer* tracer) { tracer_ = tracer; }
+    void setRecorder(FrameRecorder* recorder) { recorder_ = recorder; }
+    // Timeouts and retries as in CanInterface::sendSDOWithTimeout; set before open
+    void setSdoTimeoutPolicy(const SdoTimeoutPolicy& policy) { timeouts_.setPolicy(policy); }
+
+    // Attaches to the interface's bus session
+    bool open(const std::string& canInterface);
+    void close();
+
+    void submit(const SdoRequest& request, const Callback& callback);
+    std::future<SdoResult> submit(const SdoRequest& request);
+
+    std::future<SdoResult> read(int nodeId, uint16_t index, uint8_t subindex, int timeoutMs = 0);
+    std::future<SdoResult> write(int nodeId, uint16_t index, uint8_t subindex,
+                                 const uint8_t* data, size_t length, int timeoutMs = 0);
+
+    // Convenience for synchronous callers: send one expedited request, return the raw response
+    bool transact(int nodeId, const uint8_t* data, struct can_frame& response, int timeoutMs = 0);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    enum State {
+        INITIATE,          // Waiting for the initiate response
+        UPLOAD_SEGMENT,    // Waiting for an upload segment
+        DOWNLOAD_SEGMENT,  // Waiting for a download segment confirmation
+        RAW                // Raw request, any response completes it
+    };
+
+    struct Transaction {
+        SdoRequest request;
+        Callback callback;
+        State state;
+        Clock::time_point deadline;
+        Clock::time_point sent;    // Last frame of it went out, for the round trip
+        uint64_t sentNs;           // Host clock just before the last frame of it went out
+        uint8_t initiate[8];       // Initiate request, sent again on retries
+        int attempt;               // Of the initiate, 0 is the first try
+        int attempts;              // 1 unless the initiate is safe to repeat
+        bool slow;                 // Initiate the node answers only after writing flash
+        uint8_t toggle;
+        size_t offset;             // Bytes of request.data already sent
+        SdoResult result;
+    };
+
+    std::shared_ptr<BusSession> session_;
+    int socket_;                 // The session's socket
+    FrameQueue inbox_;           // Responses of the claimed nodes, filled by the session's demux
+    std::set<int> subscribed_;   // Nodes whose responses the session filter passes for us
+    LatencyTracer* tracer_;
+    FrameRecorder* recorder_;
+    FrameRecorder::Tap* txTap_;
+    SdoTimeouts timeouts_;       // Policy and round trip estimates per node
+    bool running_;
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::vector<Transaction> submitted_;  // Handed over from callers, guarded by mutex_
+
+    std::map<int, std::deque<Transaction> > queues_;  // Per node, front is in flight
+
+    void enqueue(const Transaction& transaction);
+    void run();
+    int waitMs() const;
+    void takeSubmitted();
+    void startNext(int nodeId);
+    void handleFrame(const struct can_frame& frame, uint64_t rxNs);
+    void handleTimeouts();
+    int responseTimeoutMs(const Transaction& transaction) const;
+    void complete(int nodeId, bool success, const std::string& error, uint32_t abortCode);
+    void sendSegment(Transaction& transaction);
+    bool sendFrame(int nodeId, const uint8_t* data);
+};
@@ -0,0 +1,70 @@
+#include "sdo_timeout.hpp"
+#include <algorithm>
+#include <cmath>
+
+static const double CLOCK_GRANULARITY_MS = 1.0;
+
+void SdoTimeouts::sample(int nodeId, Kind kind, double rttMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Estimate& estimate = estimates_[Key(nodeId, kind)];
+    if (!estimate.valid) {
+        estimate.srttMs = rttMs;
+        estimate.rttvarMs = rttMs / 2;
+        estimate.valid = true;
+        return;
+    }
+    estimate.rttvarMs = 0.75 * estimate.rttvarMs + 0.25 * std::fabs(estimate.srttMs - rttMs);
+    estimate.srttMs = 0.875 * estimate.srttMs + 0.125 * rttMs;
+}
+
+double SdoTimeouts::baseTimeoutMs(int nodeId, Kind kind) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<Key, Estimate>::const_iterator it = estimates_.find(Key(nodeId, kind));
+    if (it == estimates_.end() || !it->second.valid) {
+        return policy_.initialTimeoutMs;
+    }
+    double rto = it->second.srttMs + std::max(CLOCK_GRANULARITY_MS, 4 * it->second.rttvarMs);
+    return std::max(rto, static_cast<double>(policy_.minTimeoutMs));
+}
+
+int SdoTimeouts::timeoutMs(int nodeId, Kind kind, int attempt) const {
+    double timeout = baseTimeoutMs(nodeId, kind) * std::pow(policy_.backoff, attempt);
+    return static_cast<int>(std::ceil(std::min(timeout, static_cast<double>(policy_.maxTimeoutMs))));
+}
+
+int SdoTimeouts::patienceMs(int nodeId, Kind kind) const {
+    int total = 0;
+    for (int attempt = 0; attempt <= policy_.maxRetries; attempt++) {
+        total += timeoutMs(nodeId, kind, attempt);
+    }
+    return std::min(total, policy_.maxTimeoutMs);
+}
+
+// Objects whose writes trigger an action rather than set a value
+static bool isCommandObject(uint16_t index) {
+    return index == 0x1010 ||  // Store parameters
+           index == 0x1011 ||  // Restore default parameters
+           index == 0x1F51 ||  // Program control
+           index == 0x4040 ||  // ESDO, enter the bootloader
+           index == 0x6040;    // Controlword
+}
+
+bool SdoTimeouts::isIdempotent(const uint8_t* request) {
+    uint8_t cs = request[0];
+    uint16_t index = request[1] | (request[2] << 8);
+    if ((cs & 0xE0) == 0x40) {  // Upload initiate
+        return true;
+    }
+    // Expedited download
+    return (cs & 0xE2) == 0x22 && !isCommandObject(index);
+}
+
+bool SdoTimeouts::isSlow(const uint8_t* request) {
+    uint8_t cs = request[0];
+    uint16_t index = request[1] | (request[2] << 8);
+    if ((cs & 0xE0) == 0x20) {
+        return index == 0x1010 || index == 0x1011 || index == 0x4040;
+    }
+    return (cs & 0xE1) == 0xC0 ||  // Block download initiate, the bootloader may erase first
+           (cs & 0xE3) == 0xC1;    // Block download end, checked against the flash
+}
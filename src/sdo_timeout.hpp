@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+
+// How long to wait for SDO responses and how often to ask again
+struct SdoTimeoutPolicy {
+    int initialTimeoutMs;   // Until the first round trip to a node was measured
+    int minTimeoutMs;       // Floor for the measured timeout
+    int maxTimeoutMs;       // Ceiling for one attempt, backoff included
+    int slowTimeoutMs;      // Store, bootloader entry and block download initiate/end touch flash
+    int maxRetries;         // Extra attempts for requests that are safe to repeat
+    double backoff;         // Timeout multiplier per retry
+
+    SdoTimeoutPolicy()
+        : initialTimeoutMs(250), minTimeoutMs(50), maxTimeoutMs(2000), slowTimeoutMs(2000), maxRetries(2), backoff(2.0) {}
+};
+
+// Round trip estimator per node as in TCP (RFC 6298): the timeout follows
+// the smoothed RTT plus four times its mean deviation. Only answers to a
+// first attempt are sampled, a retried request's answer is ambiguous.
+class SdoTimeouts {
+public:
+    enum Kind {
+        REQUEST,    // Request/response transactions
+        BLOCK_ACK   // End of a sub-block to its acknowledge
+    };
+
+    SdoTimeouts() {}
+    explicit SdoTimeouts(const SdoTimeoutPolicy& policy) : policy_(policy) {}
+
+    void setPolicy(const SdoTimeoutPolicy& policy) { policy_ = policy; }
+    const SdoTimeoutPolicy& policy() const { return policy_; }
+
+    void sample(int nodeId, Kind kind, double rttMs);
+    // Timeout of one attempt, attempt 0 is the first try
+    int timeoutMs(int nodeId, Kind kind, int attempt) const;
+    // Total wait for requests that must not be repeated: as long as all attempts of a retried one
+    int patienceMs(int nodeId, Kind kind) const;
+
+    // Reads and plain parameter writes; segments and commands must not be sent twice
+    static bool isIdempotent(const uint8_t* request);
+    // Requests the server answers only after writing flash
+    static bool isSlow(const uint8_t* request);
+
+private:
+    struct Estimate {
+        double srttMs;
+        double rttvarMs;
+        bool valid;
+
+        Estimate() : srttMs(0), rttvarMs(0), valid(false) {}
+    };
+    typedef std::pair<int, Kind> Key;
+
+    SdoTimeoutPolicy policy_;
+    std::map<Key, Estimate> estimates_;
+    mutable std::mutex mutex_;
+
+    double baseTimeoutMs(int nodeId, Kind kind) const;
+};
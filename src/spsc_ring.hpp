@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free single-producer/single-consumer ring buffer.
+// Capacity must be a power of two; one slot is never used.
+template <typename T, size_t Capacity>
+class SpscRing {
+public:
+    SpscRing() : head_(0), tail_(0) {}
+
+    // Producer side. Returns false when the ring is full.
+    bool push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & (Capacity - 1);
+        if (next == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        items_[head] = item;
+        head_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when the ring is empty.
+    bool pop(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items_[tail];
+        tail_.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+private:
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    T items_[Capacity];
+    // Keep producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
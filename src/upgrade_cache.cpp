@@ -0,0 +1,83 @@
+#include "upgrade_cache.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+UpgradeCache::UpgradeCache(const std::string& path) : path_(path) {}
+
+std::string UpgradeCache::defaultPath() {
+    const char* home = getenv("HOME");
+    return std::string(home ? home : ".") + "/.canopenCommand_upgrade.cache";
+}
+
+bool UpgradeCache::load() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+
+    std::ifstream file(path_);
+    if (!file) {
+        return true;  // No cache yet
+    }
+
+    // <node> <serial> <size> <crc> <hardware version> <software version (rest of line)>
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        UpgradeCacheEntry entry;
+        unsigned int crc;
+        if (!(fields >> entry.nodeId >> std::hex >> entry.serialNumber >> std::dec >> entry.imageSize
+                    >> std::hex >> crc >> std::dec >> entry.hardwareVersion)) {
+            continue;
+        }
+        entry.imageCrc = static_cast<uint16_t>(crc);
+        std::getline(fields >> std::ws, entry.softwareVersion);
+        entries_[Key(entry.nodeId, entry.serialNumber)] = entry;
+    }
+    return true;
+}
+
+bool UpgradeCache::lookup(int nodeId, uint32_t serialNumber, UpgradeCacheEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<Key, UpgradeCacheEntry>::const_iterator it = entries_.find(Key(nodeId, serialNumber));
+    if (it == entries_.end()) {
+        return false;
+    }
+    entry = it->second;
+    return true;
+}
+
+bool UpgradeCache::store(const UpgradeCacheEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[Key(entry.nodeId, entry.serialNumber)] = entry;
+    return save();
+}
+
+bool UpgradeCache::save() {
+    // Write a temporary file and rename it so an interrupted run never truncates the cache
+    std::string tmpPath = path_ + ".tmp";
+    {
+        std::ofstream file(tmpPath.c_str(), std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error writing upgrade cache: " << tmpPath << std::endl;
+            return false;
+        }
+        for (std::map<Key, UpgradeCacheEntry>::const_iterator it = entries_.begin(); it != entries_.end(); ++it) {
+            const UpgradeCacheEntry& entry = it->second;
+            file << std::dec << entry.nodeId << " " << std::hex << entry.serialNumber << " "
+                 << std::dec << entry.imageSize << " " << std::hex << entry.imageCrc << " "
+                 << entry.hardwareVersion << " " << entry.softwareVersion << "\n";
+        }
+        if (!file) {
+            std::cerr << "Error writing upgrade cache: " << tmpPath << std::endl;
+            return false;
+        }
+    }
+
+    if (rename(tmpPath.c_str(), path_.c_str()) != 0) {
+        std::cerr << "Error replacing upgrade cache: " << path_ << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// What was last flashed on a node, keyed by node ID and serial number
+struct UpgradeCacheEntry {
+    int nodeId;
+    uint32_t serialNumber;
+    size_t imageSize;
+    uint16_t imageCrc;
+    std::string hardwareVersion;  // From the image footer
+    std::string softwareVersion;  // 0x100A as reported after flashing
+
+    UpgradeCacheEntry() : nodeId(0), serialNumber(0), imageSize(0), imageCrc(0) {}
+};
+
+// Local text file remembering flashed images, safe to share between fleet workers
+class UpgradeCache {
+public:
+    UpgradeCache(const std::string& path);
+
+    bool load();
+    bool lookup(int nodeId, uint32_t serialNumber, UpgradeCacheEntry& entry);
+    bool store(const UpgradeCacheEntry& entry);
+
+    static std::string defaultPath();
+
+private:
+    typedef std::pair<int, uint32_t> Key;
+
+    std::string path_;
+    std::map<Key, UpgradeCacheEntry> entries_;
+    std::mutex mutex_;
+
+    bool save();
+};
@@ -0,0 +1,224 @@
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+
+// Generates constexpr object descriptors (see src/od_types.hpp) from EDS files.
+// Usage: od_gen <output_header> <eds_file>...
+// Later files add to and override earlier ones.
+
+struct Section {
+    std::string name;
+    unsigned int objectType;
+    unsigned int dataType;
+    std::string access;
+    bool hasDataType;
+
+    Section() : objectType(0x7), dataType(0), hasDataType(false) {}
+};
+
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+// "CAN bit rate" -> "CANBitRate", "1st object" -> "Object1stObject"
+static std::string identifier(const std::string& name) {
+    std::string result;
+    bool wordStart = true;
+    for (size_t i = 0; i < name.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(name[i]);
+        if (!std::isalnum(c)) {
+            wordStart = true;
+            continue;
+        }
+        result += wordStart ? static_cast<char>(std::toupper(c)) : static_cast<char>(c);
+        wordStart = false;
+    }
+    if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0]))) {
+        result = "Object" + result;
+    }
+    return result;
+}
+
+static const char* accessName(const std::string& access) {
+    if (access == "const") {
+        return "CONST";
+    }
+    if (access == "wo") {
+        return "WO";
+    }
+    if (access == "rw" || access == "rww" || access == "rwr") {
+        return "RW";
+    }
+    return "RO";
+}
+
+// Unique within one scope, clashes get the object's address appended
+static std::string uniqueName(const std::string& name, unsigned int suffix, std::set<std::string>& used) {
+    std::string result = name;
+    if (used.count(result)) {
+        std::ostringstream alternative;
+        alternative << name << "_" << std::hex << std::uppercase << suffix;
+        result = alternative.str();
+    }
+    used.insert(result);
+    return result;
+}
+
+// Plain "[1018]" sections by index, "[1018sub1]" sections by index << 8 | subindex
+struct Sections {
+    std::map<unsigned int, Section> mains;
+    std::map<unsigned int, Section> subs;
+    std::set<unsigned int> indices;
+};
+
+static bool parseEds(const std::string& path, Sections& sections) {
+    std::ifstream file(path.c_str());
+    if (!file) {
+        std::cerr << "Error opening EDS file: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    Section* current = NULL;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == ';') {
+            continue;
+        }
+        if (line[0] == '[') {
+            std::string name = line.substr(1, line.find(']') - 1);
+            char* end = NULL;
+            unsigned long index = std::strtoul(name.c_str(), &end, 16);
+            current = NULL;
+            if (end == name.c_str() + 4 && *end == '\0') {
+                current = &sections.mains[index];
+            } else if (end == name.c_str() + 4 && std::strncmp(end, "sub", 3) == 0) {
+                current = &sections.subs[(index << 8) | (std::strtoul(end + 3, NULL, 16) & 0xFF)];
+            }
+            if (current != NULL) {
+                *current = Section();
+                sections.indices.insert(index);
+            }
+            continue;
+        }
+        size_t equals = line.find('=');
+        if (current == NULL || equals == std::string::npos) {
+            continue;
+        }
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        if (key == "ParameterName") {
+            current->name = value;
+        } else if (key == "ObjectType") {
+            current->objectType = std::strtoul(value.c_str(), NULL, 0);
+        } else if (key == "DataType") {
+            current->dataType = std::strtoul(value.c_str(), NULL, 0);
+            current->hasDataType = true;
+        } else if (key == "AccessType") {
+            current->access = value;
+        }
+    }
+    return true;
+}
+
+static void writeObject(std::ostream& out, const std::string& name, unsigned int index,
+                        unsigned int subindex, const Section& section) {
+    out << "constexpr Object<0x" << std::setw(4) << index << ", 0x" << std::setw(2) << subindex
+        << ", 0x" << std::setw(4) << section.dataType << ", " << accessName(section.access) << "> "
+        << name << "{};  // " << section.name << "\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output_header> <eds_file>..." << std::endl;
+        return 1;
+    }
+
+    Sections sections;
+    std::string sources;
+    for (int i = 2; i < argc; i++) {
+        if (!parseEds(argv[i], sections)) {
+            return 1;
+        }
+        const char* base = std::strrchr(argv[i], '/');
+        sources += std::string(i > 2 ? " " : "") + (base != NULL ? base + 1 : argv[i]);
+    }
+
+    std::ostringstream out;
+    out << std::hex << std::uppercase << std::setfill('0');
+    out << "// Generated by od_gen from " << sources << ", do not edit\n";
+    out << "#pragma once\n\n#include \"od_types.hpp\"\n\nnamespace od {\n";
+
+    std::set<std::string> topLevel;
+    size_t objects = 0;
+    for (std::set<unsigned int>::const_iterator it = sections.indices.begin(); it != sections.indices.end(); ++it) {
+        unsigned int index = *it;
+        std::map<unsigned int, Section>::const_iterator main = sections.mains.find(index);
+        std::map<unsigned int, Section>::const_iterator sub = sections.subs.lower_bound(index << 8);
+        std::map<unsigned int, Section>::const_iterator subEnd = sections.subs.lower_bound((index + 1) << 8);
+
+        // Records and arrays become a namespace holding their subindices
+        if (main != sections.mains.end() && !main->second.hasDataType &&
+            (main->second.objectType == 0x8 || main->second.objectType == 0x9)) {
+            out << "\nnamespace " << uniqueName(identifier(main->second.name), index, topLevel) << " {  // 0x"
+                << std::setw(4) << index << "\n";
+            out << "constexpr uint16_t INDEX = 0x" << std::setw(4) << index << ";\n";
+            std::set<std::string> inRecord;
+            for (; sub != subEnd; ++sub) {
+                if (sub->second.hasDataType) {
+                    unsigned int subindex = sub->first & 0xFF;
+                    writeObject(out, uniqueName(identifier(sub->second.name), subindex, inRecord), index, subindex,
+                                sub->second);
+                    objects++;
+                }
+            }
+            out << "}\n";
+            continue;
+        }
+
+        // A VAR, possibly with extra subindices that keep their own names
+        bool mainVar = main != sections.mains.end() && main->second.hasDataType;
+        if (mainVar) {
+            writeObject(out, uniqueName(identifier(main->second.name), index << 8, topLevel), index, 0, main->second);
+            objects++;
+        }
+        for (; sub != subEnd; ++sub) {
+            unsigned int subindex = sub->first & 0xFF;
+            if (sub->second.hasDataType && !(mainVar && subindex == 0)) {
+                writeObject(out, uniqueName(identifier(sub->second.name), sub->first, topLevel), index, subindex,
+                            sub->second);
+                objects++;
+            }
+        }
+    }
+    out << "\n}  // namespace od\n";
+
+    // Leave the header untouched when nothing changed so dependents are not rebuilt
+    std::string header = out.str();
+    std::ifstream existing(argv[1]);
+    std::stringstream previous;
+    previous << existing.rdbuf();
+    if (existing && previous.str() == header) {
+        return 0;
+    }
+    std::ofstream file(argv[1], std::ios::trunc);
+    file << header;
+    if (!file) {
+        std::cerr << "Error writing " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cout << "Generated " << objects << " objects into " << argv[1] << std::endl;
+    return 0;
+}